@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""
+Reference encoder for the binary detection message format (version 1).
+
+The object_detection plugin accepts this format on the same MQTT topic as the JSON one
+(vms/ai/detections/<cameraId>) and tells them apart by the magic header, so publishers can be
+switched one camera at a time.
+
+Layout, all integers little-endian:
+
+    offset  size  field
+    0       4     magic "NXDB"
+    4       1     version, 1
+    5       1     flags; bit 0: frame timestamp present, bit 1: publish time present
+    6       1     dictionary entry count (at most 255)
+    7       1     reserved, 0
+    8       2     record count
+    10      2     track epoch: publisher-defined scope of the trackId values, e.g. a counter
+                  incremented on every detector restart; 0 if unused
+    12      8     frame timestamp in microseconds (int64), only if flags bit 0 is set
+    ...     8     publish time in microseconds since the epoch (int64), only if flags bit 1 is
+                  set; lets the plugin measure the latency from the publisher
+    ...           dictionary: per entry, uint8 byte length + UTF-8 bytes
+    ...           records, 16 bytes each:
+                      0   uint16 x           normalized 0..1 as 0..65535
+                      2   uint16 y
+                      4   uint16 width
+                      6   uint16 height
+                      8   uint16 confidence  0..1 as 0..65535
+                      10  uint8  label index in the dictionary, 255 = no label
+                      11  uint8  name index in the dictionary, 255 = no name
+                      12  int32  trackId
+
+Run this script to check the encoder against the test vector, which is also documented in
+detection_binary_format.h; tools/detection_binary_format_check.cpp checks the C++ decoder against
+the same vector.
+"""
+
+import struct
+import sys
+
+MAGIC = b"NXDB"
+VERSION = 1
+FLAG_HAS_TIMESTAMP = 0x01
+FLAG_HAS_PUBLISH_TIME = 0x02
+NO_STRING = 0xFF
+
+HEADER = struct.Struct("<4sBBBBHH")
+TIMESTAMP = struct.Struct("<q")
+RECORD = struct.Struct("<HHHHHBBi")
+
+TEST_VECTOR_DETECTIONS = [
+    {"label": "person", "confidence": 0.9, "bbox": [0.1, 0.2, 0.3, 0.4], "trackId": 7,
+        "name": "Alice"},
+    {"label": "car", "confidence": 0.5, "bbox": [0.5, 0.5, 0.25, 0.25], "trackId": 8},
+]
+TEST_VECTOR_TIMESTAMP_US = 1700000000000000
+TEST_VECTOR_HEX = (
+    "4e584442010103000200000000401e18240a060006706572736f6e05416c69636503636172"
+    "9a193333cd4c666666e60001070000000080008000400040008002ff08000000")
+
+
+def quantize(value):
+    """Maps 0..1 to 0..65535; values out of range are clamped."""
+    return int(min(max(float(value), 0.0), 1.0) * 65535 + 0.5)
+
+
+def encode(detections, timestamp_us=None, track_epoch=0, publish_time_us=None):
+    """
+    Encodes detections given in the JSON message schema:
+    [{"label", "confidence", "bbox": [x, y, width, height], "trackId", "name"}].
+    """
+    dictionary = []
+    index_by_string = {}
+
+    def string_index(value):
+        if not value:
+            return NO_STRING
+        if value not in index_by_string:
+            if len(dictionary) == NO_STRING:
+                raise ValueError("More than 255 distinct labels and names in one message")
+            encoded = value.encode("utf-8")
+            if len(encoded) > 255:
+                raise ValueError(f"String is longer than 255 bytes: {value!r}")
+            index_by_string[value] = len(dictionary)
+            dictionary.append(encoded)
+        return index_by_string[value]
+
+    records = []
+    for detection in detections:
+        x, y, width, height = detection["bbox"][:4]
+        records.append(RECORD.pack(
+            quantize(x), quantize(y), quantize(width), quantize(height),
+            quantize(detection.get("confidence", 0.0)),
+            string_index(detection.get("label", "")),
+            string_index(detection.get("name", "")),
+            int(detection.get("trackId", 0))))
+
+    flags = FLAG_HAS_TIMESTAMP if timestamp_us is not None else 0
+    if publish_time_us is not None:
+        flags |= FLAG_HAS_PUBLISH_TIME
+    message = HEADER.pack(
+        MAGIC, VERSION, flags, len(dictionary), 0, len(records), track_epoch & 0xFFFF)
+    if timestamp_us is not None:
+        message += TIMESTAMP.pack(timestamp_us)
+    if publish_time_us is not None:
+        message += TIMESTAMP.pack(publish_time_us)
+    for entry in dictionary:
+        message += bytes([len(entry)]) + entry
+    return message + b"".join(records)
+
+
+def decode(message):
+    """
+    Inverse of encode(); returns (detections, timestamp_us or None, track_epoch,
+    publish_time_us or None).
+    """
+    magic, version, flags, dictionary_size, _, record_count, track_epoch = HEADER.unpack_from(
+        message)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("Not a version 1 binary detection message")
+    offset = HEADER.size
+
+    timestamp_us = None
+    if flags & FLAG_HAS_TIMESTAMP:
+        (timestamp_us,) = TIMESTAMP.unpack_from(message, offset)
+        offset += TIMESTAMP.size
+
+    publish_time_us = None
+    if flags & FLAG_HAS_PUBLISH_TIME:
+        (publish_time_us,) = TIMESTAMP.unpack_from(message, offset)
+        offset += TIMESTAMP.size
+
+    dictionary = []
+    for _ in range(dictionary_size):
+        length = message[offset]
+        dictionary.append(message[offset + 1:offset + 1 + length].decode("utf-8"))
+        offset += 1 + length
+
+    detections = []
+    for _ in range(record_count):
+        x, y, width, height, confidence, label, name, track_id = RECORD.unpack_from(
+            message, offset)
+        offset += RECORD.size
+        detection = {
+            "label": dictionary[label] if label != NO_STRING else "",
+            "confidence": confidence / 65535,
+            "bbox": [x / 65535, y / 65535, width / 65535, height / 65535],
+            "trackId": track_id,
+        }
+        if name != NO_STRING:
+            detection["name"] = dictionary[name]
+        detections.append(detection)
+
+    return detections, timestamp_us, track_epoch, publish_time_us
+
+
+def check_test_vector():
+    encoded = encode(TEST_VECTOR_DETECTIONS, TEST_VECTOR_TIMESTAMP_US)
+    if encoded.hex() != TEST_VECTOR_HEX:
+        print(f"Test vector mismatch:\n  expected {TEST_VECTOR_HEX}\n  actual   {encoded.hex()}")
+        return False
+
+    detections, timestamp_us, _, _ = decode(encoded)
+    if timestamp_us != TEST_VECTOR_TIMESTAMP_US or len(detections) != 2:
+        print("Decoded test vector differs from the encoded detections")
+        return False
+
+    print(f"Test vector OK ({len(encoded)} bytes)")
+    return True
+
+
+if __name__ == "__main__":
+    sys.exit(0 if check_test_vector() else 1)
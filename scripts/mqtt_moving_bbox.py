@@ -4,13 +4,22 @@ import paho.mqtt.client as mqtt
 import json
 import time
 import math
+import sys
 from uuid import uuid4
 
+from detection_codec import encode as encode_binary
+
 BROKER = "192.168.1.215"
 PORT = 1883
 CAMERA_ID = "742b49df-51af-29e2-75e5-d179f1b2d74d"
 TOPIC = f"vms/ai/detections/{CAMERA_ID}"
 
+# Pass --binary to publish the compact binary format instead of JSON (see detection_codec.py)
+USE_BINARY = "--binary" in sys.argv[1:]
+
+# Pass --qos1 to publish at QoS 1, so that the plugin's persistent session replays what it missed
+QOS = 1 if "--qos1" in sys.argv[1:] else 0
+
 # Simulating fake generation constants
 TRACK_LENGTH = 100
 BBOX_WIDTH = 0.15
@@ -27,6 +36,13 @@ def calculate_y_position(frame_index):
     y = max(0.0, 1.0 - BBOX_HEIGHT - progress)
     return y
 
+def make_payload(detections):
+    # Lets the plugin measure the latency from here when its latency tracing is enabled
+    publish_time_us = time.time_ns() // 1000
+    if USE_BINARY:
+        return encode_binary(detections["detections"], publish_time_us=publish_time_us)
+    return json.dumps({**detections, "publishTimeUs": publish_time_us})
+
 def send_moving_detections():
     """Send moving bounding boxes like fake generation"""
     
@@ -35,6 +51,7 @@ def send_moving_detections():
     print("="*80)
     print(f"Broker: {BROKER}:{PORT}")
     print(f"Topic:  {TOPIC}")
+    print(f"Format: {'binary' if USE_BINARY else 'JSON'}")
     print("\n📊 Simulation:")
     print("   - 2 objects: Person (left), Car (right)")
     print("   - Moving from BOTTOM to TOP")
@@ -90,7 +107,7 @@ def send_moving_detections():
             }
             
             # Publish
-            result = client.publish(TOPIC, json.dumps(detections), qos=0)
+            result = client.publish(TOPIC, make_payload(detections), qos=QOS)
             result.wait_for_publish()
             
             # Print status every 10 frames
@@ -110,7 +127,7 @@ def send_moving_detections():
         # Send EMPTY detections to clear bboxes in VMS
         print("🧹 Clearing bboxes...")
         empty_detections = {"detections": []}
-        client.publish(TOPIC, json.dumps(empty_detections), qos=0).wait_for_publish()
+        client.publish(TOPIC, make_payload(empty_detections), qos=QOS).wait_for_publish()
         time.sleep(0.2)
     
     finally:
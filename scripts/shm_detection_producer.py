@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""
+Test producer for the shared memory detection transport of the object_detection plugin.
+
+Creates the ring /nx_detections_<CAMERA_ID> (see shm_detection_reader.h for the layout) and
+publishes moving bounding boxes into it in the binary detection format. Select "Shared memory"
+as the "Detection transport" in the camera's plugin settings to receive them.
+
+Usage: shm_detection_producer.py [CAMERA_ID]
+"""
+
+import struct
+import sys
+import time
+from multiprocessing import shared_memory
+
+from detection_codec import encode
+
+CAMERA_ID = sys.argv[1] if len(sys.argv) > 1 else "742b49df-51af-29e2-75e5-d179f1b2d74d"
+SEGMENT_NAME = f"nx_detections_{CAMERA_ID}"  # Python adds the leading "/".
+
+MAGIC = b"NXDR"
+VERSION = 1
+SLOT_COUNT = 64
+SLOT_SIZE = 4096  # Including the 16-byte slot header.
+WRITE_INDEX_OFFSET = 64
+SLOTS_OFFSET = 128
+SLOT_HEADER_SIZE = 16
+
+FPS = 25
+TRACK_LENGTH = 100
+
+
+class DetectionRing:
+    def __init__(self, name):
+        try:
+            # Remove a segment left over by a crashed producer, so the reader sees a new one.
+            shared_memory.SharedMemory(name=name).unlink()
+        except FileNotFoundError:
+            pass
+
+        self.memory = shared_memory.SharedMemory(
+            name=name, create=True, size=SLOTS_OFFSET + SLOT_COUNT * SLOT_SIZE)
+        self.buffer = self.memory.buf
+        self.write_index = 0
+        struct.pack_into("<4sIII", self.buffer, 0, MAGIC, VERSION, SLOT_COUNT, SLOT_SIZE)
+        struct.pack_into("<Q", self.buffer, WRITE_INDEX_OFFSET, 0)
+
+    def publish(self, payload):
+        if len(payload) > SLOT_SIZE - SLOT_HEADER_SIZE:
+            raise ValueError(f"Message of {len(payload)} bytes does not fit into a slot")
+
+        index = self.write_index
+        slot = SLOTS_OFFSET + (index % SLOT_COUNT) * SLOT_SIZE
+        # Aligned 8-byte stores; the order below is the protocol the reader relies on.
+        struct.pack_into("<Q", self.buffer, slot, 2 * index + 1)
+        struct.pack_into("<I", self.buffer, slot + 8, len(payload))
+        self.buffer[slot + SLOT_HEADER_SIZE:slot + SLOT_HEADER_SIZE + len(payload)] = payload
+        struct.pack_into("<Q", self.buffer, slot, 2 * index + 2)
+        self.write_index = index + 1
+        struct.pack_into("<Q", self.buffer, WRITE_INDEX_OFFSET, self.write_index)
+
+    def close(self):
+        self.buffer = None
+        self.memory.close()
+        self.memory.unlink()
+
+
+def main():
+    ring = DetectionRing(SEGMENT_NAME)
+    print(f"Publishing to /{SEGMENT_NAME} at {FPS} FPS, press Ctrl+C to stop")
+
+    frame_index = 0
+    try:
+        while True:
+            progress = (frame_index % TRACK_LENGTH) / TRACK_LENGTH
+            detections = [
+                {"label": "person", "confidence": 0.95,
+                    "bbox": [0.15, max(0.0, 0.85 - progress), 0.15, 0.15], "trackId": 1},
+                {"label": "car", "confidence": 0.90,
+                    "bbox": [0.70, max(0.0, 0.85 - progress), 0.15, 0.15], "trackId": 2},
+            ]
+            ring.publish(encode(detections, publish_time_us=time.time_ns() // 1000))
+
+            frame_index += 1
+            time.sleep(1.0 / FPS)
+    except KeyboardInterrupt:
+        ring.publish(encode([]))  # Clear the boxes in VMS.
+    finally:
+        ring.close()
+
+    print(f"Published {frame_index} messages")
+
+
+if __name__ == "__main__":
+    main()
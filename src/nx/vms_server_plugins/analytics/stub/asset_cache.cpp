@@ -0,0 +1,128 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "asset_cache.h"
+
+#include <fstream>
+
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+
+AssetCache::Asset::~Asset()
+{
+    #if !defined(_WIN32)
+        if (m_mapping)
+            munmap(m_mapping, m_size);
+    #endif
+}
+
+AssetCache::AssetCache(size_t byteBudget):
+    m_byteBudget(byteBudget)
+{
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    m_cachedBytesMetric = registry.gauge("stub_asset_cache_bytes",
+        "Size of the best shot image files kept by the asset cache.");
+    m_hitsMetric = registry.counter("stub_asset_cache_hits_total",
+        "Best shot image loads served by the asset cache.");
+    m_readsMetric = registry.counter("stub_asset_cache_reads_total",
+        "Best shot image files read from the disk by the asset cache.");
+}
+
+AssetCache& AssetCache::instance()
+{
+    static AssetCache cache(kDefaultByteBudget);
+    return cache;
+}
+
+std::shared_ptr<const AssetCache::Asset> AssetCache::loadAsset(
+    const std::string& path, size_t size)
+{
+    std::shared_ptr<Asset> asset(new Asset());
+
+    #if !defined(_WIN32)
+        if (size > 0)
+        {
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return nullptr;
+
+            void* const mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (mapping != MAP_FAILED)
+            {
+                asset->m_mapping = mapping;
+                asset->m_data = (const char*) mapping;
+                asset->m_size = size;
+                return asset;
+            }
+        }
+    #endif
+
+    // Read in a single call rather than with a stream iterator, which goes byte by byte.
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return nullptr;
+    asset->m_bytes.resize(size);
+    if (!file.read(asset->m_bytes.data(), (std::streamsize) size))
+        return nullptr;
+    asset->m_data = asset->m_bytes.data();
+    asset->m_size = size;
+    return asset;
+}
+
+void AssetCache::evict(std::map<std::string, Entry>::iterator entry)
+{
+    m_cachedByteCount -= entry->second.asset->size();
+    m_cachedBytesMetric->set((int64_t) m_cachedByteCount);
+    m_recentPaths.erase(entry->second.recentPathsPosition);
+    m_entries.erase(entry);
+}
+
+std::shared_ptr<const AssetCache::Asset> AssetCache::load(const std::string& path)
+{
+    const FileStatus status = fileStatus(path);
+
+    const std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto entry = m_entries.find(path);
+    if (entry != m_entries.end())
+    {
+        if (entry->second.fileStatus == status)
+        {
+            m_recentPaths.splice(
+                m_recentPaths.begin(), m_recentPaths, entry->second.recentPathsPosition);
+            m_hitsMetric->add();
+            return entry->second.asset;
+        }
+        evict(entry);
+    }
+
+    if (status.size < 0)
+        return nullptr;
+
+    const std::shared_ptr<const Asset> asset = loadAsset(path, (size_t) status.size);
+    m_readsMetric->add();
+    if (!asset || asset->size() > m_byteBudget)
+        return asset;
+
+    while (m_cachedByteCount + asset->size() > m_byteBudget)
+        evict(m_entries.find(m_recentPaths.back()));
+
+    m_recentPaths.push_front(path);
+    m_entries[path] = Entry{status, asset, m_recentPaths.begin()};
+    m_cachedByteCount += asset->size();
+    m_cachedBytesMetric->set((int64_t) m_cachedByteCount);
+    return asset;
+}
+
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,98 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "metrics.h"
+#include "utils.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+
+/**
+ * Process-wide cache of the files sent as best shot images, so that the image of an entry played
+ * over and over, or used by many DeviceAgents, is read from the disk once.
+ *
+ * Files are memory-mapped, and shared by reference counting: an asset stays valid for as long as
+ * it is held, even after it has been evicted or its file has changed. The cache keeps the most
+ * recently used assets within a byte budget; a file larger than the budget is loaded, but not
+ * kept. An entry is checked against the size and the modification time of its file on every
+ * load, so a changed file is loaded again. Files must be replaced rather than rewritten in place
+ * while they are in use, as truncating a mapped file makes its pages inaccessible.
+ *
+ * Thread-safe.
+ */
+class AssetCache
+{
+public:
+    static constexpr size_t kDefaultByteBudget = 64 * 1024 * 1024;
+
+    /** Immutable contents of a file. */
+    class Asset
+    {
+    public:
+        ~Asset();
+
+        Asset(const Asset&) = delete;
+        Asset& operator=(const Asset&) = delete;
+
+        const char* data() const { return m_data; }
+        size_t size() const { return m_size; }
+
+        /** Copy for the APIs taking the data by value, e.g. setImageData(). */
+        std::vector<char> toVector() const { return std::vector<char>(m_data, m_data + m_size); }
+
+    private:
+        friend class AssetCache;
+        Asset() = default;
+
+    private:
+        const char* m_data = nullptr;
+        size_t m_size = 0;
+        void* m_mapping = nullptr; //< Null if the contents are held in m_bytes.
+        std::vector<char> m_bytes;
+    };
+
+    explicit AssetCache(size_t byteBudget);
+
+    static AssetCache& instance();
+
+    /** @return Null if the file cannot be read. */
+    std::shared_ptr<const Asset> load(const std::string& path);
+
+private:
+    struct Entry
+    {
+        FileStatus fileStatus;
+        std::shared_ptr<const Asset> asset;
+        std::list<std::string>::iterator recentPathsPosition;
+    };
+
+    static std::shared_ptr<const Asset> loadAsset(const std::string& path, size_t size);
+    void evict(std::map<std::string, Entry>::iterator entry);
+
+private:
+    const size_t m_byteBudget;
+    std::mutex m_mutex;
+    std::map<std::string, Entry> m_entries;
+    std::list<std::string> m_recentPaths; //< Most recently used first.
+    size_t m_cachedByteCount = 0; //< Not counting the evicted assets still in use.
+
+    std::shared_ptr<Gauge> m_cachedBytesMetric;
+    std::shared_ptr<Counter> m_hitsMetric;
+    std::shared_ptr<Counter> m_readsMetric;
+};
+
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -9,6 +9,7 @@
 #include <nx/sdk/analytics/helpers/object_metadata_packet.h>
 #include <nx/sdk/analytics/helpers/object_track_best_shot_packet.h>
 
+#include <nx/vms_server_plugins/analytics/stub/asset_cache.h>
 #include <nx/vms_server_plugins/analytics/stub/utils.h>
 
 #include "settings.h"
@@ -108,7 +109,7 @@ nx::sdk::Result<const nx::sdk::ISettingsResponse*> DeviceAgent::settingsReceived
     const std::string imagePath = settings[kImagePathSetting];
     if (!imagePath.empty())
     {
-        m_bestShotGenerationContext.imageData = loadFile(imagePath);
+        m_bestShotGenerationContext.image = AssetCache::instance().load(imagePath);
         m_bestShotGenerationContext.imageDataFormat = imageFormatFromPath(imagePath);
     }
 
@@ -246,7 +247,8 @@ Ptr<IObjectTrackBestShotPacket> DeviceAgent::generateImageBestShot(Uuid trackId)
         m_lastFrameTimestampUs);
 
     bestShotPacket->setImageDataFormat(m_bestShotGenerationContext.imageDataFormat);
-    bestShotPacket->setImageData(m_bestShotGenerationContext.imageData);
+    if (m_bestShotGenerationContext.image)
+        bestShotPacket->setImageData(m_bestShotGenerationContext.image->toVector());
 
     return bestShotPacket;
 }
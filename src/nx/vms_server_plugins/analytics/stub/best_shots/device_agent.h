@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include <nx/sdk/analytics/helpers/consuming_device_agent.h>
@@ -9,6 +10,8 @@
 #include <nx/sdk/analytics/i_object_track_best_shot_packet.h>
 #include <nx/sdk/analytics/rect.h>
 
+#include "../asset_cache.h"
+
 namespace nx {
 namespace vms_server_plugins {
 namespace analytics {
@@ -55,7 +58,7 @@ private:
         std::string url;
 
         std::string imageDataFormat;
-        std::vector<char> imageData;
+        std::shared_ptr<const AssetCache::Asset> image; //< Shared with other DeviceAgents.
 
         nx::sdk::analytics::Rect fixedBestShotBoundingBox;
     };
@@ -0,0 +1,101 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "chrome_trace_writer.h"
+
+#include <cstdio>
+
+#undef NX_PRINT_PREFIX
+#define NX_PRINT_PREFIX "[Chrome Trace] "
+#include <nx/kit/debug.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+
+static constexpr int kProcessId = 1;
+
+static std::string escapeJsonString(const std::string& value)
+{
+    std::string result;
+    for (const char c: value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            result += '\\';
+            result += c;
+        }
+        else if ((unsigned char) c < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned) c);
+            result += escaped;
+        }
+        else
+        {
+            result += c;
+        }
+    }
+    return result;
+}
+
+ChromeTraceWriter::ChromeTraceWriter(const std::string& path, int64_t maxEventCount):
+    m_path(path),
+    m_maxEventCount(maxEventCount),
+    m_file(path, std::ios::binary | std::ios::trunc)
+{
+    if (!m_file)
+    {
+        NX_PRINT << "Cannot create " << m_path;
+        return;
+    }
+
+    m_file << "[\n";
+    NX_PRINT << "Writing up to " << m_maxEventCount << " events to " << m_path;
+}
+
+ChromeTraceWriter::~ChromeTraceWriter()
+{
+    if (m_file)
+        m_file.flush();
+}
+
+int ChromeTraceWriter::addTrack(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const int trackId = ++m_trackCount;
+    writeEvent("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + std::to_string(kProcessId)
+        + ",\"tid\":" + std::to_string(trackId)
+        + ",\"args\":{\"name\":\"" + escapeJsonString(name) + "\"}}");
+    return trackId;
+}
+
+void ChromeTraceWriter::addCompleteEvent(
+    int trackId, const char* name, int64_t startUs, int64_t durationUs)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    writeEvent(std::string("{\"name\":\"") + name + "\",\"ph\":\"X\",\"pid\":"
+        + std::to_string(kProcessId) + ",\"tid\":" + std::to_string(trackId)
+        + ",\"ts\":" + std::to_string(startUs) + ",\"dur\":" + std::to_string(durationUs) + "}");
+}
+
+void ChromeTraceWriter::writeEvent(const std::string& event)
+{
+    if (!m_file || m_eventCount >= m_maxEventCount)
+        return;
+
+    m_file << event << ",\n";
+    if (++m_eventCount == m_maxEventCount)
+    {
+        m_file.flush();
+        NX_PRINT << "Reached " << m_maxEventCount << " events in " << m_path
+            << "; the rest are dropped";
+    }
+}
+
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,49 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+
+/**
+ * Writes events in the Chrome trace-event JSON format, to be opened in chrome://tracing or
+ * ui.perfetto.dev. Uses the JSON array form, which is valid without the closing bracket, so the
+ * file can be read while it is being written or after a crash. Thread-safe.
+ */
+class ChromeTraceWriter
+{
+public:
+    /** @param maxEventCount Events beyond this are dropped, to bound the file size. */
+    ChromeTraceWriter(const std::string& path, int64_t maxEventCount);
+    ~ChromeTraceWriter();
+
+    /** Names a track (a "thread" in the viewer); returns its id for addCompleteEvent(). */
+    int addTrack(const std::string& name);
+
+    /** Adds an event with the given start and duration, in microseconds. */
+    void addCompleteEvent(int trackId, const char* name, int64_t startUs, int64_t durationUs);
+
+private:
+    void writeEvent(const std::string& event);
+
+private:
+    const std::string m_path;
+    const int64_t m_maxEventCount;
+
+    std::mutex m_mutex;
+    std::ofstream m_file;
+    int64_t m_eventCount = 0;
+    int m_trackCount = 0;
+};
+
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
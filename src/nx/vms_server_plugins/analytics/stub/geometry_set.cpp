@@ -0,0 +1,391 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "geometry_set.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <nx/kit/json.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+
+using Figure = GeometrySet::Figure;
+using FigureType = GeometrySet::FigureType;
+using Direction = GeometrySet::Direction;
+
+/** Positive if the point is to the right of a -> b, the y axis pointing down. */
+static float cross(GeometryPoint a, GeometryPoint b, GeometryPoint point)
+{
+    return (b.x - a.x) * (point.y - a.y) - (b.y - a.y) * (point.x - a.x);
+}
+
+static float polygonArea(const std::vector<GeometryPoint>& polygon)
+{
+    float doubledArea = 0.0F;
+    for (size_t i = 0; i < polygon.size(); ++i)
+    {
+        const GeometryPoint& a = polygon[i];
+        const GeometryPoint& b = polygon[(i + 1) % polygon.size()];
+        doubledArea += a.x * b.y - b.x * a.y;
+    }
+    return std::abs(doubledArea) / 2;
+}
+
+/** One step of Sutherland-Hodgman: keeps the part of the polygon where `isInside` holds. */
+template<typename IsInside, typename Intersect>
+static void clipPolygon(
+    const std::vector<GeometryPoint>& polygon,
+    IsInside isInside,
+    Intersect intersect,
+    std::vector<GeometryPoint>* outPolygon)
+{
+    outPolygon->clear();
+    for (size_t i = 0; i < polygon.size(); ++i)
+    {
+        const GeometryPoint& current = polygon[i];
+        const GeometryPoint& next = polygon[(i + 1) % polygon.size()];
+        if (isInside(current))
+        {
+            outPolygon->push_back(current);
+            if (!isInside(next))
+                outPolygon->push_back(intersect(current, next));
+        }
+        else if (isInside(next))
+        {
+            outPolygon->push_back(intersect(current, next));
+        }
+    }
+}
+
+static GeometryPoint atX(GeometryPoint a, GeometryPoint b, float x)
+{
+    return {x, a.y + (b.y - a.y) * (x - a.x) / (b.x - a.x)};
+}
+
+static GeometryPoint atY(GeometryPoint a, GeometryPoint b, float y)
+{
+    return {a.x + (b.x - a.x) * (y - a.y) / (b.y - a.y), y};
+}
+
+static Direction parseDirection(const std::string& direction)
+{
+    if (direction == "left")
+        return Direction::left;
+    if (direction == "right")
+        return Direction::right;
+    return Direction::absent;
+}
+
+static bool parseFigureType(const std::string& modelType, FigureType* outType)
+{
+    if (modelType == "PolygonFigure")
+        *outType = FigureType::polygon;
+    else if (modelType == "BoxFigure")
+        *outType = FigureType::box;
+    else if (modelType == "LineFigure")
+        *outType = FigureType::line;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * @param index Replaces each '#' in the setting names, as a Repeater does in its template; empty
+ *     outside of Repeaters.
+ */
+static void collectFigureTypes(
+    const nx::kit::Json& item, const std::string& index, GeometrySet::FigureTypes* outTypes)
+{
+    const std::string& modelType = item["type"].string_value();
+
+    if (modelType == "Repeater")
+    {
+        const int startIndex = item["startIndex"].is_number() ? item["startIndex"].int_value() : 1;
+        for (int i = 0; i < item["count"].int_value(); ++i)
+            collectFigureTypes(item["template"], std::to_string(startIndex + i), outTypes);
+        return;
+    }
+
+    FigureType type;
+    if (parseFigureType(modelType, &type))
+    {
+        std::string name = item["name"].string_value();
+        for (size_t pos = name.find('#'); pos != std::string::npos; pos = name.find('#', pos))
+        {
+            name.replace(pos, 1, index);
+            pos += index.size();
+        }
+        (*outTypes)[name] = type;
+        return;
+    }
+
+    for (const nx::kit::Json& child: item["items"].array_items())
+        collectFigureTypes(child, index, outTypes);
+    for (const nx::kit::Json& section: item["sections"].array_items())
+        collectFigureTypes(section, index, outTypes);
+}
+
+static bool parseFigure(
+    const std::string& name,
+    FigureType type,
+    const std::string& value,
+    Figure* outFigure,
+    std::vector<GeometryPoint>* points)
+{
+    std::string error;
+    const nx::kit::Json json = nx::kit::Json::parse(value, error);
+    const nx::kit::Json& figure = json["figure"]; //< Null when nothing is drawn.
+    if (!error.empty() || !figure.is_object())
+        return false;
+
+    const nx::kit::Json& figurePoints = figure["points"];
+    const size_t pointCount = figurePoints.array_items().size();
+    const bool hasValidPointCount = type == FigureType::box
+        ? pointCount == 2
+        : pointCount >= (type == FigureType::polygon ? 3U : 2U);
+    if (!hasValidPointCount)
+        return false;
+
+    outFigure->name = name;
+    outFigure->type = type;
+    outFigure->label = json["label"].string_value();
+    outFigure->color = figure["color"].string_value();
+    outFigure->showOnCamera = json["showOnCamera"].bool_value();
+    outFigure->direction = type == FigureType::line
+        ? parseDirection(figure["direction"].string_value())
+        : Direction::absent;
+    outFigure->firstPointIndex = (int) points->size();
+    outFigure->pointCount = (int) pointCount;
+
+    for (const nx::kit::Json& point: figurePoints.array_items())
+    {
+        if (!point.is_array() || point.array_items().size() != 2)
+        {
+            points->resize(outFigure->firstPointIndex);
+            return false;
+        }
+        points->push_back({(float) point[0].number_value(), (float) point[1].number_value()});
+    }
+
+    GeometryPoint* const first = points->data() + outFigure->firstPointIndex;
+    if (outFigure->type == FigureType::box)
+    {
+        // Normalize the corners, so that the box is given by its top-left and bottom-right ones.
+        const GeometryPoint topLeft{
+            std::min(first[0].x, first[1].x), std::min(first[0].y, first[1].y)};
+        const GeometryPoint bottomRight{
+            std::max(first[0].x, first[1].x), std::max(first[0].y, first[1].y)};
+        first[0] = topLeft;
+        first[1] = bottomRight;
+    }
+
+    float minX = first[0].x, minY = first[0].y, maxX = first[0].x, maxY = first[0].y;
+    for (int i = 1; i < outFigure->pointCount; ++i)
+    {
+        minX = std::min(minX, first[i].x);
+        minY = std::min(minY, first[i].y);
+        maxX = std::max(maxX, first[i].x);
+        maxY = std::max(maxY, first[i].y);
+    }
+    outFigure->bounds = {minX, minY, maxX - minX, maxY - minY};
+    return true;
+}
+
+GeometrySet::FigureTypes GeometrySet::figureTypesFromSettingsModel(
+    const nx::kit::Json& settingsModel)
+{
+    FigureTypes result;
+    collectFigureTypes(settingsModel, /*index*/ "", &result);
+    return result;
+}
+
+std::shared_ptr<const GeometrySet> GeometrySet::fromSettings(
+    const std::map<std::string, std::string>& settings,
+    const FigureTypes& figureTypes,
+    uint64_t version)
+{
+    auto result = std::make_shared<GeometrySet>();
+    result->m_version = version;
+
+    // Both maps are sorted by name, so the figures come out sorted too.
+    Figure figure;
+    for (const auto& figureType: figureTypes)
+    {
+        const auto setting = settings.find(figureType.first);
+        if (setting != settings.end()
+            && parseFigure(
+                figureType.first, figureType.second, setting->second, &figure, &result->m_points))
+        {
+            result->m_figures.push_back(figure);
+        }
+    }
+    return result;
+}
+
+const Figure* GeometrySet::find(const std::string& name) const
+{
+    const auto it = std::lower_bound(m_figures.begin(), m_figures.end(), name,
+        [](const Figure& figure, const std::string& name) { return figure.name < name; });
+    if (it == m_figures.end() || it->name != name)
+        return nullptr;
+    return &*it;
+}
+
+std::vector<GeometryPoint> GeometrySet::outline(const Figure& figure) const
+{
+    const GeometryPoint* const figurePoints = points(figure);
+    if (figure.type == FigureType::box)
+    {
+        const GeometryPoint& topLeft = figurePoints[0];
+        const GeometryPoint& bottomRight = figurePoints[1];
+        return {topLeft, {bottomRight.x, topLeft.y}, bottomRight, {topLeft.x, bottomRight.y}};
+    }
+    if (figure.type == FigureType::polygon)
+        return std::vector<GeometryPoint>(figurePoints, figurePoints + figure.pointCount);
+    return {};
+}
+
+bool GeometrySet::contains(const Figure& figure, GeometryPoint point) const
+{
+    const GeometryRect& bounds = figure.bounds;
+    if (figure.type == FigureType::line
+        || point.x < bounds.x || point.x > bounds.x + bounds.width
+        || point.y < bounds.y || point.y > bounds.y + bounds.height)
+    {
+        return false;
+    }
+
+    if (figure.type == FigureType::box)
+        return true;
+
+    const GeometryPoint* const polygon = points(figure);
+    bool isInside = false;
+    for (int i = 0, j = figure.pointCount - 1; i < figure.pointCount; j = i++)
+    {
+        const GeometryPoint& a = polygon[i];
+        const GeometryPoint& b = polygon[j];
+        if ((a.y > point.y) != (b.y > point.y)
+            && point.x < a.x + (b.x - a.x) * (point.y - a.y) / (b.y - a.y))
+        {
+            isInside = !isInside;
+        }
+    }
+    return isInside;
+}
+
+float GeometrySet::area(const Figure& figure) const
+{
+    switch (figure.type)
+    {
+        case FigureType::box: return figure.bounds.width * figure.bounds.height;
+        case FigureType::polygon: return polygonArea(outline(figure));
+        default: return 0.0F;
+    }
+}
+
+float GeometrySet::intersectionArea(const Figure& figure, const GeometryRect& rect) const
+{
+    const GeometryRect& bounds = figure.bounds;
+    const float left = std::max(rect.x, bounds.x);
+    const float top = std::max(rect.y, bounds.y);
+    const float right = std::min(rect.x + rect.width, bounds.x + bounds.width);
+    const float bottom = std::min(rect.y + rect.height, bounds.y + bounds.height);
+    if (figure.type == FigureType::line || right <= left || bottom <= top)
+        return 0.0F;
+
+    if (figure.type == FigureType::box)
+        return (right - left) * (bottom - top);
+
+    // Clip the polygon by the rect; clipping a concave polygon by a convex window may leave
+    // degenerate edges, which do not change the area.
+    std::vector<GeometryPoint> polygon = outline(figure);
+    std::vector<GeometryPoint> clipped;
+    clipPolygon(polygon, [&](GeometryPoint p) { return p.x >= left; },
+        [&](GeometryPoint a, GeometryPoint b) { return atX(a, b, left); }, &clipped);
+    clipPolygon(clipped, [&](GeometryPoint p) { return p.x <= right; },
+        [&](GeometryPoint a, GeometryPoint b) { return atX(a, b, right); }, &polygon);
+    clipPolygon(polygon, [&](GeometryPoint p) { return p.y >= top; },
+        [&](GeometryPoint a, GeometryPoint b) { return atY(a, b, top); }, &clipped);
+    clipPolygon(clipped, [&](GeometryPoint p) { return p.y <= bottom; },
+        [&](GeometryPoint a, GeometryPoint b) { return atY(a, b, bottom); }, &polygon);
+    return polygonArea(polygon);
+}
+
+Direction GeometrySet::crossing(const Figure& figure, GeometryPoint from, GeometryPoint to) const
+{
+    if (figure.type != FigureType::line)
+        return Direction::absent;
+
+    const GeometryPoint* const line = points(figure);
+    for (int i = 0; i + 1 < figure.pointCount; ++i)
+    {
+        const GeometryPoint& a = line[i];
+        const GeometryPoint& b = line[i + 1];
+        const bool isFromOnLeft = cross(a, b, from) <= 0;
+        const bool isToOnLeft = cross(a, b, to) <= 0;
+        if (isFromOnLeft == isToOnLeft)
+            continue;
+
+        // The path crosses the infinite line; check that it does so within the segment.
+        const float sideOfA = cross(from, to, a);
+        const float sideOfB = cross(from, to, b);
+        if ((sideOfA > 0 && sideOfB > 0) || (sideOfA < 0 && sideOfB < 0))
+            continue;
+
+        return isToOnLeft ? Direction::left : Direction::right;
+    }
+    return Direction::absent;
+}
+
+bool GeometrySet::hasSameFigures(const GeometrySet& other) const
+{
+    if (m_figures.size() != other.m_figures.size() || m_points.size() != other.m_points.size())
+        return false;
+
+    for (size_t i = 0; i < m_figures.size(); ++i)
+    {
+        const Figure& a = m_figures[i];
+        const Figure& b = other.m_figures[i];
+        if (a.name != b.name || a.type != b.type || a.label != b.label || a.color != b.color
+            || a.showOnCamera != b.showOnCamera || a.direction != b.direction
+            || a.pointCount != b.pointCount)
+        {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < m_points.size(); ++i)
+    {
+        if (m_points[i].x != other.m_points[i].x || m_points[i].y != other.m_points[i].y)
+            return false;
+    }
+    return true;
+}
+
+GeometryStore::GeometryStore(GeometrySet::FigureTypes figureTypes):
+    m_figureTypes(std::move(figureTypes)),
+    m_set(std::make_shared<GeometrySet>())
+{
+}
+
+bool GeometryStore::update(const std::map<std::string, std::string>& settings)
+{
+    const std::shared_ptr<const GeometrySet> current = this->current();
+    std::shared_ptr<const GeometrySet> set =
+        GeometrySet::fromSettings(settings, m_figureTypes, current->version() + 1);
+    if (set->hasSameFigures(*current))
+        return false;
+
+    // The set is published before its version, so a Reader seeing the new version gets it.
+    std::atomic_store(&m_set, std::move(set));
+    m_version.store(current->version() + 1, std::memory_order_release);
+    return true;
+}
+
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
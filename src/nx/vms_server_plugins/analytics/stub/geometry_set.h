@@ -0,0 +1,181 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <nx/kit/json.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+
+/** In the frame coordinates, 0..1, y pointing down. */
+struct GeometryPoint
+{
+    float x = 0.0F;
+    float y = 0.0F;
+};
+
+struct GeometryRect
+{
+    float x = 0.0F;
+    float y = 0.0F;
+    float width = 0.0F;
+    float height = 0.0F;
+};
+
+/**
+ * Immutable set of the figures drawn in the settings of a DeviceAgent: every PolygonFigure,
+ * BoxFigure and LineFigure setting, whatever its name. The points of all figures are kept in a
+ * single array.
+ *
+ * The type of a figure is the type of its item in the settings model, see FigureTypes.
+ */
+class GeometrySet
+{
+public:
+    enum class FigureType
+    {
+        polygon,
+        box,
+        line,
+    };
+
+    /**
+     * Side of a line, looking from each of its points to the next one. For a line figure, the
+     * side objects are expected to cross to, `absent` meaning both.
+     */
+    enum class Direction
+    {
+        absent,
+        left,
+        right,
+    };
+
+    struct Figure
+    {
+        std::string name; //< Name of the setting.
+        FigureType type = FigureType::polygon;
+        std::string label;
+        std::string color;
+        bool showOnCamera = false;
+        Direction direction = Direction::absent; //< Lines only.
+        int firstPointIndex = 0;
+        int pointCount = 0; //< Boxes have two opposite corners, normalized to top-left first.
+        GeometryRect bounds;
+    };
+
+    /** Types of the figure settings by their names; other settings are not figures. */
+    using FigureTypes = std::map<std::string, FigureType>;
+
+    /** Collects the figure items of a DeviceAgent settings model, expanding the Repeaters. */
+    static FigureTypes figureTypesFromSettingsModel(const nx::kit::Json& settingsModel);
+
+    /**
+     * Parses the figures among the settings; the ones which are not drawn, or do not have
+     * enough points for their type, are skipped.
+     */
+    static std::shared_ptr<const GeometrySet> fromSettings(
+        const std::map<std::string, std::string>& settings,
+        const FigureTypes& figureTypes,
+        uint64_t version);
+
+    /** Increased by GeometryStore whenever the figures change. */
+    uint64_t version() const { return m_version; }
+
+    /** Sorted by name. */
+    const std::vector<Figure>& figures() const { return m_figures; }
+
+    /** @return Null if there is no such figure. */
+    const Figure* find(const std::string& name) const;
+
+    const GeometryPoint* points(const Figure& figure) const
+    {
+        return m_points.data() + figure.firstPointIndex;
+    }
+
+    /** Polygon of a polygon or box figure: the box corners are listed clockwise. */
+    std::vector<GeometryPoint> outline(const Figure& figure) const;
+
+    /** For polygons and boxes; even-odd rule. */
+    bool contains(const Figure& figure, GeometryPoint point) const;
+
+    /** Area of a polygon or box figure. */
+    float area(const Figure& figure) const;
+
+    /** Area of the part of the rect inside a polygon or box figure. */
+    float intersectionArea(const Figure& figure, const GeometryRect& rect) const;
+
+    /**
+     * For lines: whether the segment from -> to crosses the line, and to which side. A point
+     * lying exactly on the line counts as being on its left, so that a path crossing the line
+     * once is reported exactly once whatever the points of the path are.
+     * @return Direction::absent if the segment does not cross the line.
+     */
+    Direction crossing(const Figure& figure, GeometryPoint from, GeometryPoint to) const;
+
+    bool hasSameFigures(const GeometrySet& other) const;
+
+private:
+    uint64_t m_version = 0;
+    std::vector<Figure> m_figures;
+    std::vector<GeometryPoint> m_points;
+};
+
+/**
+ * Holds the current GeometrySet of a DeviceAgent. It is replaced by the settings thread and read
+ * from any thread, typically the video one, without locking.
+ */
+class GeometryStore
+{
+public:
+    explicit GeometryStore(GeometrySet::FigureTypes figureTypes);
+
+    /**
+     * Replaces the set if the figures in the settings differ from the current ones. Must not be
+     * called concurrently.
+     * @return Whether the set has been replaced.
+     */
+    bool update(const std::map<std::string, std::string>& settings);
+
+    /** Thread-safe. */
+    std::shared_ptr<const GeometrySet> current() const { return std::atomic_load(&m_set); }
+
+    /**
+     * Caches the current set for a single thread: while the set is not replaced, getting it is a
+     * single atomic load of the version.
+     */
+    class Reader
+    {
+    public:
+        explicit Reader(const GeometryStore* store): m_store(store) {}
+
+        const GeometrySet& current()
+        {
+            if (!m_set || m_store->m_version.load(std::memory_order_acquire) != m_set->version())
+                m_set = m_store->current();
+            return *m_set;
+        }
+
+    private:
+        const GeometryStore* const m_store;
+        std::shared_ptr<const GeometrySet> m_set;
+    };
+
+private:
+    const GeometrySet::FigureTypes m_figureTypes;
+    std::shared_ptr<const GeometrySet> m_set; //< Accessed with std::atomic_load/store only.
+    std::atomic<uint64_t> m_version{0};
+};
+
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,181 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+/**@file
+ * Levelled logging on top of NX_PRINT, for the code which may run per message or per frame.
+ *
+ * Usage, after defining NX_PRINT_PREFIX and including <nx/kit/debug.h>:
+ * ```
+ * STUB_LOG(LogLevel::warning) << "Cannot parse: " << error;
+ * STUB_LOG_THROTTLED(LogLevel::debug, 1) << "Parsed " << count << " objects";
+ * ```
+ * Nothing after the macro is evaluated unless the message is going to be printed.
+ *
+ * The runtime level is STUB_LOG_LEVEL, by default `runtimeLogLevel()` of the sub-plugin, so every
+ * sub-plugin using these macros defines it next to its ini. It starts from `ini().logLevel`, and
+ * is switched without a restart by the kLogLevelSetting of the Engine settings. Levels above
+ * STUB_LOG_MAX_LEVEL, defined by the build, are compiled out: the condition is a constant, so
+ * such sites leave no code behind.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+
+enum class LogLevel
+{
+    none = 0,
+    error = 1,
+    warning = 2,
+    info = 3,
+    debug = 4,
+    trace = 5,
+};
+
+inline const char* logLevelTag(LogLevel level)
+{
+    switch (level)
+    {
+        case LogLevel::error: return "ERROR: ";
+        case LogLevel::warning: return "WARNING: ";
+        case LogLevel::debug: return "DEBUG: ";
+        case LogLevel::trace: return "TRACE: ";
+        default: return "";
+    }
+}
+
+/** Engine setting switching the runtime log level; see logLevelSettingModel(). */
+const std::string kLogLevelSetting{"logLevel"};
+
+/** Item of the Engine settings model for kLogLevelSetting, as JSON. */
+inline std::string logLevelSettingModel(int defaultLevel)
+{
+    return /*suppress newline*/ 1 + (const char*) R"json(
+{
+    "type": "SpinBox",
+    "name": ")json" + kLogLevelSetting + R"json(",
+    "caption": "Log level",
+    "description": "0 - none, 1 - errors, 2 - warnings, 3 - info, 4 - debug, 5 - trace",
+    "minValue": 0,
+    "maxValue": 5,
+    "defaultValue": )json" + std::to_string(defaultLevel) + R"json(
+}
+)json";
+}
+
+/** Log level which can be switched at runtime; read by every log site, so it is lock-free. */
+class RuntimeLogLevel
+{
+public:
+    explicit RuntimeLogLevel(int level): m_level(level) {}
+
+    int get() const { return m_level.load(std::memory_order_relaxed); }
+    void set(int level) { m_level.store(level, std::memory_order_relaxed); }
+
+private:
+    std::atomic<int> m_level;
+};
+
+/** Prefix of a throttled message telling how many messages before it have been dropped. */
+inline std::string suppressedLogMessagesNote(int64_t suppressedCount)
+{
+    if (suppressedCount == 0)
+        return std::string();
+    return "(" + std::to_string(suppressedCount) + " similar messages suppressed) ";
+}
+
+/**
+ * Token bucket of a single log site: lets through up to `burst` messages at once, refilled at
+ * `messagesPerSecond`. Lock-free; implemented as a virtual scheduling clock, which is equivalent
+ * to a bucket but needs a single atomic.
+ */
+class LogRateLimiter
+{
+public:
+    LogRateLimiter(double messagesPerSecond, int burst):
+        m_intervalUs((int64_t) (1000000 / std::max(messagesPerSecond, 0.001))),
+        m_burstUs(m_intervalUs * std::max(burst, 1))
+    {
+    }
+
+    /**
+     * @param outSuppressedCount Number of messages dropped since the previous allowed one; only
+     *     set if true is returned.
+     */
+    bool allow(int64_t* outSuppressedCount)
+    {
+        const int64_t nowUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        int64_t scheduledUs = m_scheduledUs.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            // The bucket is empty when the clock runs ahead of now by more than the burst.
+            const int64_t newScheduledUs = std::max(scheduledUs, nowUs) + m_intervalUs;
+            if (newScheduledUs - nowUs > m_burstUs)
+            {
+                m_suppressedCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (m_scheduledUs.compare_exchange_weak(
+                scheduledUs, newScheduledUs, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+
+        *outSuppressedCount = m_suppressedCount.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    const int64_t m_intervalUs;
+    const int64_t m_burstUs;
+    std::atomic<int64_t> m_scheduledUs{0};
+    std::atomic<int64_t> m_suppressedCount{0};
+};
+
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
+
+#if !defined(STUB_LOG_MAX_LEVEL)
+    #define STUB_LOG_MAX_LEVEL 5 //< Everything is compiled in.
+#endif
+
+#if !defined(STUB_LOG_LEVEL)
+    #define STUB_LOG_LEVEL (runtimeLogLevel().get())
+#endif
+
+#define STUB_LOG_IS_ENABLED(LEVEL) \
+    ((int) (LEVEL) <= STUB_LOG_MAX_LEVEL && (int) (LEVEL) <= (STUB_LOG_LEVEL))
+
+#define STUB_LOG(LEVEL) \
+    if (!STUB_LOG_IS_ENABLED(LEVEL)) {} else \
+        NX_PRINT << ::nx::vms_server_plugins::analytics::stub::logLevelTag(LEVEL)
+
+/**
+ * Like STUB_LOG(), but prints at most MESSAGES_PER_SECOND messages from this site on average,
+ * with bursts of up to 10 messages; the number of dropped messages is printed with the next one.
+ */
+#define STUB_LOG_THROTTLED(LEVEL, MESSAGES_PER_SECOND) \
+    if (!STUB_LOG_IS_ENABLED(LEVEL)) {} else \
+    if (int64_t stubLogSuppressedCount = 0; \
+        ![]() -> ::nx::vms_server_plugins::analytics::stub::LogRateLimiter& \
+        { \
+            static ::nx::vms_server_plugins::analytics::stub::LogRateLimiter limiter( \
+                (MESSAGES_PER_SECOND), /*burst*/ 10); \
+            return limiter; \
+        }().allow(&stubLogSuppressedCount)) {} else \
+        NX_PRINT << ::nx::vms_server_plugins::analytics::stub::logLevelTag(LEVEL) \
+            << ::nx::vms_server_plugins::analytics::stub::suppressedLogMessagesNote( \
+                stubLogSuppressedCount)
@@ -0,0 +1,240 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+
+uint64_t Histogram::bucketUpperBound(int index)
+{
+    if (index < kSubBucketCount)
+        return (uint64_t) index;
+    if (index >= kBucketCount - 1)
+        return std::numeric_limits<uint64_t>::max();
+
+    const int exponent = index / kSubBucketCount + kSubBucketBits - 1;
+    const uint64_t subBucket = (uint64_t) (index % kSubBucketCount);
+    return ((kSubBucketCount + subBucket + 1) << (exponent - kSubBucketBits)) - 1;
+}
+
+uint64_t Histogram::quantile(double q) const
+{
+    // The buckets are read one by one, so the total is taken from them rather than m_count.
+    uint64_t total = 0;
+    for (int i = 0; i < kBucketCount; ++i)
+        total += bucketCount(i);
+    if (total == 0)
+        return 0;
+
+    const auto rank = (uint64_t) std::max(1.0, q * (double) total + 0.5);
+    uint64_t cumulativeCount = 0;
+    for (int i = 0; i < kBucketCount; ++i)
+    {
+        cumulativeCount += bucketCount(i);
+        if (cumulativeCount >= rank)
+            return bucketUpperBound(i);
+    }
+    return bucketUpperBound(kBucketCount - 1);
+}
+
+MetricsRegistry& MetricsRegistry::instance()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+template<typename Metric>
+std::shared_ptr<Metric> MetricsRegistry::findOrAdd(
+    Type type, const std::string& name, const std::string& help, const std::string& labels)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (const Entry& entry: m_entries)
+    {
+        if (entry.type != type || entry.name != name || entry.labels != labels)
+            continue;
+        if (auto metric = entry.metric.lock())
+            return std::static_pointer_cast<Metric>(metric);
+    }
+
+    auto metric = std::make_shared<Metric>();
+    m_entries.push_back({name, help, labels, type, metric});
+    return metric;
+}
+
+std::shared_ptr<Counter> MetricsRegistry::counter(
+    const std::string& name, const std::string& help, const std::string& labels)
+{
+    return findOrAdd<Counter>(Type::counter, name, help, labels);
+}
+
+std::shared_ptr<Gauge> MetricsRegistry::gauge(
+    const std::string& name, const std::string& help, const std::string& labels)
+{
+    return findOrAdd<Gauge>(Type::gauge, name, help, labels);
+}
+
+std::shared_ptr<Histogram> MetricsRegistry::histogram(
+    const std::string& name, const std::string& help, const std::string& labels)
+{
+    return findOrAdd<Histogram>(Type::histogram, name, help, labels);
+}
+
+std::vector<MetricsRegistry::AliveMetric> MetricsRegistry::aliveMetrics()
+{
+    std::vector<AliveMetric> result;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_entries.erase(
+            std::remove_if(m_entries.begin(), m_entries.end(),
+                [](const Entry& entry) { return entry.metric.expired(); }),
+            m_entries.end());
+
+        for (const Entry& entry: m_entries)
+        {
+            if (auto metric = entry.metric.lock())
+                result.push_back({entry, std::move(metric)});
+        }
+    }
+
+    // Prometheus requires all samples of a metric family to be adjacent.
+    std::stable_sort(result.begin(), result.end(),
+        [](const AliveMetric& left, const AliveMetric& right)
+        {
+            return left.entry.name < right.entry.name;
+        });
+    return result;
+}
+
+static std::string withLabels(const std::string& labels, const std::string& extraLabel = "")
+{
+    if (labels.empty() && extraLabel.empty())
+        return std::string();
+    if (labels.empty() || extraLabel.empty())
+        return "{" + labels + extraLabel + "}";
+    return "{" + labels + "," + extraLabel + "}";
+}
+
+std::string MetricsRegistry::prometheusText()
+{
+    std::ostringstream text;
+    const std::string* previousName = nullptr;
+
+    const std::vector<AliveMetric> metrics = aliveMetrics();
+    for (const AliveMetric& alive: metrics)
+    {
+        const Entry& entry = alive.entry;
+        if (!previousName || *previousName != entry.name)
+        {
+            static const char* const kTypeNames[] = {"counter", "gauge", "histogram"};
+            text << "# HELP " << entry.name << " " << entry.help << "\n";
+            text << "# TYPE " << entry.name << " " << kTypeNames[(int) entry.type] << "\n";
+            previousName = &entry.name;
+        }
+
+        switch (entry.type)
+        {
+            case Type::counter:
+                text << entry.name << withLabels(entry.labels) << " "
+                    << static_cast<const Counter*>(alive.metric.get())->value() << "\n";
+                break;
+
+            case Type::gauge:
+                text << entry.name << withLabels(entry.labels) << " "
+                    << static_cast<const Gauge*>(alive.metric.get())->value() << "\n";
+                break;
+
+            case Type::histogram:
+            {
+                const auto histogram = static_cast<const Histogram*>(alive.metric.get());
+
+                // Only the non-empty buckets are listed, which is enough for cumulative ones.
+                uint64_t cumulativeCount = 0;
+                for (int i = 0; i < Histogram::kBucketCount - 1; ++i)
+                {
+                    const uint64_t count = histogram->bucketCount(i);
+                    if (count == 0)
+                        continue;
+                    cumulativeCount += count;
+                    text << entry.name << "_bucket" << withLabels(entry.labels,
+                        "le=\"" + std::to_string(Histogram::bucketUpperBound(i)) + "\"")
+                        << " " << cumulativeCount << "\n";
+                }
+                cumulativeCount += histogram->bucketCount(Histogram::kBucketCount - 1);
+                text << entry.name << "_bucket" << withLabels(entry.labels, "le=\"+Inf\"")
+                    << " " << cumulativeCount << "\n";
+                text << entry.name << "_sum" << withLabels(entry.labels) << " "
+                    << histogram->sum() << "\n";
+                text << entry.name << "_count" << withLabels(entry.labels) << " "
+                    << cumulativeCount << "\n";
+                break;
+            }
+        }
+    }
+
+    return text.str();
+}
+
+std::string MetricsRegistry::summaryText()
+{
+    std::ostringstream text;
+
+    const std::vector<AliveMetric> metrics = aliveMetrics();
+    for (const AliveMetric& alive: metrics)
+    {
+        const Entry& entry = alive.entry;
+        text << entry.name << withLabels(entry.labels) << ": ";
+        switch (entry.type)
+        {
+            case Type::counter:
+                text << static_cast<const Counter*>(alive.metric.get())->value();
+                break;
+
+            case Type::gauge:
+                text << static_cast<const Gauge*>(alive.metric.get())->value();
+                break;
+
+            case Type::histogram:
+            {
+                const auto histogram = static_cast<const Histogram*>(alive.metric.get());
+                text << "count " << histogram->count()
+                    << ", p50 " << histogram->quantile(0.5)
+                    << ", p99 " << histogram->quantile(0.99);
+                break;
+            }
+        }
+        text << "\n";
+    }
+
+    return text.str();
+}
+
+std::string escapeLabelValue(const std::string& value)
+{
+    std::string result;
+    result.reserve(value.size());
+    for (const char c: value)
+    {
+        if (c == '\\' || c == '"')
+            result += '\\';
+        if (c == '\n')
+        {
+            result += "\\n";
+            continue;
+        }
+        result += c;
+    }
+    return result;
+}
+
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
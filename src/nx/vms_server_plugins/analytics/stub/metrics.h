@@ -0,0 +1,178 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+
+/**
+ * Metrics are recorded with relaxed atomic operations only, so they can be updated from any
+ * thread on the per-frame and per-message paths. They are registered in the plugin-wide
+ * MetricsRegistry, which keeps them only while their owner holds them.
+ */
+
+class Counter
+{
+public:
+    void add(uint64_t value = 1) { m_value.fetch_add(value, std::memory_order_relaxed); }
+    uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_value{0};
+};
+
+class Gauge
+{
+public:
+    void set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+    void add(int64_t value) { m_value.fetch_add(value, std::memory_order_relaxed); }
+    int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> m_value{0};
+};
+
+/**
+ * Histogram of non-negative integer values, e.g. durations in microseconds, with log-linear
+ * buckets: every power of two is split into 8 equal buckets, so a bucket bound is off the actual
+ * value by at most 12.5%. Values up to 2^40 are told apart; larger ones share the last bucket.
+ */
+class Histogram
+{
+public:
+    static constexpr int kSubBucketBits = 3;
+    static constexpr int kSubBucketCount = 1 << kSubBucketBits;
+    static constexpr int kMaxExponent = 40;
+    static constexpr int kBucketCount = (kMaxExponent - kSubBucketBits + 2) * kSubBucketCount;
+
+    void record(int64_t value)
+    {
+        const uint64_t v = value > 0 ? (uint64_t) value : 0;
+        m_buckets[bucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(v, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return m_sum.load(std::memory_order_relaxed); }
+    uint64_t bucketCount(int index) const
+    {
+        return m_buckets[index].load(std::memory_order_relaxed);
+    }
+
+    /** Largest value falling into the bucket. */
+    static uint64_t bucketUpperBound(int index);
+
+    /** Approximate quantile, `q` being in 0..1; 0 if nothing has been recorded. */
+    uint64_t quantile(double q) const;
+
+    static int bucketIndex(uint64_t value)
+    {
+        if (value < (uint64_t) kSubBucketCount)
+            return (int) value;
+
+        int exponent = highestBit(value);
+        if (exponent > kMaxExponent)
+            return kBucketCount - 1;
+
+        const int subBucket = (int) (value >> (exponent - kSubBucketBits)) & (kSubBucketCount - 1);
+        return (exponent - kSubBucketBits + 1) * kSubBucketCount + subBucket;
+    }
+
+private:
+    static int highestBit(uint64_t value)
+    {
+        #if defined(__GNUC__) || defined(__clang__)
+            return 63 - __builtin_clzll(value);
+        #else
+            int result = 0;
+            while (value >>= 1)
+                ++result;
+            return result;
+        #endif
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> m_buckets{};
+    std::atomic<uint64_t> m_sum{0};
+    std::atomic<uint64_t> m_count{0};
+};
+
+/**
+ * Plugin-wide set of named metrics. Registration takes a lock and is meant to be done once, e.g.
+ * when a DeviceAgent is created; recording goes straight to the returned object.
+ *
+ * Names follow the Prometheus conventions, e.g. "stub_frames_total"; labels are given in the
+ * Prometheus syntax without braces, e.g. `camera="<id>"`. Registering a metric which is already
+ * alive returns the same object.
+ */
+class MetricsRegistry
+{
+public:
+    static MetricsRegistry& instance();
+
+    std::shared_ptr<Counter> counter(
+        const std::string& name, const std::string& help, const std::string& labels = "");
+    std::shared_ptr<Gauge> gauge(
+        const std::string& name, const std::string& help, const std::string& labels = "");
+    std::shared_ptr<Histogram> histogram(
+        const std::string& name, const std::string& help, const std::string& labels = "");
+
+    /** All alive metrics in the Prometheus text exposition format. */
+    std::string prometheusText();
+
+    /** One line per alive metric; histograms are shown by their count, p50 and p99. */
+    std::string summaryText();
+
+private:
+    enum class Type
+    {
+        counter,
+        gauge,
+        histogram,
+    };
+
+    struct Entry
+    {
+        std::string name;
+        std::string help;
+        std::string labels;
+        Type type;
+        std::weak_ptr<void> metric;
+    };
+
+    template<typename Metric>
+    std::shared_ptr<Metric> findOrAdd(
+        Type type, const std::string& name, const std::string& help, const std::string& labels);
+
+    struct AliveMetric
+    {
+        Entry entry;
+        std::shared_ptr<void> metric;
+    };
+
+    /** Removes the entries of the destroyed metrics; returns the alive ones, sorted by name. */
+    std::vector<AliveMetric> aliveMetrics();
+
+private:
+    std::mutex m_mutex;
+    std::vector<Entry> m_entries;
+};
+
+/** Escapes a value for a Prometheus label, e.g. `camera="` + escapeLabelValue(id) + `"`. */
+std::string escapeLabelValue(const std::string& value);
+
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,224 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "metrics_exporter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#if !defined(_WIN32)
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+#include "metrics.h"
+
+#undef NX_PRINT_PREFIX
+#define NX_PRINT_PREFIX "[Metrics] "
+#include <nx/kit/debug.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+
+using namespace std::chrono;
+
+static const std::string kSocketPrefix = "unix:";
+
+MetricsExporter::MetricsExporter(
+    std::string target,
+    milliseconds exportPeriod,
+    milliseconds summaryPeriod,
+    SummaryHandler summaryHandler)
+    :
+    m_target(std::move(target)),
+    m_exportPeriod(std::max(exportPeriod, milliseconds(100))),
+    m_summaryPeriod(summaryPeriod),
+    m_summaryHandler(std::move(summaryHandler))
+{
+    if (m_target.compare(0, kSocketPrefix.size(), kSocketPrefix) == 0)
+        m_socketPath = m_target.substr(kSocketPrefix.size());
+
+    if (m_target.empty() && (m_summaryPeriod.count() <= 0 || !m_summaryHandler))
+        return;
+
+    m_thread = std::thread([this]() { threadLoop(); });
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_terminated = true;
+    }
+    m_condition.notify_all();
+
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void MetricsExporter::threadLoop()
+{
+    if (!m_socketPath.empty() && !openSocket())
+        NX_PRINT << "Cannot listen on " << m_socketPath << "; metrics are not exported";
+
+    const bool isFileExport = !m_target.empty() && m_socketPath.empty();
+    auto nextExport = steady_clock::now();
+    auto nextSummary = steady_clock::now() + m_summaryPeriod;
+
+    for (;;)
+    {
+        const auto now = steady_clock::now();
+
+        if (isFileExport && now >= nextExport)
+        {
+            writeFile();
+            nextExport = now + m_exportPeriod;
+        }
+
+        if (m_summaryPeriod.count() > 0 && m_summaryHandler && now >= nextSummary)
+        {
+            m_summaryHandler(MetricsRegistry::instance().summaryText());
+            nextSummary = now + m_summaryPeriod;
+        }
+
+        auto wakeUp = isFileExport ? nextExport : now + m_exportPeriod;
+        if (m_summaryPeriod.count() > 0 && m_summaryHandler)
+            wakeUp = std::min(wakeUp, nextSummary);
+
+        if (m_socket >= 0)
+        {
+            // The socket is polled in short slices, so that termination is noticed soon.
+            serveSocketClients(std::min(
+                duration_cast<milliseconds>(wakeUp - now), milliseconds(200)));
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_socket >= 0)
+        {
+            if (m_terminated)
+                break;
+            continue;
+        }
+        if (m_condition.wait_until(lock, wakeUp, [this]() { return m_terminated; }))
+            break;
+    }
+
+    closeSocket();
+}
+
+void MetricsExporter::writeFile()
+{
+    // Written aside and renamed, so that a scraper never reads a half-written file.
+    const std::string temporaryPath = m_target + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file << MetricsRegistry::instance().prometheusText();
+        if (!file)
+        {
+            NX_PRINT << "Cannot write " << temporaryPath;
+            return;
+        }
+    }
+
+    #if defined(_WIN32)
+        std::remove(m_target.c_str()); //< rename() does not replace files on Windows.
+    #endif
+    if (std::rename(temporaryPath.c_str(), m_target.c_str()) != 0)
+        NX_PRINT << "Cannot rename " << temporaryPath << " to " << m_target;
+}
+
+#if !defined(_WIN32)
+
+bool MetricsExporter::openSocket()
+{
+    sockaddr_un address{};
+    if (m_socketPath.size() >= sizeof(address.sun_path))
+        return false;
+
+    m_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_socket < 0)
+        return false;
+
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, m_socketPath.c_str(), sizeof(address.sun_path) - 1);
+    unlink(m_socketPath.c_str()); //< Left over by a previous run.
+
+    if (bind(m_socket, (const sockaddr*) &address, sizeof(address)) != 0
+        || listen(m_socket, /*backlog*/ 4) != 0)
+    {
+        closeSocket();
+        return false;
+    }
+
+    NX_PRINT << "Serving metrics on " << m_socketPath;
+    return true;
+}
+
+void MetricsExporter::serveSocketClients(milliseconds timeout)
+{
+    pollfd pollFd{m_socket, POLLIN, 0};
+    if (poll(&pollFd, 1, (int) std::max<int64_t>(timeout.count(), 0)) <= 0)
+        return;
+
+    const int client = accept(m_socket, nullptr, nullptr);
+    if (client < 0)
+        return;
+
+    // Wait briefly for the request, which is not looked at: every request gets the metrics.
+    char request[1024];
+    pollfd clientPollFd{client, POLLIN, 0};
+    if (poll(&clientPollFd, 1, /*timeoutMs*/ 100) > 0)
+        recv(client, request, sizeof(request), 0);
+
+    const std::string body = MetricsRegistry::instance().prometheusText();
+    const std::string text = "HTTP/1.0 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "\r\n" + body;
+    size_t sent = 0;
+    while (sent < text.size())
+    {
+        const ssize_t result = send(client, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+        if (result <= 0)
+            break;
+        sent += (size_t) result;
+    }
+    ::close(client);
+}
+
+void MetricsExporter::closeSocket()
+{
+    if (m_socket < 0)
+        return;
+
+    ::close(m_socket);
+    m_socket = -1;
+    unlink(m_socketPath.c_str());
+}
+
+#else // !defined(_WIN32)
+
+bool MetricsExporter::openSocket()
+{
+    return false;
+}
+
+void MetricsExporter::serveSocketClients(milliseconds /*timeout*/)
+{
+}
+
+void MetricsExporter::closeSocket()
+{
+}
+
+#endif // !defined(_WIN32)
+
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,70 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+
+/**
+ * Background thread publishing MetricsRegistry::instance() in the Prometheus text format:
+ * - if the target starts with "unix:", the rest is the path of a Unix socket answering every
+ *     HTTP request with the current metrics, e.g.
+ *     `curl --unix-socket <path> http://localhost/metrics`;
+ * - otherwise the target is a file rewritten atomically every export period.
+ *
+ * Optionally calls the summary handler with MetricsRegistry::summaryText() with its own period,
+ * e.g. to push it as a Plugin Diagnostic Event.
+ */
+class MetricsExporter
+{
+public:
+    using SummaryHandler = std::function<void(const std::string& summary)>;
+
+    /**
+     * @param target Empty for no export.
+     * @param summaryPeriod Zero for no summary.
+     */
+    MetricsExporter(
+        std::string target,
+        std::chrono::milliseconds exportPeriod,
+        std::chrono::milliseconds summaryPeriod,
+        SummaryHandler summaryHandler);
+
+    /** Stops the thread; the summary handler is not called afterwards. */
+    ~MetricsExporter();
+
+private:
+    void threadLoop();
+    void writeFile();
+    bool openSocket();
+    void serveSocketClients(std::chrono::milliseconds timeout);
+    void closeSocket();
+
+private:
+    const std::string m_target;
+    const std::chrono::milliseconds m_exportPeriod;
+    const std::chrono::milliseconds m_summaryPeriod;
+    const SummaryHandler m_summaryHandler;
+
+    std::string m_socketPath; //< Non-empty if the target is a socket.
+    int m_socket = -1;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_terminated = false;
+    std::thread m_thread;
+};
+
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -134,26 +134,10 @@ bool DeviceAgent::pushCompressedVideoFrame(const ICompressedVideoPacket* videoFr
 }
 
 bool DeviceAgent::hasMotionUnderObject(
-    int objectColumn, int objectRow, Ptr<IMotionMetadataPacket> motionMetadataPacket)
+    int objectColumn, int objectRow, int objectWidth, int objectHeight) const
 {
-    for (int column = objectColumn * m_deviceAgentSettings.objectWidthInMotionCells;
-        column < std::min(
-            (objectColumn + 1) * m_deviceAgentSettings.objectWidthInMotionCells,
-            motionMetadataPacket->columnCount());
-        ++column)
-    {
-        for (int row = objectRow * m_deviceAgentSettings.objectHeightInMotionCells;
-            row < std::min(
-                (objectRow + 1) * m_deviceAgentSettings.objectHeightInMotionCells,
-                motionMetadataPacket->rowCount());
-            ++row)
-        {
-            if (motionMetadataPacket->isMotionAt(column, row))
-                return true;
-        }
-    }
-
-    return false;
+    return m_motionGrid.motionCellCount(
+        objectColumn * objectWidth, objectRow * objectHeight, objectWidth, objectHeight) > 0;
 }
 
 void DeviceAgent::processFrameMotion(Ptr<IList<IMetadataPacket>> metadataPacketList)
@@ -180,15 +164,21 @@ void DeviceAgent::processFrameMotion(Ptr<IList<IMetadataPacket>> metadataPacketL
         if (!motionPacket)
             continue;
 
-        auto objectMetadataPacket = makePtr<ObjectMetadataPacket>();
+        // Packets released by the Server drop their objects, so that those can be recycled too.
+        m_packetPool.forEachFree([](ObjectMetadataPacket* packet) { packet->clear(); });
+        auto objectMetadataPacket = m_packetPool.acquire(
+            []() { return makePtr<ObjectMetadataPacket>(); });
         objectMetadataPacket->setTimestampUs(motionPacket->timestampUs());
 
-        int objectColumnCount =
-            motionPacket->columnCount() / m_deviceAgentSettings.objectWidthInMotionCells;
+        // The grid is read once per packet, rather than once per cell of every object.
+        m_motionGrid.assign(motionPacket.get());
+        const int objectWidth = m_deviceAgentSettings.objectWidthInMotionCells;
+        const int objectHeight = m_deviceAgentSettings.objectHeightInMotionCells;
+
+        int objectColumnCount = m_motionGrid.columnCount() / objectWidth;
         if (objectColumnCount < 1)
             objectColumnCount = 1;
-        int objectRowCount =
-            motionPacket->rowCount() / m_deviceAgentSettings.objectHeightInMotionCells;
+        int objectRowCount = m_motionGrid.rowCount() / objectHeight;
         if (objectRowCount < 1)
             objectRowCount = 1;
         if (m_objectTrackIdForObjectCells.size() != objectColumnCount * objectRowCount)
@@ -202,20 +192,25 @@ void DeviceAgent::processFrameMotion(Ptr<IList<IMetadataPacket>> metadataPacketL
         {
             for (int objectRow = 0; objectRow < objectRowCount; ++objectRow)
             {
-                if (!hasMotionUnderObject(objectColumn, objectRow, motionPacket))
+                if (!hasMotionUnderObject(objectColumn, objectRow, objectWidth, objectHeight))
                     continue;
 
-                const auto objectMetadata = makePtr<ObjectMetadata>();
+                const auto objectMetadata = m_objectPool.acquire(
+                    []()
+                    {
+                        const auto newObjectMetadata = makePtr<ObjectMetadata>();
+                        newObjectMetadata->setTypeId(kMotionVisualizationObjectType);
+                        newObjectMetadata->setConfidence(1.0F);
+                        return newObjectMetadata;
+                    });
                 objectMetadata->setBoundingBox(Rect(
                     objectColumn / (float) objectColumnCount,
                     objectRow / (float) objectRowCount,
                     1.0F / objectColumnCount,
                     1.0F / objectRowCount));
 
-                objectMetadata->setTypeId(kMotionVisualizationObjectType);
                 objectMetadata->setTrackId(
                     m_objectTrackIdForObjectCells[objectColumn * objectRowCount + objectRow]);
-                objectMetadata->setConfidence(1.0F);
                 objectMetadataPacket->addItem(objectMetadata.get());
             }
         }
@@ -224,7 +219,9 @@ void DeviceAgent::processFrameMotion(Ptr<IList<IMetadataPacket>> metadataPacketL
         pushMetadataPacket(objectMetadataPacket.releasePtr());
     }
 
-    NX_OUTPUT << "Generated " << motionObjectMetadataCount << " motion Objects for the frame.";
+    NX_OUTPUT << "Generated " << motionObjectMetadataCount << " motion Objects for the frame; "
+        << "metadata objects and packets allocated so far: "
+        << m_objectPool.allocationCount() + m_packetPool.allocationCount() << ".";
 }
 
 void DeviceAgent::doSetNeededMetadataTypes(
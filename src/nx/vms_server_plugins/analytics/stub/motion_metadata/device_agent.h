@@ -6,9 +6,13 @@
 #include <chrono>
 
 #include <nx/sdk/analytics/helpers/consuming_device_agent.h>
+#include <nx/sdk/analytics/helpers/object_metadata.h>
+#include <nx/sdk/analytics/helpers/object_metadata_packet.h>
 #include <nx/sdk/analytics/i_motion_metadata_packet.h>
 
+#include "../recycling_pool.h"
 #include "engine.h"
+#include "motion_grid.h"
 
 namespace nx {
 namespace vms_server_plugins {
@@ -45,10 +49,12 @@ private:
     void processFrameMotion(
         nx::sdk::Ptr<nx::sdk::IList<nx::sdk::analytics::IMetadataPacket>> metadataPacketList);
 
+    /** Looks up m_motionGrid; the object cells are objectWidth x objectHeight motion cells. */
     bool hasMotionUnderObject(
         int objectColumn,
         int objectRow,
-        nx::sdk::Ptr<nx::sdk::analytics::IMotionMetadataPacket> motionMetadataPacket);
+        int objectWidth,
+        int objectHeight) const;
 
 private:
     Engine* const m_engine;
@@ -66,6 +72,11 @@ private:
 
     DeviceAgentSettings m_deviceAgentSettings;
     std::vector<nx::sdk::Uuid> m_objectTrackIdForObjectCells;
+    MotionGrid m_motionGrid; //< Of the motion packet being processed.
+
+    // Motion objects differ only in their bounding box and track id, so they are recycled.
+    RecyclingPool<nx::sdk::analytics::ObjectMetadata> m_objectPool;
+    RecyclingPool<nx::sdk::analytics::ObjectMetadataPacket> m_packetPool;
 };
 
 } // namespace motion_metadata
@@ -0,0 +1,58 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "motion_grid.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace motion_metadata {
+
+using namespace nx::sdk::analytics;
+
+void MotionGrid::assign(const IMotionMetadataPacket* motionPacket)
+{
+    m_columnCount = std::max(motionPacket->columnCount(), 0);
+    m_rowCount = std::max(motionPacket->rowCount(), 0);
+    const int stride = m_rowCount + 1;
+    m_sums.assign((size_t) (m_columnCount + 1) * stride, 0);
+
+    const int cellCount = m_columnCount * m_rowCount;
+    const uint8_t* const data = motionPacket->data();
+    const bool isDataComplete = data && motionPacket->dataSize() >= (cellCount + 7) / 8;
+
+    int bitIndex = 0;
+    for (int column = 0; column < m_columnCount; ++column)
+    {
+        const int* const previousColumnSums = &m_sums[column * stride];
+        int* const columnSums = &m_sums[(column + 1) * stride];
+        int columnMotionCellCount = 0;
+        for (int row = 0; row < m_rowCount; ++row, ++bitIndex)
+        {
+            const bool isMotion = isDataComplete
+                ? (data[bitIndex / 8] & (0x80 >> (bitIndex % 8))) != 0
+                : motionPacket->isMotionAt(column, row);
+            columnMotionCellCount += isMotion ? 1 : 0;
+            columnSums[row + 1] = previousColumnSums[row + 1] + columnMotionCellCount;
+        }
+    }
+}
+
+int MotionGrid::motionCellCount(int column, int row, int width, int height) const
+{
+    const int left = std::clamp(column, 0, m_columnCount);
+    const int top = std::clamp(row, 0, m_rowCount);
+    const int right = std::clamp(column + width, left, m_columnCount);
+    const int bottom = std::clamp(row + height, top, m_rowCount);
+
+    return sum(right, bottom) - sum(left, bottom) - sum(right, top) + sum(left, top);
+}
+
+} // namespace motion_metadata
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,52 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <vector>
+
+#include <nx/sdk/analytics/i_motion_metadata_packet.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace motion_metadata {
+
+/**
+ * Motion grid of a packet as a summed-area table, so that the motion cells within any rectangle
+ * are counted in O(1), instead of calling the virtual isMotionAt() for each cell.
+ *
+ * The table is built in one pass over the raw bits of the packet: the grid is stored column by
+ * column, each column being rowCount() bits, the most significant bit of a byte first. Packets
+ * with fewer data bytes than the grid needs are read via isMotionAt() instead. The table is
+ * reused, so grids of the same size do not allocate.
+ *
+ * Not thread-safe.
+ */
+class MotionGrid
+{
+public:
+    void assign(const nx::sdk::analytics::IMotionMetadataPacket* motionPacket);
+
+    int columnCount() const { return m_columnCount; }
+    int rowCount() const { return m_rowCount; }
+    int motionCellCount() const { return sum(m_columnCount, m_rowCount); }
+
+    /** Cells outside the grid are ignored. */
+    int motionCellCount(int column, int row, int width, int height) const;
+
+private:
+    /** Of the cells with column < `column` and row < `row`. */
+    int sum(int column, int row) const { return m_sums[column * (m_rowCount + 1) + row]; }
+
+private:
+    int m_columnCount = 0;
+    int m_rowCount = 0;
+    std::vector<int> m_sums; //< (columnCount + 1) x (rowCount + 1), by column.
+};
+
+} // namespace motion_metadata
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,169 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "best_shot_selector.h"
+
+#include <algorithm>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+BestShotSelector::BestShotSelector(int maxTrackCount, int64_t trackEndUs):
+    m_maxTrackCount((size_t) std::max(maxTrackCount, 1)),
+    m_trackEndUs(trackEndUs)
+{
+    m_tracks.reserve(m_maxTrackCount);
+    m_nextTracks.reserve(m_maxTrackCount);
+    m_candidates.reserve(m_maxTrackCount);
+}
+
+float BestShotSelector::score(const DetectedObject& object)
+{
+    const float width = std::clamp(object.width, 0.0F, 1.0F);
+    const float height = std::clamp(object.height, 0.0F, 1.0F);
+    const float margin = std::min({
+        object.x, object.y, 1.0F - (object.x + object.width), 1.0F - (object.y + object.height)});
+    const float edgeFactor = kEdgeScoreFactor
+        + (1.0F - kEdgeScoreFactor) * std::clamp(margin / kEdgeMargin, 0.0F, 1.0F);
+
+    return std::clamp(object.confidence, 0.0F, 1.0F) * width * height * edgeFactor;
+}
+
+void BestShotSelector::addCandidate(const DetectedObject& object)
+{
+    if (m_candidates.size() == m_maxTrackCount)
+        return;
+
+    BestShot candidate;
+    candidate.trackId = object.trackId;
+    candidate.x = object.x;
+    candidate.y = object.y;
+    candidate.width = object.width;
+    candidate.height = object.height;
+    candidate.score = score(object);
+    m_candidates.push_back(candidate);
+}
+
+void BestShotSelector::finish(TrackState* track)
+{
+    if (track->isDone)
+        return;
+
+    track->isDone = true;
+    m_bestShots.push_back(track->best);
+}
+
+void BestShotSelector::finishAll()
+{
+    for (TrackState& track: m_tracks)
+        finish(&track);
+    m_tracks.clear();
+}
+
+bool BestShotSelector::tick(TrackState* track, int64_t timestampUs, int64_t deadlineUs)
+{
+    if (timestampUs - track->lastSeenUs >= m_trackEndUs)
+    {
+        finish(track);
+        return false;
+    }
+
+    if (deadlineUs > 0 && timestampUs - track->firstSeenUs >= deadlineUs)
+        finish(track);
+    return true;
+}
+
+void BestShotSelector::update(int64_t trackEpoch, int64_t timestampUs, int64_t deadlineUs)
+{
+    // Tracks from before a restart of the detector or a jump back in time are over.
+    if (trackEpoch != m_trackEpoch || timestampUs < m_lastBatchTimestampUs)
+        finishAll();
+    m_trackEpoch = trackEpoch;
+    m_lastBatchTimestampUs = timestampUs;
+
+    for (BestShot& candidate: m_candidates)
+    {
+        candidate.trackEpoch = trackEpoch;
+        candidate.timestampUs = timestampUs;
+    }
+
+    // Of the detections sharing a trackId, the best one stands for the track.
+    std::sort(m_candidates.begin(), m_candidates.end(),
+        [](const BestShot& a, const BestShot& b)
+        {
+            return a.trackId != b.trackId ? a.trackId < b.trackId : a.score > b.score;
+        });
+    m_candidates.erase(
+        std::unique(m_candidates.begin(), m_candidates.end(),
+            [](const BestShot& a, const BestShot& b) { return a.trackId == b.trackId; }),
+        m_candidates.end());
+
+    // Merge the batch into the tracks, both sorted by trackId. The tracks of the batch always
+    // fit; the ones missing from it are kept until they end, while there is room.
+    size_t missingTrackRoom = m_maxTrackCount - m_candidates.size();
+    const auto keepMissingTrack =
+        [&](TrackState* track)
+        {
+            if (!tick(track, timestampUs, deadlineUs))
+                return;
+            if (missingTrackRoom == 0)
+            {
+                finish(track);
+                return;
+            }
+            m_nextTracks.push_back(*track);
+            --missingTrackRoom;
+        };
+
+    m_nextTracks.clear();
+    auto track = m_tracks.begin();
+    for (const BestShot& candidate: m_candidates)
+    {
+        for (; track != m_tracks.end() && track->best.trackId < candidate.trackId; ++track)
+            keepMissingTrack(&*track);
+
+        TrackState seenTrack;
+        if (track != m_tracks.end() && track->best.trackId == candidate.trackId)
+        {
+            seenTrack = *track++;
+            if (!seenTrack.isDone && candidate.score > seenTrack.best.score)
+                seenTrack.best = candidate;
+        }
+        else
+        {
+            seenTrack.best = candidate;
+            seenTrack.firstSeenUs = timestampUs;
+        }
+        seenTrack.lastSeenUs = timestampUs;
+
+        tick(&seenTrack, timestampUs, deadlineUs);
+        m_nextTracks.push_back(seenTrack);
+    }
+    for (; track != m_tracks.end(); ++track)
+        keepMissingTrack(&*track);
+
+    m_tracks.swap(m_nextTracks);
+    m_candidates.clear();
+}
+
+void BestShotSelector::advance(int64_t timestampUs, int64_t deadlineUs)
+{
+    m_tracks.erase(
+        std::remove_if(m_tracks.begin(), m_tracks.end(),
+            [&](TrackState& track) { return !tick(&track, timestampUs, deadlineUs); }),
+        m_tracks.end());
+}
+
+void BestShotSelector::reset()
+{
+    m_tracks.clear();
+    m_candidates.clear();
+}
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
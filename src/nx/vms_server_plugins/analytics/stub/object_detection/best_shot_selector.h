@@ -0,0 +1,105 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "detection_batch.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/**
+ * Picks one best shot per track: every detection of a track is scored, and only the best one so
+ * far is kept. The best shot is produced once, when the track ends, i.e. it has not been detected
+ * for `trackEndUs`, or when the deadline passes since the track was first detected, whichever is
+ * first; later detections of the track are ignored.
+ *
+ * The score favors confident, large and whole objects: confidence × area × a factor falling from
+ * 1 to kEdgeScoreFactor as the box approaches the frame border within kEdgeMargin, since such
+ * objects are likely to be cut off.
+ *
+ * Tracks are kept in a vector sorted by trackId, at most `maxTrackCount` of them, and merged with
+ * each batch; a track which does not fit ends early. Updates do not allocate, except for the best
+ * shot list growing.
+ *
+ * Not thread-safe.
+ */
+class BestShotSelector
+{
+public:
+    static constexpr float kEdgeMargin = 0.05F;
+    static constexpr float kEdgeScoreFactor = 0.25F;
+
+    struct BestShot
+    {
+        int trackId = 0;
+        int64_t trackEpoch = 0;
+        int64_t timestampUs = 0; //< Of the detection.
+        float x = 0.0F;
+        float y = 0.0F;
+        float width = 0.0F;
+        float height = 0.0F;
+        float score = 0.0F;
+    };
+
+    BestShotSelector(int maxTrackCount, int64_t trackEndUs);
+
+    static float score(const DetectedObject& object);
+
+    /** Adds a detection of the batch being collected; see update(). */
+    void addCandidate(const DetectedObject& object);
+
+    /**
+     * Merges the candidates added since the last call, all of the same batch, into the tracks.
+     * @param deadlineUs Max time from the first detection of a track to its best shot; 0 for
+     *     none, so that the best shot is produced when the track ends.
+     */
+    void update(int64_t trackEpoch, int64_t timestampUs, int64_t deadlineUs);
+
+    /** Lets the time pass without new detections, e.g. on a video frame between batches. */
+    void advance(int64_t timestampUs, int64_t deadlineUs);
+
+    /** Forgets all tracks without producing their best shots. */
+    void reset();
+
+    /** Produced since the last clearBestShots(), in order. */
+    const std::vector<BestShot>& bestShots() const { return m_bestShots; }
+    void clearBestShots() { m_bestShots.clear(); }
+
+private:
+    struct TrackState
+    {
+        BestShot best;
+        int64_t firstSeenUs = 0;
+        int64_t lastSeenUs = 0;
+        bool isDone = false; //< The best shot has been produced.
+    };
+
+    void finish(TrackState* track);
+    void finishAll();
+
+    /** @return Whether the track is still needed. */
+    bool tick(TrackState* track, int64_t timestampUs, int64_t deadlineUs);
+
+private:
+    const size_t m_maxTrackCount;
+    const int64_t m_trackEndUs;
+
+    int64_t m_trackEpoch = 0;
+    int64_t m_lastBatchTimestampUs = INT64_MIN;
+    std::vector<TrackState> m_tracks; //< Sorted by trackId.
+    std::vector<TrackState> m_nextTracks; //< Reused by update().
+    std::vector<BestShot> m_candidates; //< Reused by update().
+    std::vector<BestShot> m_bestShots;
+};
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
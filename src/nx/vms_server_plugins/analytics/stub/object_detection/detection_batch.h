@@ -0,0 +1,128 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+struct DetectedObject
+{
+    std::string label;          // class name
+    float confidence = 0.0F;    // 0.0 - 1.0
+    float x = 0.0F;             // normalized 0-1
+    float y = 0.0F;             // normalized 0-1
+    float width = 0.0F;         // normalized 0-1
+    float height = 0.0F;        // normalized 0-1
+    int trackId = 0;            // unique ID for tracking
+    std::string name;           // custom name field
+};
+
+/**
+ * Wall clock times of the stages a detection message goes through, in microseconds since the
+ * epoch; 0 if unknown. Only the publishing time comes from the message; the other stages are
+ * stamped only when latency tracing is enabled.
+ */
+struct DetectionTrace
+{
+    int64_t publishedUs = 0; //< Set by the publisher, e.g. right after the inference.
+    int64_t arrivedUs = 0; //< Received by the plugin.
+    int64_t parsedUs = 0;
+    int64_t matchedUs = 0; //< Taken for a video frame.
+    int64_t pushedUs = 0; //< Its metadata packet is pushed to the Server.
+};
+
+/**
+ * Detections of one message. Clearing keeps the DetectedObject slots together with the capacity
+ * of their strings, so refilling a batch of a similar size does not allocate.
+ */
+class DetectionBatch
+{
+public:
+    static constexpr size_t kInitialCapacity = 64;
+
+    DetectionBatch() { m_objects.resize(kInitialCapacity); }
+
+    void clear()
+    {
+        m_size = 0;
+        m_timestampUs = -1;
+        m_trackEpoch = 0;
+        m_trace = DetectionTrace();
+    }
+
+    /** Drops the objects, keeping the message-level fields. */
+    void clearObjects() { m_size = 0; }
+
+    /** @return Slot for the next object, reset to the default values. */
+    DetectedObject& append()
+    {
+        if (m_size == m_objects.size())
+            m_objects.emplace_back();
+
+        DetectedObject& object = m_objects[m_size++];
+        object.label.clear();
+        object.confidence = 0.0F;
+        object.x = 0.0F;
+        object.y = 0.0F;
+        object.width = 0.0F;
+        object.height = 0.0F;
+        object.trackId = 0;
+        object.name.clear();
+        return object;
+    }
+
+    /** Drops the object returned by the last append(). */
+    void removeLast() { --m_size; }
+
+    void swap(DetectionBatch& other)
+    {
+        m_objects.swap(other.m_objects);
+        std::swap(m_size, other.m_size);
+        std::swap(m_timestampUs, other.m_timestampUs);
+        std::swap(m_trackEpoch, other.m_trackEpoch);
+        std::swap(m_trace, other.m_trace);
+    }
+
+    /** Timestamp of the source video frame, if the publisher sent it; -1 otherwise. */
+    int64_t timestampUs() const { return m_timestampUs; }
+    void setTimestampUs(int64_t timestampUs) { m_timestampUs = timestampUs; }
+
+    /**
+     * Publisher-defined scope of the trackId values, e.g. the start time of the detector: the
+     * same trackId means the same track only within one epoch. 0 if the publisher sent none.
+     */
+    int64_t trackEpoch() const { return m_trackEpoch; }
+    void setTrackEpoch(int64_t trackEpoch) { m_trackEpoch = trackEpoch; }
+
+    const DetectionTrace& trace() const { return m_trace; }
+    DetectionTrace& trace() { return m_trace; }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    const DetectedObject& operator[](size_t index) const { return m_objects[index]; }
+    const DetectedObject* begin() const { return m_objects.data(); }
+    const DetectedObject* end() const { return m_objects.data() + m_size; }
+
+private:
+    std::vector<DetectedObject> m_objects;
+    size_t m_size = 0;
+    int64_t m_timestampUs = -1;
+    int64_t m_trackEpoch = 0;
+    DetectionTrace m_trace;
+};
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
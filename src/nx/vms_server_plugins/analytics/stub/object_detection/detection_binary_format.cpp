@@ -0,0 +1,144 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "detection_binary_format.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+static constexpr char kMagic[] = {'N', 'X', 'D', 'B'};
+static constexpr uint8_t kVersion = 1;
+static constexpr uint8_t kHasTimestampFlag = 0x01;
+static constexpr uint8_t kHasPublishTimeFlag = 0x02;
+static constexpr uint8_t kNoString = 0xFF;
+static constexpr size_t kHeaderSize = 12;
+static constexpr size_t kRecordSize = 16;
+static constexpr float kQuantizationScale = 1.0F / 65535.0F;
+
+namespace {
+
+struct DictionaryEntry
+{
+    const char* data = nullptr;
+    size_t size = 0;
+};
+
+} // namespace
+
+static uint16_t readUint16(const uint8_t* p)
+{
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static uint32_t readUint32(const uint8_t* p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16)
+        | ((uint32_t) p[3] << 24);
+}
+
+static int64_t readInt64(const uint8_t* p)
+{
+    const uint64_t low = readUint32(p);
+    const uint64_t high = readUint32(p + 4);
+    return (int64_t) (low | (high << 32));
+}
+
+static bool fail(std::string* outError, const char* error)
+{
+    if (outError)
+        *outError = std::string("Failed to decode binary detections: ") + error;
+    return false;
+}
+
+bool isBinaryDetectionMessage(const char* data, size_t size)
+{
+    return size >= sizeof(kMagic) && memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool decodeBinaryDetections(
+    const char* data, size_t size, DetectionBatch* outBatch, std::string* outError)
+{
+    outBatch->clear();
+
+    const auto* const begin = (const uint8_t*) data;
+    const uint8_t* const end = begin + size;
+
+    if (size < kHeaderSize || !isBinaryDetectionMessage(data, size))
+        return fail(outError, "truncated header");
+    if (begin[4] != kVersion)
+        return fail(outError, "unsupported version");
+
+    const uint8_t flags = begin[5];
+    const int dictionarySize = begin[6];
+    const int recordCount = readUint16(begin + 8);
+    const uint8_t* p = begin + kHeaderSize;
+
+    outBatch->setTrackEpoch(readUint16(begin + 10));
+
+    if (flags & kHasTimestampFlag)
+    {
+        if (end - p < 8)
+            return fail(outError, "truncated timestamp");
+        outBatch->setTimestampUs(readInt64(p));
+        p += 8;
+    }
+
+    if (flags & kHasPublishTimeFlag)
+    {
+        if (end - p < 8)
+            return fail(outError, "truncated publish time");
+        outBatch->trace().publishedUs = std::max(readInt64(p), (int64_t) 0);
+        p += 8;
+    }
+
+    // At most 255 entries, each a view into the message.
+    DictionaryEntry dictionary[kNoString];
+    for (int i = 0; i < dictionarySize; ++i)
+    {
+        if (p == end || end - p - 1 < *p)
+            return fail(outError, "truncated dictionary");
+        dictionary[i].size = *p;
+        dictionary[i].data = (const char*) p + 1;
+        p += 1 + dictionary[i].size;
+    }
+
+    if ((size_t) (end - p) != (size_t) recordCount * kRecordSize)
+        return fail(outError, "record section size does not match the record count");
+
+    for (int i = 0; i < recordCount; ++i, p += kRecordSize)
+    {
+        const uint8_t labelIndex = p[10];
+        const uint8_t nameIndex = p[11];
+        if ((labelIndex != kNoString && labelIndex >= dictionarySize)
+            || (nameIndex != kNoString && nameIndex >= dictionarySize))
+        {
+            return fail(outError, "dictionary index out of range");
+        }
+
+        DetectedObject& object = outBatch->append();
+        object.x = readUint16(p) * kQuantizationScale;
+        object.y = readUint16(p + 2) * kQuantizationScale;
+        object.width = readUint16(p + 4) * kQuantizationScale;
+        object.height = readUint16(p + 6) * kQuantizationScale;
+        object.confidence = readUint16(p + 8) * kQuantizationScale;
+        if (labelIndex != kNoString)
+            object.label.assign(dictionary[labelIndex].data, dictionary[labelIndex].size);
+        if (nameIndex != kNoString)
+            object.name.assign(dictionary[nameIndex].data, dictionary[nameIndex].size);
+        object.trackId = (int32_t) readUint32(p + 12);
+    }
+
+    return true;
+}
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,56 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "detection_batch.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/**
+ * Compact binary alternative to the JSON detection message, accepted on the same topic. All
+ * integers are little-endian:
+ *
+ * - Header, 12 bytes: magic "NXDB", uint8 version (1), uint8 flags (bit 0: frame timestamp
+ *     present, bit 1: publish time present), uint8 dictionary size, uint8 reserved, uint16
+ *     record count, uint16 track epoch (see DetectionBatch::trackEpoch()).
+ * - int64 frame timestamp in microseconds, if flags bit 0 is set.
+ * - int64 publish time in microseconds since the epoch (see DetectionTrace), if flags bit 1 is
+ *     set.
+ * - Dictionary of labels and names: per entry, uint8 byte length followed by UTF-8 bytes.
+ * - Records, 16 bytes each: uint16 x, y, width, height and confidence, normalized from 0..1 to
+ *     0..65535; uint8 label index and uint8 name index into the dictionary (255 means none);
+ *     int32 trackId.
+ *
+ * The reference encoder is scripts/detection_codec.py. Its test vector - "person" (0.9, bbox
+ * 0.1 0.2 0.3 0.4, trackId 7, name "Alice") and "car" (0.5, bbox 0.5 0.5 0.25 0.25, trackId 8)
+ * at timestamp 1700000000000000 - encodes to these 69 bytes:
+ * ```
+ * 4e584442 01 01 03 00 0200 0000 00401e18240a0600
+ * 06 706572736f6e 05 416c696365 03 636172
+ * 9a19 3333 cd4c 6666 66e6 00 01 07000000
+ * 0080 0080 0040 0040 0080 02 ff 08000000
+ * ```
+ */
+
+/** Tells the binary format from JSON, which can never start with the magic. */
+bool isBinaryDetectionMessage(const char* data, size_t size);
+
+/**
+ * @param outBatch Cleared and filled; holds garbage if false is returned.
+ * @param outError Description of the problem if false is returned.
+ */
+bool decodeBinaryDetections(
+    const char* data, size_t size, DetectionBatch* outBatch, std::string* outError);
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,141 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "detection_inbox.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+DetectionInbox::DetectionInbox(int capacity, std::shared_ptr<DetectionMetrics> metrics):
+    m_metrics(std::move(metrics)),
+    m_timestampedObjects((size_t) std::max(capacity, 1))
+{
+}
+
+void DetectionInbox::putDetectedObjects(DetectionBatch* objects)
+{
+    std::lock_guard<std::mutex> lock(m_objectsMutex);
+
+    if (objects->timestampUs() < 0)
+    {
+        m_latestObjects.swap(*objects);
+        m_hasLatestObjects = true;
+    }
+    else if (objects->timestampUs() < m_oldestUsefulTimestampUs)
+    {
+        // Typically replayed by the broker after a reconnect: the video has moved on.
+        m_metrics->droppedBatches->add();
+    }
+    else
+    {
+        // Take a free slot, or evict the batch which is the most likely to be stale.
+        Slot* target = nullptr;
+        for (Slot& slot: m_timestampedObjects)
+        {
+            if (!slot.isPending)
+            {
+                target = &slot;
+                break;
+            }
+            if (!target || slot.batch.timestampUs() < target->batch.timestampUs())
+                target = &slot;
+        }
+
+        if (target->isPending)
+            m_metrics->droppedBatches->add();
+        target->batch.swap(*objects);
+        target->isPending = true;
+        updateQueueDepth();
+    }
+
+    m_metrics->messages->add();
+
+    // Mark that we've received at least one MQTT message
+    m_hasReceivedData.store(true);
+}
+
+bool DetectionInbox::takeDetectedObjects(
+    int64_t frameTimestampUs, int64_t toleranceUs, DetectionBatch* outObjects)
+{
+    std::lock_guard<std::mutex> lock(m_objectsMutex);
+    m_oldestUsefulTimestampUs = frameTimestampUs - toleranceUs;
+
+    // Get objects and clear immediately (consume pattern)
+    outObjects->swap(m_latestObjects);
+    m_latestObjects.clear();
+    if (m_hasLatestObjects)
+    {
+        m_hasLatestObjects = false;
+        return true;
+    }
+
+    Slot* nearest = nullptr;
+    int64_t nearestDistanceUs = 0;
+    for (Slot& slot: m_timestampedObjects)
+    {
+        if (!slot.isPending)
+            continue;
+
+        const int64_t timestampUs = slot.batch.timestampUs();
+        if (timestampUs < frameTimestampUs - toleranceUs)
+        {
+            slot.isPending = false;
+            m_metrics->droppedBatches->add();
+            continue;
+        }
+
+        const int64_t distanceUs = timestampUs > frameTimestampUs
+            ? timestampUs - frameTimestampUs
+            : frameTimestampUs - timestampUs;
+        if (distanceUs <= toleranceUs && (!nearest || distanceUs < nearestDistanceUs))
+        {
+            nearest = &slot;
+            nearestDistanceUs = distanceUs;
+        }
+    }
+
+    if (nearest)
+    {
+        outObjects->swap(nearest->batch);
+        nearest->isPending = false;
+    }
+
+    updateQueueDepth();
+    return nearest != nullptr;
+}
+
+bool DetectionInbox::hasReceivedData() const
+{
+    return m_hasReceivedData.load();
+}
+
+void DetectionInbox::reset()
+{
+    std::lock_guard<std::mutex> lock(m_objectsMutex);
+    m_latestObjects.clear();
+    m_hasLatestObjects = false;
+    for (Slot& slot: m_timestampedObjects)
+        slot.isPending = false;
+    m_oldestUsefulTimestampUs = std::numeric_limits<int64_t>::min();
+    updateQueueDepth();
+    m_hasReceivedData.store(false);
+}
+
+void DetectionInbox::updateQueueDepth()
+{
+    int64_t pendingCount = 0;
+    for (const Slot& slot: m_timestampedObjects)
+        pendingCount += slot.isPending ? 1 : 0;
+    m_metrics->queueDepth->set(pendingCount);
+}
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,94 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "detection_batch.h"
+#include "detection_metrics.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/**
+ * Per-DeviceAgent mailbox for the detections routed to it by the Engine-wide
+ * MqttObjectReceiver. Written from the MQTT callback thread, read from the video thread.
+ *
+ * Batches carrying the timestamp of their source frame are kept in a fixed number of slots and
+ * handed to the video frame nearest in time, so network jitter neither moves boxes to a wrong
+ * frame nor makes one message overwrite another. Batches without a timestamp keep the old
+ * behavior: the latest one goes to the next video frame.
+ */
+class DetectionInbox
+{
+public:
+    /**
+     * @param capacity Max number of timestamped batches waiting for their video frame.
+     * @param metrics Metrics of the camera, also updated by the ones delivering the messages.
+     */
+    DetectionInbox(int capacity, std::shared_ptr<DetectionMetrics> metrics);
+
+    DetectionMetrics* metrics() const { return m_metrics.get(); }
+
+    /**
+     * Store the given detections (thread-safe). The batches are swapped, so the caller gets back
+     * a stale batch to refill without allocating. When all slots are busy, the batch with the
+     * oldest timestamp is overwritten. Batches too old to match the next video frame, e.g.
+     * replayed by the broker after a reconnect, are dropped right away.
+     */
+    void putDetectedObjects(DetectionBatch* objects);
+
+    /**
+     * Take the detections for the given video frame (thread-safe): the latest batch without a
+     * timestamp if there is one, otherwise the batch with the timestamp nearest to the frame
+     * within the tolerance. Batches older than the frame by more than the tolerance can no
+     * longer match any frame and are dropped.
+     * @param outObjects Receives the taken batch, or is cleared if there is none.
+     * @return Whether a batch was taken; an empty batch means that no objects are visible.
+     */
+    bool takeDetectedObjects(
+        int64_t frameTimestampUs, int64_t toleranceUs, DetectionBatch* outObjects);
+
+    /**
+     * Check if we ever received any MQTT message
+     * @return true if at least one message was received
+     */
+    bool hasReceivedData() const;
+
+    /** Drop pending objects and forget that data was received, e.g. on connection loss. */
+    void reset();
+
+private:
+    void updateQueueDepth();
+
+private:
+    struct Slot
+    {
+        DetectionBatch batch;
+        bool isPending = false;
+    };
+
+    const std::shared_ptr<DetectionMetrics> m_metrics;
+    std::mutex m_objectsMutex;
+    DetectionBatch m_latestObjects; //< Latest batch without a timestamp.
+    bool m_hasLatestObjects = false;
+    std::vector<Slot> m_timestampedObjects;
+
+    /** Timestamped batches older than this cannot match any frame after the last taken one. */
+    int64_t m_oldestUsefulTimestampUs = std::numeric_limits<int64_t>::min();
+    std::atomic<bool> m_hasReceivedData{false}; // Track if we've ever received MQTT data
+};
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,54 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "detection_metrics.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+DetectionMetrics::DetectionMetrics(const std::string& cameraId)
+{
+    auto& registry = MetricsRegistry::instance();
+    const std::string labels = "camera=\"" + escapeLabelValue(cameraId) + "\"";
+
+    frames = registry.counter("stub_object_detection_frames_total",
+        "Video frames received.", labels);
+    messages = registry.counter("stub_object_detection_messages_total",
+        "Detection messages received and parsed.", labels);
+    parseFailures = registry.counter("stub_object_detection_parse_failures_total",
+        "Detection messages which could not be parsed.", labels);
+    duplicateMessages = registry.counter("stub_object_detection_duplicate_messages_total",
+        "Detection messages redelivered by the broker which had already been received.", labels);
+    droppedBatches = registry.counter("stub_object_detection_dropped_batches_total",
+        "Timestamped detection messages dropped before a video frame matched them.", labels);
+    filteredDetections = registry.counter("stub_object_detection_filtered_detections_total",
+        "Detections dropped because their object type is disabled.", labels);
+    roiFilteredDetections = registry.counter(
+        "stub_object_detection_roi_filtered_detections_total",
+        "Detections dropped because they are outside the regions of interest.", labels);
+    lineCrossings = registry.counter("stub_object_detection_line_crossings_total",
+        "Line crossing events pushed to the Server.", labels);
+    zoneEvents = registry.counter("stub_object_detection_zone_events_total",
+        "Starts and finishes of zone occupancy and dwell events pushed to the Server.", labels);
+    bestShots = registry.counter("stub_object_detection_best_shots_total",
+        "Object track best shots pushed to the Server.", labels);
+    packets = registry.counter("stub_object_detection_packets_total",
+        "Object metadata packets pushed to the Server.", labels);
+    objects = registry.counter("stub_object_detection_objects_total",
+        "Objects pushed to the Server.", labels);
+    queueDepth = registry.gauge("stub_object_detection_queue_depth",
+        "Timestamped detection messages waiting for their video frame.", labels);
+    parseDurationUs = registry.histogram("stub_object_detection_parse_duration_us",
+        "Time to parse a detection message, in microseconds.", labels);
+    frameProcessingDurationUs = registry.histogram(
+        "stub_object_detection_frame_processing_duration_us",
+        "Time to build the metadata packet for a video frame, in microseconds.", labels);
+}
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,42 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "../metrics.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/** Per-camera metrics, registered in MetricsRegistry for as long as the DeviceAgent lives. */
+struct DetectionMetrics
+{
+    explicit DetectionMetrics(const std::string& cameraId);
+
+    std::shared_ptr<Counter> frames;
+    std::shared_ptr<Counter> messages; //< Parsed, received over any transport.
+    std::shared_ptr<Counter> parseFailures;
+    std::shared_ptr<Counter> duplicateMessages; //< Redelivered by the broker, already received.
+    std::shared_ptr<Counter> droppedBatches; //< Evicted or stale before a frame matched them.
+    std::shared_ptr<Counter> filteredDetections; //< Of object types disabled in the settings.
+    std::shared_ptr<Counter> roiFilteredDetections; //< Outside the regions of interest.
+    std::shared_ptr<Counter> lineCrossings; //< Reported as events.
+    std::shared_ptr<Counter> zoneEvents; //< Starts and finishes of occupancy and dwell events.
+    std::shared_ptr<Counter> bestShots;
+    std::shared_ptr<Counter> packets;
+    std::shared_ptr<Counter> objects;
+    std::shared_ptr<Gauge> queueDepth; //< Timestamped batches waiting for their frame.
+    std::shared_ptr<Histogram> parseDurationUs;
+    std::shared_ptr<Histogram> frameProcessingDurationUs;
+};
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,58 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <nx/sdk/analytics/helpers/object_metadata.h>
+#include <nx/sdk/helpers/attribute.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/**
+ * ObjectMetadata for a detection, keeping its attributes at hand so that a recycled instance can
+ * be updated in place instead of being rebuilt.
+ */
+class DetectionObjectMetadata: public nx::sdk::analytics::ObjectMetadata
+{
+public:
+    enum class Attributes
+    {
+        none,
+        confidence,
+        confidenceAndName,
+    };
+
+    static constexpr int kAttributesVariantCount = 3;
+
+    explicit DetectionObjectMetadata(Attributes attributes)
+    {
+        if (attributes == Attributes::none)
+            return;
+
+        m_confidenceAttribute = nx::sdk::makePtr<nx::sdk::Attribute>("confidence", "");
+        addAttribute(m_confidenceAttribute);
+
+        if (attributes == Attributes::confidenceAndName)
+        {
+            m_nameAttribute = nx::sdk::makePtr<nx::sdk::Attribute>("name", "");
+            addAttribute(m_nameAttribute);
+        }
+    }
+
+    /** Null if the instance has no such attribute. */
+    nx::sdk::Attribute* confidenceAttribute() const { return m_confidenceAttribute.get(); }
+    nx::sdk::Attribute* nameAttribute() const { return m_nameAttribute.get(); }
+
+private:
+    nx::sdk::Ptr<nx::sdk::Attribute> m_confidenceAttribute;
+    nx::sdk::Ptr<nx::sdk::Attribute> m_nameAttribute;
+};
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,738 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "detection_parser.h"
+
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+#include <nx/kit/json.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/** Same limit as in nx::kit::Json. */
+static constexpr int kMaxDepth = 200;
+
+static const std::string kJsonErrorPrefix = "Failed to parse JSON: ";
+static const std::string kNoDetectionsError = "No 'detections' array found in message";
+
+// Depth of the values in the document, as counted by nx::kit::Json.
+static constexpr int kRootFieldDepth = 1;
+static constexpr int kDetectionDepth = 2;
+static constexpr int kDetectionFieldDepth = 3;
+static constexpr int kBoundingBoxItemDepth = 4;
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static bool isHexDigit(char c)
+{
+    return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static bool isNumberStart(char c)
+{
+    return c == '-' || isDigit(c);
+}
+
+static int hexDigitValue(char c)
+{
+    if (isDigit(c))
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return c - 'A' + 10;
+}
+
+/** Same encoding as in nx::kit::Json, including its treatment of unpaired surrogates. */
+static void appendUtf8(long codePoint, std::string* out)
+{
+    if (codePoint < 0)
+        return;
+
+    if (codePoint < 0x80)
+    {
+        *out += (char) codePoint;
+    }
+    else if (codePoint < 0x800)
+    {
+        *out += (char) ((codePoint >> 6) | 0xC0);
+        *out += (char) ((codePoint & 0x3F) | 0x80);
+    }
+    else if (codePoint < 0x10000)
+    {
+        *out += (char) ((codePoint >> 12) | 0xE0);
+        *out += (char) (((codePoint >> 6) & 0x3F) | 0x80);
+        *out += (char) ((codePoint & 0x3F) | 0x80);
+    }
+    else
+    {
+        *out += (char) ((codePoint >> 18) | 0xF0);
+        *out += (char) (((codePoint >> 12) & 0x3F) | 0x80);
+        *out += (char) (((codePoint >> 6) & 0x3F) | 0x80);
+        *out += (char) ((codePoint & 0x3F) | 0x80);
+    }
+}
+
+/** Same conversion as Json::int_value(), without the undefined behavior on overflow. */
+static int toInt(double value)
+{
+    if (value >= (double) INT_MAX)
+        return INT_MAX;
+    if (value <= (double) INT_MIN)
+        return INT_MIN;
+    return (int) value;
+}
+
+/** Values which are negative or do not fit into int64_t are treated as absent. */
+static int64_t toNonNegativeInt64(double value, int64_t absentValue)
+{
+    if (!(value >= 0.0 && value < 9.2e18))
+        return absentValue;
+    return (int64_t) value;
+}
+
+//-------------------------------------------------------------------------------------------------
+// DetectionParser
+
+bool DetectionParser::parse(
+    const char* data, size_t size, DetectionBatch* outBatch, std::string* outError)
+{
+    m_pos = data;
+    m_end = data + size;
+    m_error.clear();
+    outBatch->clear();
+
+    bool hasDetections = false;
+    if (!parseRoot(outBatch, &hasDetections))
+    {
+        *outError = m_error;
+        return false;
+    }
+
+    if (peekToken() != 0)
+    {
+        fail("unexpected trailing data");
+        *outError = m_error;
+        return false;
+    }
+
+    if (!hasDetections)
+    {
+        *outError = kNoDetectionsError;
+        return false;
+    }
+
+    return true;
+}
+
+bool DetectionParser::parseRoot(DetectionBatch* outBatch, bool* outHasDetections)
+{
+    if (peekToken() != '{')
+    {
+        if (!skipValue(/*depth*/ 0))
+            return false;
+        return fail("root is not a JSON object");
+    }
+    ++m_pos;
+
+    char c = nextToken();
+    if (c == '}')
+        return true;
+
+    for (;;)
+    {
+        if (c != '"')
+            return fail("expected '\"' in object");
+        if (!parseString(&m_key) || !expect(':'))
+            return false;
+
+        // The last duplicate key wins, as in nx::kit::Json.
+        if (m_key == "detections")
+        {
+            *outHasDetections = peekToken() == '[';
+            if (*outHasDetections)
+            {
+                ++m_pos;
+                outBatch->clearObjects();
+                if (!parseDetections(outBatch))
+                    return false;
+            }
+            else if (!skipValue(kRootFieldDepth))
+            {
+                return false;
+            }
+        }
+        else if (m_key == "timestampUs" || m_key == "trackEpoch" || m_key == "publishTimeUs")
+        {
+            double value = -1.0;
+            if (isNumberStart(peekToken()))
+            {
+                if (!parseNumber(&value))
+                    return false;
+            }
+            else if (!skipValue(kRootFieldDepth))
+            {
+                return false;
+            }
+
+            if (m_key == "timestampUs")
+                outBatch->setTimestampUs(toNonNegativeInt64(value, /*absentValue*/ -1));
+            else if (m_key == "trackEpoch")
+                outBatch->setTrackEpoch(toNonNegativeInt64(value, /*absentValue*/ 0));
+            else
+                outBatch->trace().publishedUs = toNonNegativeInt64(value, /*absentValue*/ 0);
+        }
+        else if (!skipValue(kRootFieldDepth))
+        {
+            return false;
+        }
+
+        c = nextToken();
+        if (c == '}')
+            return true;
+        if (c != ',')
+            return fail("expected ',' in object");
+        c = nextToken();
+    }
+}
+
+bool DetectionParser::parseDetections(DetectionBatch* outBatch)
+{
+    if (peekToken() == ']')
+    {
+        ++m_pos;
+        return true;
+    }
+
+    for (;;)
+    {
+        if (peekToken() == '{')
+        {
+            ++m_pos;
+            if (!parseDetection(outBatch))
+                return false;
+        }
+        else if (!skipValue(kDetectionDepth))
+        {
+            return false;
+        }
+
+        const char c = nextToken();
+        if (c == ']')
+            return true;
+        if (c != ',')
+            return fail("expected ',' in list");
+    }
+}
+
+bool DetectionParser::parseDetection(DetectionBatch* outBatch)
+{
+    DetectedObject& object = outBatch->append();
+    bool hasBoundingBox = false;
+
+    char c = nextToken();
+    if (c == '}')
+    {
+        outBatch->removeLast();
+        return true;
+    }
+
+    for (;;)
+    {
+        if (c != '"')
+            return fail("expected '\"' in object");
+        if (!parseString(&m_key) || !expect(':'))
+            return false;
+
+        // A field of a wrong type leaves the default value, as the last duplicate key wins.
+        const char valueStart = peekToken();
+        if (m_key == "label" || m_key == "name")
+        {
+            std::string* value = (m_key == "label") ? &object.label : &object.name;
+            value->clear();
+            if (valueStart == '"')
+            {
+                ++m_pos;
+                if (!parseString(value))
+                    return false;
+            }
+            else if (!skipValue(kDetectionFieldDepth))
+            {
+                return false;
+            }
+        }
+        else if (m_key == "confidence" || m_key == "trackId")
+        {
+            double value = 0.0;
+            if (isNumberStart(valueStart))
+            {
+                if (!parseNumber(&value))
+                    return false;
+            }
+            else if (!skipValue(kDetectionFieldDepth))
+            {
+                return false;
+            }
+
+            if (m_key == "confidence")
+                object.confidence = (float) value;
+            else
+                object.trackId = toInt(value);
+        }
+        else if (m_key == "bbox")
+        {
+            hasBoundingBox = false;
+            if (valueStart == '[')
+            {
+                ++m_pos;
+                if (!parseBoundingBox(&object, &hasBoundingBox))
+                    return false;
+            }
+            else if (!skipValue(kDetectionFieldDepth))
+            {
+                return false;
+            }
+        }
+        else if (!skipValue(kDetectionFieldDepth))
+        {
+            return false;
+        }
+
+        c = nextToken();
+        if (c == '}')
+            break;
+        if (c != ',')
+            return fail("expected ',' in object");
+        c = nextToken();
+    }
+
+    if (!hasBoundingBox)
+        outBatch->removeLast();
+
+    return true;
+}
+
+/** Takes the first 4 items; non-numeric items count as 0, as with Json::number_value(). */
+bool DetectionParser::parseBoundingBox(DetectedObject* outObject, bool* outIsValid)
+{
+    float* const coordinates[] = {
+        &outObject->x, &outObject->y, &outObject->width, &outObject->height};
+    int itemCount = 0;
+
+    if (peekToken() == ']')
+    {
+        ++m_pos;
+        *outIsValid = false;
+        return true;
+    }
+
+    for (;;)
+    {
+        double value = 0.0;
+        if (isNumberStart(peekToken()))
+        {
+            if (!parseNumber(&value))
+                return false;
+        }
+        else if (!skipValue(kBoundingBoxItemDepth))
+        {
+            return false;
+        }
+
+        if (itemCount < 4)
+            *coordinates[itemCount] = (float) value;
+        ++itemCount;
+
+        const char c = nextToken();
+        if (c == ']')
+            break;
+        if (c != ',')
+            return fail("expected ',' in list");
+    }
+
+    *outIsValid = itemCount >= 4;
+    return true;
+}
+
+/** Expects the opening quote to be consumed already. */
+bool DetectionParser::parseString(std::string* outValue)
+{
+    outValue->clear();
+    long lastEscapedCodePoint = -1;
+
+    for (;;)
+    {
+        const char* const runStart = m_pos;
+        while (m_pos != m_end && *m_pos != '"' && *m_pos != '\\'
+            && (unsigned char) *m_pos >= 0x20)
+        {
+            ++m_pos;
+        }
+
+        if (m_pos != runStart)
+        {
+            appendUtf8(lastEscapedCodePoint, outValue);
+            lastEscapedCodePoint = -1;
+            outValue->append(runStart, m_pos - runStart);
+        }
+
+        if (m_pos == m_end)
+            return fail("unexpected end of input in string");
+
+        const char c = *m_pos++;
+        if (c == '"')
+        {
+            appendUtf8(lastEscapedCodePoint, outValue);
+            return true;
+        }
+
+        if (c != '\\')
+            return fail("unescaped control character in string");
+
+        if (m_pos == m_end)
+            return fail("unexpected end of input in string");
+
+        const char escaped = *m_pos++;
+        if (escaped == 'u')
+        {
+            if (m_end - m_pos < 4)
+                return fail("bad \\u escape");
+
+            long codePoint = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                if (!isHexDigit(m_pos[i]))
+                    return fail("bad \\u escape");
+                codePoint = (codePoint << 4) | hexDigitValue(m_pos[i]);
+            }
+            m_pos += 4;
+
+            // Combine a surrogate pair into a single code point.
+            if (lastEscapedCodePoint >= 0xD800 && lastEscapedCodePoint <= 0xDBFF
+                && codePoint >= 0xDC00 && codePoint <= 0xDFFF)
+            {
+                appendUtf8(
+                    (((lastEscapedCodePoint - 0xD800) << 10) | (codePoint - 0xDC00)) + 0x10000,
+                    outValue);
+                lastEscapedCodePoint = -1;
+            }
+            else
+            {
+                appendUtf8(lastEscapedCodePoint, outValue);
+                lastEscapedCodePoint = codePoint;
+            }
+            continue;
+        }
+
+        appendUtf8(lastEscapedCodePoint, outValue);
+        lastEscapedCodePoint = -1;
+
+        switch (escaped)
+        {
+            case 'b': *outValue += '\b'; break;
+            case 'f': *outValue += '\f'; break;
+            case 'n': *outValue += '\n'; break;
+            case 'r': *outValue += '\r'; break;
+            case 't': *outValue += '\t'; break;
+            case '"': case '\\': case '/': *outValue += escaped; break;
+            default: return fail("invalid escape character in string");
+        }
+    }
+}
+
+/** Validates the number with the nx::kit::Json grammar, then converts it like it does. */
+bool DetectionParser::parseNumber(double* outValue)
+{
+    const char* const start = m_pos;
+    const auto current = [this]() { return m_pos == m_end ? '\0' : *m_pos; };
+
+    if (current() == '-')
+        ++m_pos;
+
+    if (current() == '0')
+    {
+        ++m_pos;
+        if (isDigit(current()))
+            return fail("leading 0s not permitted in numbers");
+    }
+    else if (current() >= '1' && current() <= '9')
+    {
+        while (isDigit(current()))
+            ++m_pos;
+    }
+    else
+    {
+        return fail("invalid character in number");
+    }
+
+    // Short integers are converted exactly as nx::kit::Json does, e.g. "-0" becomes 0.
+    static constexpr int kMaxIntDigits = 9;
+    if (current() != '.' && current() != 'e' && current() != 'E'
+        && m_pos - start <= kMaxIntDigits)
+    {
+        int value = 0;
+        for (const char* digit = (*start == '-') ? start + 1 : start; digit != m_pos; ++digit)
+            value = value * 10 + (*digit - '0');
+        *outValue = (*start == '-') ? -value : value;
+        return true;
+    }
+
+    if (current() == '.')
+    {
+        ++m_pos;
+        if (!isDigit(current()))
+            return fail("at least one digit required in fractional part");
+        while (isDigit(current()))
+            ++m_pos;
+    }
+
+    if (current() == 'e' || current() == 'E')
+    {
+        ++m_pos;
+        if (current() == '+' || current() == '-')
+            ++m_pos;
+        if (!isDigit(current()))
+            return fail("at least one digit required in exponent");
+        while (isDigit(current()))
+            ++m_pos;
+    }
+
+    // The payload is not null-terminated, so copy the number for strtod().
+    static constexpr size_t kMaxInlineLength = 63;
+    const size_t length = m_pos - start;
+    if (length <= kMaxInlineLength)
+    {
+        char buffer[kMaxInlineLength + 1];
+        memcpy(buffer, start, length);
+        buffer[length] = '\0';
+        *outValue = strtod(buffer, nullptr);
+    }
+    else
+    {
+        *outValue = strtod(std::string(start, length).c_str(), nullptr);
+    }
+
+    return true;
+}
+
+bool DetectionParser::skipValue(int depth)
+{
+    if (depth > kMaxDepth)
+        return fail("exceeded maximum nesting depth");
+
+    const char c = peekToken();
+    if (isNumberStart(c))
+    {
+        double unused;
+        return parseNumber(&unused);
+    }
+
+    if (nextToken() == 0)
+        return false;
+
+    switch (c)
+    {
+        case '"':
+            return parseString(&m_skippedString);
+
+        case 't':
+            return skipLiteral("rue", 3);
+
+        case 'f':
+            return skipLiteral("alse", 4);
+
+        case 'n':
+            return skipLiteral("ull", 3);
+
+        case '{':
+        {
+            char token = nextToken();
+            if (token == '}')
+                return true;
+            for (;;)
+            {
+                if (token != '"')
+                    return fail("expected '\"' in object");
+                if (!parseString(&m_skippedString) || !expect(':') || !skipValue(depth + 1))
+                    return false;
+
+                token = nextToken();
+                if (token == '}')
+                    return true;
+                if (token != ',')
+                    return fail("expected ',' in object");
+                token = nextToken();
+            }
+        }
+
+        case '[':
+        {
+            if (peekToken() == ']')
+            {
+                ++m_pos;
+                return true;
+            }
+            for (;;)
+            {
+                if (!skipValue(depth + 1))
+                    return false;
+
+                const char token = nextToken();
+                if (token == ']')
+                    return true;
+                if (token != ',')
+                    return fail("expected ',' in list");
+            }
+        }
+
+        default:
+            return fail("expected value");
+    }
+}
+
+bool DetectionParser::skipLiteral(const char* literal, size_t length)
+{
+    if ((size_t) (m_end - m_pos) < length || memcmp(m_pos, literal, length) != 0)
+        return fail("unexpected literal");
+
+    m_pos += length;
+    return true;
+}
+
+bool DetectionParser::expect(char expected)
+{
+    const char c = nextToken();
+    if (c == 0)
+        return false;
+    if (c != expected)
+        return fail("unexpected character");
+    return true;
+}
+
+/** @return Next non-whitespace character without consuming it, or 0 at the end. */
+char DetectionParser::peekToken()
+{
+    while (m_pos != m_end
+        && (*m_pos == ' ' || *m_pos == '\t' || *m_pos == '\r' || *m_pos == '\n'))
+    {
+        ++m_pos;
+    }
+
+    return m_pos == m_end ? 0 : *m_pos;
+}
+
+/** @return Next non-whitespace character (consumed), or 0 with the error set at the end. */
+char DetectionParser::nextToken()
+{
+    const char c = peekToken();
+    if (m_pos == m_end)
+    {
+        fail("unexpected end of input");
+        return 0;
+    }
+
+    ++m_pos;
+    return c;
+}
+
+bool DetectionParser::fail(const char* error)
+{
+    if (m_error.empty())
+        m_error = kJsonErrorPrefix + error;
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool parseDetectionsFromJsonTree(
+    const std::string& message, DetectionBatch* outBatch, std::string* outError)
+{
+    outBatch->clear();
+
+    std::string parseError;
+    nx::kit::Json data = nx::kit::Json::parse(message, parseError);
+
+    if (!parseError.empty() || !data.is_object())
+    {
+        *outError = kJsonErrorPrefix + parseError;
+        return false;
+    }
+
+    auto obj = data.object_items();
+
+    if (obj.count("detections") == 0 || !obj["detections"].is_array())
+    {
+        *outError = kNoDetectionsError;
+        return false;
+    }
+
+    if (obj.count("timestampUs") > 0 && obj["timestampUs"].is_number())
+    {
+        outBatch->setTimestampUs(
+            toNonNegativeInt64(obj["timestampUs"].number_value(), /*absentValue*/ -1));
+    }
+
+    if (obj.count("trackEpoch") > 0 && obj["trackEpoch"].is_number())
+    {
+        outBatch->setTrackEpoch(
+            toNonNegativeInt64(obj["trackEpoch"].number_value(), /*absentValue*/ 0));
+    }
+
+    if (obj.count("publishTimeUs") > 0 && obj["publishTimeUs"].is_number())
+    {
+        outBatch->trace().publishedUs =
+            toNonNegativeInt64(obj["publishTimeUs"].number_value(), /*absentValue*/ 0);
+    }
+
+    for (const auto& detection : obj["detections"].array_items())
+    {
+        if (!detection.is_object())
+            continue;
+
+        auto detObj = detection.object_items();
+
+        DetectedObject& detected = outBatch->append();
+
+        if (detObj.count("label") > 0 && detObj["label"].is_string())
+            detected.label = detObj["label"].string_value();
+
+        if (detObj.count("confidence") > 0 && detObj["confidence"].is_number())
+            detected.confidence = detObj["confidence"].number_value();
+
+        if (detObj.count("trackId") > 0 && detObj["trackId"].is_number())
+            detected.trackId = detObj["trackId"].int_value();
+
+        if (detObj.count("name") > 0 && detObj["name"].is_string())
+            detected.name = detObj["name"].string_value();
+
+        auto bbox = detObj.count("bbox") > 0 && detObj["bbox"].is_array()
+            ? detObj["bbox"].array_items()
+            : nx::kit::Json::array();
+        if (bbox.size() >= 4)
+        {
+            detected.x = bbox[0].number_value();
+            detected.y = bbox[1].number_value();
+            detected.width = bbox[2].number_value();
+            detected.height = bbox[3].number_value();
+        }
+        else
+        {
+            outBatch->removeLast();
+        }
+    }
+
+    return true;
+}
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
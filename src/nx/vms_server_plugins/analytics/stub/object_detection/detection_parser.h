@@ -0,0 +1,72 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "detection_batch.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/**
+ * Single-pass parser for the detection message schema:
+ * `{"detections": [{"label", "confidence", "bbox": [x, y, width, height], "trackId", "name"}]}`,
+ * optionally with root `"timestampUs"` (timestamp of the source video frame), `"trackEpoch"` and
+ * `"publishTimeUs"` (wall clock time of publishing, see DetectionTrace) fields.
+ *
+ * Reads the payload in place and fills a reusable DetectionBatch, without building a JSON tree.
+ * Accepts and rejects the same documents as nx::kit::Json, and extracts the same values as
+ * parseDetectionsFromJsonTree(): unknown fields are skipped, fields of a wrong type are ignored,
+ * detections which are not objects or lack a 4-item bbox are dropped.
+ *
+ * Not thread-safe; keep one instance per thread.
+ */
+class DetectionParser
+{
+public:
+    /**
+     * @param outBatch Cleared and filled; holds garbage if false is returned.
+     * @param outError Description of the problem if false is returned.
+     */
+    bool parse(const char* data, size_t size, DetectionBatch* outBatch, std::string* outError);
+
+private:
+    bool parseRoot(DetectionBatch* outBatch, bool* outHasDetections);
+    bool parseDetections(DetectionBatch* outBatch);
+    bool parseDetection(DetectionBatch* outBatch);
+    bool parseBoundingBox(DetectedObject* outObject, bool* outIsValid);
+
+    bool parseString(std::string* outValue);
+    bool parseNumber(double* outValue);
+    bool skipValue(int depth);
+    bool skipLiteral(const char* literal, size_t length);
+    bool expect(char expected);
+    char peekToken();
+    char nextToken();
+    bool fail(const char* error);
+
+private:
+    const char* m_pos = nullptr;
+    const char* m_end = nullptr;
+    std::string m_key; //< Scratch buffer reused for object keys.
+    std::string m_skippedString; //< Scratch buffer reused for string values of unknown fields.
+    std::string m_error;
+};
+
+/**
+ * Reference implementation on top of nx::kit::Json, kept for comparing DetectionParser against
+ * it (see tools/detection_parser_benchmark.cpp).
+ */
+bool parseDetectionsFromJsonTree(
+    const std::string& message, DetectionBatch* outBatch, std::string* outError);
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
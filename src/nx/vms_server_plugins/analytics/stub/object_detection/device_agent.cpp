@@ -4,12 +4,18 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstring>
 
+#include <nx/sdk/analytics/helpers/event_metadata.h>
+#include <nx/sdk/analytics/helpers/event_metadata_packet.h>
 #include <nx/sdk/analytics/helpers/object_metadata.h>
 #include <nx/sdk/analytics/helpers/object_metadata_packet.h>
+#include <nx/sdk/analytics/helpers/object_track_best_shot_packet.h>
 
 #include "device_agent_manifest.h"
+#include "latency_tracer.h"
 #include "object_attributes.h"
+#include "../logging.h"
 #include "../utils.h"
 #include "stub_analytics_plugin_object_detection_ini.h"
 
@@ -32,8 +38,25 @@ static constexpr float kMaxBoundingBoxWidth = 0.5F;
 static constexpr float kMaxBoundingBoxHeight = 0.5F;
 static constexpr float kFreeSpace = 0.1F;
 const std::string DeviceAgent::kTimeShiftSetting = "timestampShiftMs";
+const std::string DeviceAgent::kTimestampToleranceSetting = "detectionTimestampToleranceMs";
+const std::string DeviceAgent::kTransportSetting = "detectionTransport";
+const std::string DeviceAgent::kMotionPredictionHorizonSetting = "motionPredictionHorizonMs";
+const std::string DeviceAgent::kMqttTransport = "MQTT";
+const std::string DeviceAgent::kSharedMemoryTransport = "Shared memory";
 const std::string DeviceAgent::kSendAttributesSetting = "sendAttributes";
 const std::string DeviceAgent::kObjectTypeGenerationSettingPrefix = "objectTypeIdToGenerate.";
+const std::string DeviceAgent::kIncludedAreaSettingPrefix = "includedArea";
+const std::string DeviceAgent::kExcludedAreaSettingPrefix = "excludedArea";
+const std::string DeviceAgent::kRoiCoverageSetting = "roiMinCoveragePercent";
+const std::string DeviceAgent::kCrossingLineSettingPrefix = "crossingLine";
+const std::string DeviceAgent::kLineCrossingEventType = "nx.stub.objectDetection.lineCrossing";
+const std::string DeviceAgent::kOccupancyZoneSettingPrefix = "occupancyZone";
+const std::string DeviceAgent::kZoneMaxObjectsSettingSuffix = ".maxObjects";
+const std::string DeviceAgent::kZoneMaxDwellSettingSuffix = ".maxDwellS";
+const std::string DeviceAgent::kZoneOccupancyEventType = "nx.stub.objectDetection.zoneOccupancy";
+const std::string DeviceAgent::kZoneDwellEventType = "nx.stub.objectDetection.zoneDwell";
+const std::string DeviceAgent::kSendBestShotsSetting = "sendBestShots";
+const std::string DeviceAgent::kBestShotDeadlineSetting = "bestShotDeadlineMs";
 
 static Rect generateBoundingBox(int frameIndex, int trackIndex, int trackCount)
 {
@@ -79,12 +102,69 @@ static std::vector<Ptr<ObjectMetadata>> generateObjects(
 
 Ptr<IMetadataPacket> DeviceAgent::generateObjectMetadataPacket(int64_t frameTimestampUs)
 {
-    auto metadataPacket = makePtr<ObjectMetadataPacket>();
-    metadataPacket->setTimestampUs(frameTimestampUs);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_shmReader)
+            m_shmReader->poll(m_detectionInbox.get());
+    }
 
     // Check if MQTT is active (ever received any message)
-    bool hasMqttConnection = m_mqttReceiver->hasReceivedData();
-    std::vector<DetectedObject> mqttDetections = m_mqttReceiver->getAndClearDetectedObjects();
+    bool hasMqttConnection = m_detectionInbox->hasReceivedData();
+    const bool hasNewDetections = m_detectionInbox->takeDetectedObjects(
+        frameTimestampUs, m_timestampToleranceMs * 1000LL, &m_detections);
+    if (hasNewDetections && m_latencyTracer)
+    {
+        m_detections.trace().matchedUs = traceTimeUs();
+        m_isTracePending = true;
+    }
+
+    // Detections carrying the timestamp of their source frame need no manual shift.
+    const int64_t detectionTimestampUs = m_detections.timestampUs() >= 0
+        ? m_detections.timestampUs()
+        : frameTimestampUs + m_timestampShiftMs * 1000;
+
+    // Everything keyed by the tracks, from their UUIDs on, sees the epoch of the track table.
+    if (hasNewDetections)
+    {
+        m_detections.setTrackEpoch(
+            m_trackTable.trackEpoch(m_detections.trackEpoch(), detectionTimestampUs));
+    }
+
+    int64_t packetTimestampUs = detectionTimestampUs;
+    const DetectionBatch* detectionsToSend = &m_detections;
+    if (hasNewDetections)
+    {
+        m_lineCrossingDetector.update(m_detections, detectionTimestampUs);
+        if (!m_lineCrossingDetector.crossings().empty())
+            m_lineCrossingTimestampUs = detectionTimestampUs;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (hasNewDetections)
+            m_zoneMonitor.update(m_detections, detectionTimestampUs);
+        else
+            m_zoneMonitor.advance(frameTimestampUs); //< Dwell times grow between batches too.
+        updateBestShotSelector(hasNewDetections, detectionTimestampUs, frameTimestampUs);
+    }
+
+    const int motionPredictionHorizonMs = m_motionPredictionHorizonMs;
+    if (motionPredictionHorizonMs > 0)
+    {
+        // Boxes are moved to where the objects are on this frame, for every frame.
+        if (hasNewDetections)
+            m_trackPredictor.update(m_detections, detectionTimestampUs);
+        m_trackPredictor.predict(
+            frameTimestampUs, motionPredictionHorizonMs * 1000LL, &m_predictedDetections);
+        packetTimestampUs = frameTimestampUs;
+        detectionsToSend = &m_predictedDetections;
+    }
+    const DetectionBatch& mqttDetections = *detectionsToSend;
+
+    // Packets released by the Server drop their objects, so that those can be recycled as well.
+    m_packetPool.forEachFree([](ObjectMetadataPacket* packet) { packet->clear(); });
+    auto metadataPacket = m_packetPool.acquire([]() { return makePtr<ObjectMetadataPacket>(); });
+    metadataPacket->setTimestampUs(packetTimestampUs);
     
     if (hasMqttConnection)
     {
@@ -96,37 +176,38 @@ Ptr<IMetadataPacket> DeviceAgent::generateObjectMetadataPacket(int64_t frameTime
             
             //NX_PRINT << "Using MQTT detections: " << mqttDetections.size() << " objects";
             
-            // Store objects in vector to prevent destruction before addItem
-            std::vector<Ptr<ObjectMetadata>> mqttObjects;
-            
             for (const auto& detection : mqttDetections)
             {
-                // Map MQTT label to VMS object type ID
-                std::string objectTypeId;
-                std::string label = detection.label;
-                
-                // Convert label to lowercase for comparison
-                std::transform(label.begin(), label.end(), label.begin(), ::tolower);
-                
-                // Capitalize first letter for nx.base format
-                std::string capitalizedLabel = label;
-                if (!capitalizedLabel.empty())
-                    capitalizedLabel[0] = std::toupper(capitalizedLabel[0]);
-                
-                // All labels use nx.base.{Label} format
-                objectTypeId = "nx.base." + capitalizedLabel;
-                
-                //NX_PRINT << "MQTT label '" << label << "' -> object type: " << objectTypeId;
-                
-                // Check if this object type is enabled in settings
-                if (!m_objectTypeIdsToGenerate.empty() && 
-                    m_objectTypeIdsToGenerate.find(objectTypeId) == m_objectTypeIdsToGenerate.end())
+                // Map MQTT label to VMS object type ID; null if the type is disabled in settings.
+                const std::string* objectTypeId =
+                    m_objectTypeMap.enabledObjectTypeId(detection.label);
+                if (!objectTypeId)
                 {
-                    continue; // Skip this object if not enabled
+                    m_metrics->filteredDetections->add();
+                    continue;
                 }
-                
-                auto objectMetadata = makePtr<ObjectMetadata>();
-                objectMetadata->setTypeId(objectTypeId);
+
+                if (!m_roiFilter.isEmpty() && !m_roiFilter.isAccepted(
+                    detection.x, detection.y, detection.width, detection.height))
+                {
+                    m_metrics->roiFilteredDetections->add();
+                    continue;
+                }
+
+                // Add attributes if enabled (like fake generation)
+                using Attributes = DetectionObjectMetadata::Attributes;
+                const Attributes attributes = !m_sendAttributes
+                    ? Attributes::none
+                    : (detection.name.empty()
+                        ? Attributes::confidence
+                        : Attributes::confidenceAndName);
+
+                const auto objectMetadata = m_objectPools[(int) attributes].acquire(
+                    [attributes]() { return makePtr<DetectionObjectMetadata>(attributes); });
+
+                // Recycled objects mostly keep their type; avoid copying the string then.
+                if (strcmp(objectMetadata->typeId(), objectTypeId->c_str()) != 0)
+                    objectMetadata->setTypeId(*objectTypeId);
                 
                 // Set bounding box from detection
                 Rect boundingBox;
@@ -136,38 +217,25 @@ Ptr<IMetadataPacket> DeviceAgent::generateObjectMetadataPacket(int64_t frameTime
                 boundingBox.height = detection.height;
                 objectMetadata->setBoundingBox(boundingBox);
                 
-                // Set track ID from detection (MUST use UUID like fake generation)
-                objectMetadata->setTrackId(trackIdByTrackIndex(detection.trackId - 1));
+                // The same upstream track always maps to the same UUID.
+                objectMetadata->setTrackId(m_trackTable.trackUuid(
+                    detection.trackId, mqttDetections.trackEpoch(), packetTimestampUs));
                 
                 // Set confidence like fake generation (1.0 default)
                 objectMetadata->setConfidence(detection.confidence);
                 
-                // Add attributes if enabled (like fake generation)
-                if (m_sendAttributes)
-                {
-                    objectMetadata->addAttribute(makePtr<Attribute>(
-                        "confidence",
-                        std::to_string(detection.confidence)));
-                    
-                    // Add name attribute if provided
-                    if (!detection.name.empty())
-                    {
-                        objectMetadata->addAttribute(makePtr<Attribute>(
-                            "name",
-                            detection.name));
-                    }
-                }
-                
-                mqttObjects.push_back(std::move(objectMetadata));
-            }
-            
-            // Add all MQTT objects to packet (IMPORTANT: do this AFTER loop)
-            for (const auto& obj : mqttObjects)
-            {
-                metadataPacket->addItem(obj.get());
+                if (Attribute* const attribute = objectMetadata->confidenceAttribute())
+                    attribute->setValue(std::to_string(detection.confidence));
+
+                // Add name attribute if provided
+                Attribute* const nameAttribute = objectMetadata->nameAttribute();
+                if (nameAttribute && detection.name != nameAttribute->value())
+                    nameAttribute->setValue(detection.name);
+
+                metadataPacket->addItem(objectMetadata.get());
             }
             
-            //NX_PRINT << "Added " << mqttObjects.size() << " MQTT objects to packet";
+            //NX_PRINT << "Added " << metadataPacket->count() << " MQTT objects to packet";
         }
         else
         {
@@ -182,35 +250,206 @@ Ptr<IMetadataPacket> DeviceAgent::generateObjectMetadataPacket(int64_t frameTime
         // Không thêm objects nào vào metadataPacket
     }
 
+    m_metrics->objects->add((uint64_t) metadataPacket->count());
+    reportMetadataAllocations();
+
     return metadataPacket;
 }
 
-DeviceAgent::DeviceAgent(const nx::sdk::IDeviceInfo* deviceInfo):
-    ConsumingDeviceAgent(deviceInfo, ini().enableOutput)
+Ptr<IMetadataPacket> DeviceAgent::generateLineCrossingEventPacket()
+{
+    if (m_lineCrossingTimestampUs < 0)
+        return nullptr;
+
+    auto eventPacket = makePtr<EventMetadataPacket>();
+    eventPacket->setTimestampUs(m_lineCrossingTimestampUs);
+    eventPacket->setDurationUs(0);
+    m_lineCrossingTimestampUs = -1;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const LineCrossingDetector::Crossing& crossing: m_lineCrossingDetector.crossings())
+    {
+        // Crossings of the object types disabled in the settings are not reported either.
+        const DetectedObject& object = m_detections[crossing.objectIndex];
+        const std::string* objectTypeId = m_objectTypeMap.enabledObjectTypeId(object.label);
+        if (!objectTypeId)
+            continue;
+
+        const GeometrySet::Figure& line = *crossing.line;
+        const std::string& lineCaption = line.label.empty() ? line.name : line.label;
+        const std::string direction =
+            crossing.direction == GeometrySet::Direction::left ? "left" : "right";
+
+        auto eventMetadata = makePtr<EventMetadata>();
+        eventMetadata->setTypeId(kLineCrossingEventType);
+        eventMetadata->setCaption("Line crossing: " + lineCaption);
+        eventMetadata->setDescription(
+            *objectTypeId + " crossed " + lineCaption + " to the " + direction);
+        eventMetadata->setIsActive(false);
+        eventMetadata->setTrackId(m_trackTable.trackUuid(
+            object.trackId, m_detections.trackEpoch(), eventPacket->timestampUs()));
+        eventMetadata->setConfidence(object.confidence);
+        eventMetadata->addAttribute(makePtr<Attribute>("Line", lineCaption));
+        eventMetadata->addAttribute(makePtr<Attribute>("Direction", direction));
+        eventMetadata->addAttribute(makePtr<Attribute>("Object type", *objectTypeId));
+        eventPacket->addItem(eventMetadata.get());
+    }
+
+    if (eventPacket->count() == 0)
+        return nullptr;
+
+    m_metrics->lineCrossings->add((uint64_t) eventPacket->count());
+    return eventPacket;
+}
+
+Ptr<IMetadataPacket> DeviceAgent::generateZoneEventPacket()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const std::vector<ZoneMonitor::Event>& events = m_zoneMonitor.events();
+    if (events.empty())
+        return nullptr;
+
+    auto eventPacket = makePtr<EventMetadataPacket>();
+    eventPacket->setTimestampUs(events.front().timestampUs);
+    eventPacket->setDurationUs(0);
+
+    for (const ZoneMonitor::Event& event: events)
+    {
+        auto eventMetadata = makePtr<EventMetadata>();
+        eventMetadata->setIsActive(event.isActive);
+        eventMetadata->addAttribute(makePtr<Attribute>("Zone", event.zoneName));
+
+        // Starts and finishes of the same event share the key.
+        if (event.kind == ZoneMonitor::EventKind::occupancy)
+        {
+            eventMetadata->setTypeId(kZoneOccupancyEventType);
+            eventMetadata->setKey("occupancy:" + event.zoneId);
+            eventMetadata->setCaption("Zone occupancy: " + event.zoneName);
+            eventMetadata->setDescription(
+                std::to_string(event.objectCount) + " objects in " + event.zoneName);
+            eventMetadata->addAttribute(
+                makePtr<Attribute>("Object count", std::to_string(event.objectCount)));
+        }
+        else
+        {
+            const Uuid trackId =
+                TrackTable::deriveUuid(m_cameraId, event.trackId, event.trackEpoch);
+            const std::string dwellS = std::to_string(event.dwellUs / 1000000);
+
+            eventMetadata->setTypeId(kZoneDwellEventType);
+            eventMetadata->setKey(
+                "dwell:" + event.zoneId + ":" + UuidHelper::toStdString(trackId));
+            eventMetadata->setTrackId(trackId);
+            eventMetadata->setCaption("Dwell in zone: " + event.zoneName);
+            eventMetadata->setDescription(
+                "Object in " + event.zoneName + " for " + dwellS + " s");
+            eventMetadata->addAttribute(makePtr<Attribute>("Dwell time, s", dwellS));
+        }
+        eventPacket->addItem(eventMetadata.get());
+    }
+
+    m_metrics->zoneEvents->add((uint64_t) events.size());
+    m_zoneMonitor.clearEvents();
+    return eventPacket;
+}
+
+void DeviceAgent::updateBestShotSelector(
+    bool hasNewDetections, int64_t detectionTimestampUs, int64_t frameTimestampUs)
+{
+    if (!m_sendBestShots)
+        return;
+
+    const int64_t deadlineUs = m_bestShotDeadlineMs * 1000LL;
+    if (!hasNewDetections)
+    {
+        m_bestShotSelector.advance(frameTimestampUs, deadlineUs);
+        return;
+    }
+
+    // Only the detections which are sent to the Server can have their best shot.
+    for (const DetectedObject& detection: m_detections)
+    {
+        if (!m_objectTypeMap.enabledObjectTypeId(detection.label))
+            continue;
+        if (!m_roiFilter.isEmpty() && !m_roiFilter.isAccepted(
+            detection.x, detection.y, detection.width, detection.height))
+        {
+            continue;
+        }
+        m_bestShotSelector.addCandidate(detection);
+    }
+    m_bestShotSelector.update(m_detections.trackEpoch(), detectionTimestampUs, deadlineUs);
+}
+
+std::vector<Ptr<IObjectTrackBestShotPacket>> DeviceAgent::generateBestShotPackets()
+{
+    std::vector<Ptr<IObjectTrackBestShotPacket>> packets;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const BestShotSelector::BestShot& bestShot: m_bestShotSelector.bestShots())
+    {
+        // No image: the Server takes the frame of the timestamp and crops the box from it.
+        packets.push_back(makePtr<ObjectTrackBestShotPacket>(
+            TrackTable::deriveUuid(m_cameraId, bestShot.trackId, bestShot.trackEpoch),
+            bestShot.timestampUs,
+            Rect(bestShot.x, bestShot.y, bestShot.width, bestShot.height)));
+    }
+
+    m_metrics->bestShots->add((uint64_t) packets.size());
+    m_bestShotSelector.clearBestShots();
+    return packets;
+}
+
+void DeviceAgent::reportMetadataAllocations()
+{
+    int64_t allocationCount = m_packetPool.allocationCount();
+    for (const auto& pool: m_objectPools)
+        allocationCount += pool.allocationCount();
+
+    // Silent in the steady state, when all metadata is recycled.
+    if (allocationCount == m_reportedMetadataAllocationCount)
+        return;
+
+    STUB_LOG(LogLevel::debug)
+        << "Metadata objects and packets allocated so far: " << allocationCount;
+    m_reportedMetadataAllocationCount = allocationCount;
+}
+
+/** MQTT topics use the camera id without curly braces. */
+static std::string cameraIdForTopic(std::string cameraId)
 {
-    // Get camera ID and create topic specific to this camera
-    std::string cameraId = deviceInfo->id();
-    
     // Remove curly braces from UUID if present
     if (!cameraId.empty() && cameraId.front() == '{')
         cameraId = cameraId.substr(1, cameraId.length() - 2);
-    
-    std::string topic = "vms/ai/detections/" + cameraId;
-    
-    //NX_PRINT << "Camera ID: " << cameraId;
-    //NX_PRINT << "MQTT Topic: " << topic;
-    
-    // Initialize MQTT receiver to get AI detections for this specific camera
-    m_mqttReceiver = std::make_unique<MqttObjectReceiver>("192.168.1.215", 1883, topic);
-    m_mqttReceiver->start();
+
+    return cameraId;
+}
+
+DeviceAgent::DeviceAgent(Engine* engine, const nx::sdk::IDeviceInfo* deviceInfo):
+    ConsumingDeviceAgent(deviceInfo, ini().enableOutput),
+    m_engine(engine),
+    m_cameraId(cameraIdForTopic(deviceInfo->id())),
+    m_trackTable(m_cameraId, ini().trackTableCapacity, ini().trackTtlMs * 1000LL),
+    m_objectTypeMap(ini().objectTypeMapping, ini().unknownLabelObjectTypeId),
+    m_geometryStore(engine->figureTypes()),
+    m_lineCrossingDetector(&m_geometryStore, kCrossingLineSettingPrefix,
+        ini().trackTableCapacity, ini().trackTtlMs * 1000LL),
+    m_zoneMonitor(ini().trackTableCapacity, ini().zoneReleaseDelayMs * 1000LL),
+    m_bestShotSelector(ini().trackTableCapacity, ini().bestShotTrackEndMs * 1000LL),
+    m_metrics(std::make_shared<DetectionMetrics>(m_cameraId)),
+    m_detectionInbox(std::make_shared<DetectionInbox>(ini().detectionBufferCapacity, m_metrics))
+{
+    if (ini().enableLatencyTracing)
+        m_latencyTracer = std::make_unique<LatencyTracer>(m_cameraId, engine->latencyTraceWriter());
+
+    // Receive AI detections for this specific camera over the Engine-wide connection, until the
+    // settings select another transport.
+    setTransport(kMqttTransport);
 }
 
 DeviceAgent::~DeviceAgent()
 {
-    if (m_mqttReceiver)
-    {
-        m_mqttReceiver->stop();
-    }
+    m_engine->mqttReceiver()->unregisterInbox(m_cameraId, m_detectionInbox);
 }
 
 std::string DeviceAgent::manifestString() const
@@ -220,17 +459,36 @@ std::string DeviceAgent::manifestString() const
 
 bool DeviceAgent::pushCompressedVideoFrame(const ICompressedVideoPacket* videoFrame)
 {
+    const auto startTime = std::chrono::steady_clock::now();
+
     ++m_frameIndex;
-    if (m_trackIds.size() > 100)
-    {
-        m_trackIds.clear();
-    }
+    m_metrics->frames->add();
+    m_trackTable.removeExpired(videoFrame->timestampUs());
 
     Ptr<IMetadataPacket> objectMetadataPacket = generateObjectMetadataPacket(
-        videoFrame->timestampUs() + m_timestampShiftMs * 1000);
+        videoFrame->timestampUs());
+
+    m_metrics->frameProcessingDurationUs->record(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - startTime).count());
+    m_metrics->packets->add();
+
+    if (m_isTracePending)
+    {
+        m_detections.trace().pushedUs = traceTimeUs();
+        m_latencyTracer->record(m_detections.trace());
+        m_isTracePending = false;
+    }
 
     pushMetadataPacket(objectMetadataPacket.releasePtr());
 
+    if (Ptr<IMetadataPacket> eventPacket = generateLineCrossingEventPacket())
+        pushMetadataPacket(eventPacket.releasePtr());
+    if (Ptr<IMetadataPacket> eventPacket = generateZoneEventPacket())
+        pushMetadataPacket(eventPacket.releasePtr());
+    for (Ptr<IObjectTrackBestShotPacket>& bestShotPacket: generateBestShotPackets())
+        pushMetadataPacket(bestShotPacket.releasePtr());
+
     return true;
 }
 
@@ -244,7 +502,7 @@ nx::sdk::Result<const nx::sdk::ISettingsResponse*> DeviceAgent::settingsReceived
 {
     const std::lock_guard<std::mutex> lock(m_mutex);
 
-    m_objectTypeIdsToGenerate.clear();
+    std::set<std::string> objectTypeIdsToGenerate;
 
     const std::map<std::string, std::string>& settings = currentSettings();
     for (const auto& entry: settings)
@@ -254,33 +512,130 @@ nx::sdk::Result<const nx::sdk::ISettingsResponse*> DeviceAgent::settingsReceived
         if (startsWith(key, kObjectTypeGenerationSettingPrefix) && toBool(value))
         {
             std::string objectType = key.substr(kObjectTypeGenerationSettingPrefix.size());
-            m_objectTypeIdsToGenerate.insert(objectType);
+            objectTypeIdsToGenerate.insert(objectType);
             //NX_PRINT << "Enabled object type: " << objectType;
         }
         else if (key == kSendAttributesSetting)
             m_sendAttributes = toBool(value);
         else if (key == kTimeShiftSetting)
             m_timestampShiftMs = std::stoi(value);
+        else if (key == kTimestampToleranceSetting)
+            m_timestampToleranceMs = std::stoi(value);
+        else if (key == kTransportSetting)
+            setTransport(value);
+        else if (key == kMotionPredictionHorizonSetting)
+            m_motionPredictionHorizonMs = std::stoi(value);
+        else if (key == kSendBestShotsSetting)
+            m_sendBestShots = toBool(value);
+        else if (key == kBestShotDeadlineSetting)
+            m_bestShotDeadlineMs = std::stoi(value);
     }
+
+    // Tracks seen while best shots were off would get a best shot from their remainder only.
+    if (!m_sendBestShots)
+        m_bestShotSelector.reset();
+
+    // Settings arrive as a whole; recompile what depends on the figures only if they are edited.
+    const bool areFiguresChanged = m_geometryStore.update(settings);
+    updateRoiFilter(settings, areFiguresChanged);
+    updateZoneMonitor(settings, areFiguresChanged);
     
-    //NX_PRINT << "Total enabled object types: " << m_objectTypeIdsToGenerate.size();
+    //NX_PRINT << "Total enabled object types: " << objectTypeIdsToGenerate.size();
+
+    m_objectTypeMap.setEnabledObjectTypeIds(std::move(objectTypeIdsToGenerate));
 
     return nullptr;
 }
 
-Uuid DeviceAgent::trackIdByTrackIndex(int trackIndex)
+void DeviceAgent::updateRoiFilter(
+    const std::map<std::string, std::string>& settings, bool areFiguresChanged)
 {
-    // Use map to avoid creating thousands of unused UUIDs
-    auto it = m_trackIds.find(trackIndex);
-    if (it != m_trackIds.end())
+    const auto coverageSetting = settings.find(kRoiCoverageSetting);
+    const int minCoveragePercent =
+        coverageSetting != settings.end() ? std::stoi(coverageSetting->second) : 50;
+
+    if (!areFiguresChanged && minCoveragePercent == m_roiMinCoveragePercent)
+        return;
+    m_roiMinCoveragePercent = minCoveragePercent;
+
+    const std::shared_ptr<const GeometrySet> geometry = m_geometryStore.current();
+    std::vector<RoiFilter::Polygon> includedZones;
+    std::vector<RoiFilter::Polygon> excludedZones;
+    for (const GeometrySet::Figure& figure: geometry->figures())
     {
-        return it->second;
+        if (figure.type == GeometrySet::FigureType::line)
+            continue;
+        if (startsWith(figure.name, kIncludedAreaSettingPrefix))
+            includedZones.push_back(geometry->outline(figure));
+        else if (startsWith(figure.name, kExcludedAreaSettingPrefix))
+            excludedZones.push_back(geometry->outline(figure));
+    }
+
+    m_roiFilter.setZones(includedZones, excludedZones, minCoveragePercent / 100.0F);
+    STUB_LOG(LogLevel::info) << "Regions of interest: " << includedZones.size()
+        << " included, " << excludedZones.size() << " excluded, min coverage "
+        << minCoveragePercent << "%";
+}
+
+void DeviceAgent::updateZoneMonitor(
+    const std::map<std::string, std::string>& settings, bool areFiguresChanged)
+{
+    const auto intSetting =
+        [&settings](const std::string& name)
+        {
+            const auto setting = settings.find(name);
+            return setting != settings.end() ? std::stoi(setting->second) : 0;
+        };
+
+    // Max object count and max dwell time of each zone, in turn.
+    std::vector<int> zoneThresholds;
+    for (int i = 1; i <= kOccupancyZoneCount; ++i)
+    {
+        const std::string prefix = kOccupancyZoneSettingPrefix + std::to_string(i);
+        zoneThresholds.push_back(intSetting(prefix + kZoneMaxObjectsSettingSuffix));
+        zoneThresholds.push_back(intSetting(prefix + kZoneMaxDwellSettingSuffix));
+    }
+    if (!areFiguresChanged && zoneThresholds == m_zoneThresholds)
+        return;
+    m_zoneThresholds = zoneThresholds;
+
+    const std::shared_ptr<const GeometrySet> geometry = m_geometryStore.current();
+    std::vector<ZoneMonitor::Zone> zones;
+    for (int i = 1; i <= kOccupancyZoneCount; ++i)
+    {
+        ZoneMonitor::Zone zone;
+        zone.figure = geometry->find(kOccupancyZoneSettingPrefix + std::to_string(i) + ".figure");
+        zone.maxObjectCount = zoneThresholds[(i - 1) * 2];
+        zone.maxDwellUs = zoneThresholds[(i - 1) * 2 + 1] * 1000000LL;
+        if (zone.figure && zone.figure->type != GeometrySet::FigureType::line
+            && (zone.maxObjectCount > 0 || zone.maxDwellUs > 0))
+        {
+            zones.push_back(zone);
+        }
+    }
+
+    STUB_LOG(LogLevel::info) << "Occupancy zones: " << zones.size();
+    m_zoneMonitor.setZones(geometry, std::move(zones));
+}
+
+void DeviceAgent::setTransport(const std::string& transport)
+{
+    if (transport == m_transport)
+        return;
+
+    m_transport = transport;
+    m_detectionInbox->reset();
+
+    if (transport == kSharedMemoryTransport)
+    {
+        m_engine->mqttReceiver()->unregisterInbox(m_cameraId, m_detectionInbox);
+        m_shmReader = std::make_unique<ShmDetectionReader>(m_cameraId);
+    }
+    else
+    {
+        m_shmReader.reset();
+        m_engine->mqttReceiver()->registerInbox(m_cameraId, m_detectionInbox);
     }
-    
-    // Create new UUID for this track index
-    Uuid newUuid = UuidHelper::randomUuid();
-    m_trackIds[trackIndex] = newUuid;
-    return newUuid;
 }
 
 } // namespace object_detection
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <set>
 #include <thread>
 #include <memory>
@@ -9,10 +10,24 @@
 #include <unordered_map>
 
 #include <nx/sdk/analytics/helpers/consuming_device_agent.h>
+#include <nx/sdk/analytics/helpers/object_metadata_packet.h>
+#include <nx/sdk/analytics/i_object_track_best_shot_packet.h>
 #include <nx/sdk/helpers/uuid_helper.h>
 
+#include "../recycling_pool.h"
+#include "best_shot_selector.h"
 #include "engine.h"
-#include "mqtt_object_receiver.h"
+#include "detection_inbox.h"
+#include "detection_metrics.h"
+#include "detection_object_metadata.h"
+#include "latency_tracer.h"
+#include "line_crossing_detector.h"
+#include "object_type_map.h"
+#include "roi_filter.h"
+#include "shm_detection_reader.h"
+#include "track_predictor.h"
+#include "track_table.h"
+#include "zone_monitor.h"
 
 namespace nx {
 namespace vms_server_plugins {
@@ -24,11 +39,31 @@ class DeviceAgent: public nx::sdk::analytics::ConsumingDeviceAgent
 {
 public:
     static const std::string kTimeShiftSetting;
+    static const std::string kTimestampToleranceSetting;
+    static const std::string kTransportSetting;
+    static const std::string kMotionPredictionHorizonSetting;
+    static const std::string kMqttTransport;
+    static const std::string kSharedMemoryTransport;
     static const std::string kSendAttributesSetting;
     static const std::string kObjectTypeGenerationSettingPrefix;
+    static const std::string kIncludedAreaSettingPrefix;
+    static const std::string kExcludedAreaSettingPrefix;
+    static const std::string kRoiCoverageSetting;
+    static constexpr int kRoiAreaCount = 3; //< Of each kind.
+    static const std::string kCrossingLineSettingPrefix;
+    static constexpr int kCrossingLineCount = 8;
+    static const std::string kLineCrossingEventType;
+    static const std::string kOccupancyZoneSettingPrefix;
+    static const std::string kZoneMaxObjectsSettingSuffix;
+    static const std::string kZoneMaxDwellSettingSuffix;
+    static constexpr int kOccupancyZoneCount = 4;
+    static const std::string kZoneOccupancyEventType;
+    static const std::string kZoneDwellEventType;
+    static const std::string kSendBestShotsSetting;
+    static const std::string kBestShotDeadlineSetting;
 
 public:
-    DeviceAgent(const nx::sdk::IDeviceInfo* deviceInfo);
+    DeviceAgent(Engine* engine, const nx::sdk::IDeviceInfo* deviceInfo);
     virtual ~DeviceAgent() override;
 
 protected:
@@ -44,22 +79,73 @@ protected:
     virtual nx::sdk::Result<const nx::sdk::ISettingsResponse*> settingsReceived() override;
 
 private:
-    nx::sdk::Uuid trackIdByTrackIndex(int trackIndex);
-
     nx::sdk::Ptr<nx::sdk::analytics::IMetadataPacket> generateObjectMetadataPacket(
         int64_t frameTimestampUs);
 
+    /** @return Null if no line has been crossed since the last call. */
+    nx::sdk::Ptr<nx::sdk::analytics::IMetadataPacket> generateLineCrossingEventPacket();
+
+    /** @return Null if no zone event has started or finished since the last call. */
+    nx::sdk::Ptr<nx::sdk::analytics::IMetadataPacket> generateZoneEventPacket();
+
+    /** One packet per track whose best shot has been selected since the last call. */
+    std::vector<nx::sdk::Ptr<nx::sdk::analytics::IObjectTrackBestShotPacket>>
+        generateBestShotPackets();
+
+    /** Must be called with m_mutex locked. */
+    void updateBestShotSelector(
+        bool hasNewDetections, int64_t detectionTimestampUs, int64_t frameTimestampUs);
+
+    void setTransport(const std::string& transport);
+    void reportMetadataAllocations();
+    void updateRoiFilter(
+        const std::map<std::string, std::string>& settings, bool areFiguresChanged);
+    void updateZoneMonitor(
+        const std::map<std::string, std::string>& settings, bool areFiguresChanged);
+
 private:
+    Engine* const m_engine;
+    const std::string m_cameraId;
+
     mutable std::mutex m_mutex;
 
     int m_frameIndex = 0;
-    int m_timestampShiftMs = 0;
+
+    // Set under m_mutex, but read by the video thread without it.
+    std::atomic<int> m_timestampShiftMs{0};
+    std::atomic<int> m_timestampToleranceMs{100};
+    std::atomic<int> m_motionPredictionHorizonMs{0};
+
     bool m_sendAttributes = true;
-    std::unordered_map<int, nx::sdk::Uuid> m_trackIds;
-    std::set<std::string> m_objectTypeIdsToGenerate;
+    TrackTable m_trackTable; //< Used only from the video thread.
+    ObjectTypeMap m_objectTypeMap; //< Guarded by m_mutex.
+    GeometryStore m_geometryStore; //< Figures drawn in the settings.
+    RoiFilter m_roiFilter; //< Guarded by m_mutex.
+    int m_roiMinCoveragePercent = 0; //< Guarded by m_mutex.
+    LineCrossingDetector m_lineCrossingDetector; //< Used only from the video thread.
+    int64_t m_lineCrossingTimestampUs = -1; //< Of the crossings not yet reported; -1 if none.
+    ZoneMonitor m_zoneMonitor; //< Guarded by m_mutex.
+    std::vector<int> m_zoneThresholds; //< Guarded by m_mutex; as set to m_zoneMonitor.
+    BestShotSelector m_bestShotSelector; //< Guarded by m_mutex.
+    bool m_sendBestShots = true; //< Guarded by m_mutex.
+    int m_bestShotDeadlineMs = 5000; //< Guarded by m_mutex.
+    const std::shared_ptr<DetectionMetrics> m_metrics;
     
-    // MQTT receiver for AI detections
-    std::unique_ptr<MqttObjectReceiver> m_mqttReceiver;
+    // AI detections routed to this camera by the Engine's MQTT receiver
+    std::shared_ptr<DetectionInbox> m_detectionInbox;
+    std::string m_transport;
+    std::unique_ptr<ShmDetectionReader> m_shmReader; //< Guarded by m_mutex; null for MQTT.
+    DetectionBatch m_detections; //< Reused for every frame.
+    TrackPredictor m_trackPredictor; //< Used only from the video thread.
+    DetectionBatch m_predictedDetections; //< Reused for every frame.
+    std::unique_ptr<LatencyTracer> m_latencyTracer; //< Null unless latency tracing is enabled.
+    bool m_isTracePending = false; //< Whether m_detections are new and not yet traced.
+
+    // Used only from the video thread.
+    RecyclingPool<nx::sdk::analytics::ObjectMetadataPacket> m_packetPool;
+    RecyclingPool<DetectionObjectMetadata>
+        m_objectPools[DetectionObjectMetadata::kAttributesVariantCount];
+    int64_t m_reportedMetadataAllocationCount = 0;
 };
 
 } // namespace object_detection
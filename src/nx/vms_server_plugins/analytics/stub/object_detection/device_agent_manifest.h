@@ -36,6 +36,23 @@ static const std::string kDeviceAgentManifest = /*suppress newline*/ 1 + (const
                 "name": "Smoke",
                 "attributes": []
             }
+        ],
+        "eventTypes":
+        [
+            {
+                "id": "nx.stub.objectDetection.lineCrossing",
+                "name": "Line crossing"
+            },
+            {
+                "id": "nx.stub.objectDetection.zoneOccupancy",
+                "name": "Zone occupancy",
+                "flags": "stateDependent|regionDependent"
+            },
+            {
+                "id": "nx.stub.objectDetection.zoneDwell",
+                "name": "Dwell in zone",
+                "flags": "stateDependent"
+            }
         ]
     },
     "supportedTypes":
@@ -373,6 +390,15 @@ static const std::string kDeviceAgentManifest = /*suppress newline*/ 1 + (const
         {
             "objectTypeId": "nx.base.Smoke",
             "attributes": []
+        },
+        {
+            "eventTypeId": "nx.stub.objectDetection.lineCrossing"
+        },
+        {
+            "eventTypeId": "nx.stub.objectDetection.zoneOccupancy"
+        },
+        {
+            "eventTypeId": "nx.stub.objectDetection.zoneDwell"
         }
     ]
 }
@@ -6,6 +6,7 @@
 #include "stub_analytics_plugin_object_detection_ini.h"
 
 #include <nx/kit/json.h>
+#include <nx/kit/utils.h>
 
 namespace nx {
 namespace vms_server_plugins {
@@ -24,20 +25,78 @@ static const std::set<std::string> kObjectTypeIdsGeneratedByDefault = {
     "nx.base.Person"
 };
 
-Engine::Engine(): nx::sdk::analytics::Engine(ini().enableOutput)
+static const std::string kMqttBroker = "192.168.1.215";
+static constexpr int kMqttPort = 1883;
+static const std::string kDetectionsTopicPrefix = "vms/ai/detections/";
+
+Engine::Engine():
+    nx::sdk::analytics::Engine(ini().enableOutput),
+    m_deviceAgentSettingsModel(buildDeviceAgentSettingsModel()),
+    m_figureTypes(GeometrySet::figureTypesFromSettingsModel(m_deviceAgentSettingsModel)),
+    m_mqttReceiver(std::make_unique<MqttObjectReceiver>(
+        kMqttBroker, kMqttPort, kDetectionsTopicPrefix))
 {
+    m_mqttReceiver->setConnectionStateHandler(
+        [this](bool isSubscribed, const std::string& details)
+        {
+            if (isSubscribed)
+            {
+                pushPluginDiagnosticEvent(
+                    IPluginDiagnosticEvent::Level::info,
+                    "Connected to the AI detection broker",
+                    details);
+            }
+            else
+            {
+                pushPluginDiagnosticEvent(
+                    IPluginDiagnosticEvent::Level::warning,
+                    "AI detection broker is unavailable",
+                    details + "; retrying in the background.");
+            }
+        });
+
+    // Connect once for all cameras: DeviceAgents only register their inboxes, and neither the
+    // Engine nor the DeviceAgents wait for the broker.
+    m_mqttReceiver->start();
+
+    if (ini().enableLatencyTracing && ini().latencyTraceFile[0] != '\0')
+    {
+        m_latencyTraceWriter = std::make_unique<ChromeTraceWriter>(
+            ini().latencyTraceFile, ini().latencyTraceMaxEventCount);
+    }
+
+    m_metricsExporter = std::make_unique<MetricsExporter>(
+        ini().metricsExportTarget,
+        std::chrono::milliseconds(ini().metricsExportPeriodMs),
+        std::chrono::seconds(ini().metricsSummaryPeriodS),
+        [this](const std::string& summary)
+        {
+            pushPluginDiagnosticEvent(
+                IPluginDiagnosticEvent::Level::info, "Object detection metrics", summary);
+        });
 }
 
 Engine::~Engine()
 {
+    m_metricsExporter.reset(); //< Stop pushing summaries before the Engine is destroyed.
+    m_mqttReceiver->stop();
 }
 
 void Engine::doObtainDeviceAgent(Result<IDeviceAgent*>* outResult, const IDeviceInfo* deviceInfo)
 {
-    *outResult = new DeviceAgent(deviceInfo);
+    *outResult = new DeviceAgent(this, deviceInfo);
 }
 
-std::string Engine::manifestString() const
+Result<const ISettingsResponse*> Engine::settingsReceived()
+{
+    int logLevel = 0;
+    if (nx::kit::utils::fromString(settingValue(kLogLevelSetting), &logLevel))
+        runtimeLogLevel().set(logLevel);
+
+    return nullptr;
+}
+
+nx::kit::Json Engine::buildDeviceAgentSettingsModel()
 {
     using namespace nx::kit;
 
@@ -50,11 +109,49 @@ std::string Engine::manifestString() const
         {"type", "SpinBox"},
         {"name", DeviceAgent::kTimeShiftSetting},
         {"caption", "Timestamp shift"},
-        {"description", "Metadata timestamp shift in milliseconds"},
+        {"description",
+            "Metadata timestamp shift in milliseconds, for detections without a frame timestamp"},
         {"defaultValue", 0}
     };
     generationSettings.push_back(std::move(timeShiftSetting));
 
+    Json::object timestampToleranceSetting = {
+        {"type", "SpinBox"},
+        {"name", DeviceAgent::kTimestampToleranceSetting},
+        {"caption", "Detection timestamp tolerance"},
+        {"description",
+            "Max distance in milliseconds between a video frame and the timestamped detections "
+            "shown on it; older detections are dropped"},
+        {"minValue", 0},
+        {"maxValue", 10000},
+        {"defaultValue", 100}
+    };
+    generationSettings.push_back(std::move(timestampToleranceSetting));
+
+    Json::object motionPredictionSetting = {
+        {"type", "SpinBox"},
+        {"name", DeviceAgent::kMotionPredictionHorizonSetting},
+        {"caption", "Motion prediction horizon"},
+        {"description",
+            "If > 0, boxes are moved along each track on every video frame between detector "
+            "results, for at most this many milliseconds after the last result of the track"},
+        {"minValue", 0},
+        {"maxValue", 10000},
+        {"defaultValue", 0}
+    };
+    generationSettings.push_back(std::move(motionPredictionSetting));
+
+    Json::object transportSetting = {
+        {"type", "ComboBox"},
+        {"name", DeviceAgent::kTransportSetting},
+        {"caption", "Detection transport"},
+        {"description",
+            "Shared memory: read the detections directly from a detector running on this server"},
+        {"defaultValue", DeviceAgent::kMqttTransport},
+        {"range", Json::array{DeviceAgent::kMqttTransport, DeviceAgent::kSharedMemoryTransport}}
+    };
+    generationSettings.push_back(std::move(transportSetting));
+
     Json::object attributesSetting = {
         {"type", "CheckBox"},
         {"name", DeviceAgent::kSendAttributesSetting},
@@ -63,12 +160,147 @@ std::string Engine::manifestString() const
     };
     generationSettings.push_back(std::move(attributesSetting));
 
+    Json::object bestShotsSetting = {
+        {"type", "CheckBox"},
+        {"name", DeviceAgent::kSendBestShotsSetting},
+        {"caption", "Send best shots"},
+        {"description",
+            "Send one best shot per track: its most confident, largest detection which is not "
+            "cut by the frame border"},
+        {"defaultValue", true}
+    };
+    generationSettings.push_back(std::move(bestShotsSetting));
+
+    Json::object bestShotDeadlineSetting = {
+        {"type", "SpinBox"},
+        {"name", DeviceAgent::kBestShotDeadlineSetting},
+        {"caption", "Best shot deadline"},
+        {"description",
+            "Max milliseconds from the first detection of a track to its best shot; if 0, the "
+            "best shot is sent when the track ends"},
+        {"minValue", 0},
+        {"maxValue", 600000},
+        {"defaultValue", 5000}
+    };
+    generationSettings.push_back(std::move(bestShotDeadlineSetting));
+
+    const auto areaRepeater =
+        [](const std::string& settingPrefix, const std::string& caption)
+        {
+            return Json::object{
+                {"type", "Repeater"},
+                {"count", DeviceAgent::kRoiAreaCount},
+                {"template", Json::object{
+                    {"type", "PolygonFigure"},
+                    {"name", settingPrefix + "#.figure"},
+                    {"caption", caption + " #"},
+                    {"useLabelField", false},
+                    {"maxPoints", 16}
+                }}
+            };
+        };
+
+    Json::object roiCoverageSetting = {
+        {"type", "SpinBox"},
+        {"name", DeviceAgent::kRoiCoverageSetting},
+        {"caption", "Min area coverage, %"},
+        {"description",
+            "Objects whose boxes are covered by the excluded areas at least this much are not "
+            "sent; if any included area is drawn, neither are the objects covered by the included "
+            "areas less than this"},
+        {"minValue", 1},
+        {"maxValue", 100},
+        {"defaultValue", 50}
+    };
+
+    Json::object roiGroup = {
+        {"type", "GroupBox"},
+        {"caption", "Regions of interest"},
+        {"items", Json::array{
+            areaRepeater(DeviceAgent::kIncludedAreaSettingPrefix, "Included area"),
+            areaRepeater(DeviceAgent::kExcludedAreaSettingPrefix, "Excluded area"),
+            std::move(roiCoverageSetting)
+        }}
+    };
+    generationSettings.push_back(std::move(roiGroup));
+
+    Json::object lineCrossingGroup = {
+        {"type", "GroupBox"},
+        {"caption", "Line crossing"},
+        {"items", Json::array{
+            Json::object{
+                {"type", "Repeater"},
+                {"count", DeviceAgent::kCrossingLineCount},
+                {"template", Json::object{
+                    {"type", "LineFigure"},
+                    {"name", DeviceAgent::kCrossingLineSettingPrefix + "#.figure"},
+                    {"caption", "Line #"},
+                    {"description",
+                        "An event is generated whenever a tracked object crosses the line in the "
+                        "allowed direction; the bottom center of its box is what crosses"},
+                    {"maxPoints", 8}
+                }}
+            }
+        }}
+    };
+    generationSettings.push_back(std::move(lineCrossingGroup));
+
+    const std::string zonePrefix = DeviceAgent::kOccupancyZoneSettingPrefix + "#";
+    Json::object zoneGroup = {
+        {"type", "GroupBox"},
+        {"caption", "Occupancy zones"},
+        {"items", Json::array{
+            Json::object{
+                {"type", "Repeater"},
+                {"count", DeviceAgent::kOccupancyZoneCount},
+                {"template", Json::object{
+                    {"type", "GroupBox"},
+                    {"caption", "Zone #"},
+                    {"filledCheckItems", Json::array{zonePrefix + ".figure"}},
+                    {"items", Json::array{
+                        Json::object{
+                            {"type", "PolygonFigure"},
+                            {"name", zonePrefix + ".figure"},
+                            {"maxPoints", 16}
+                        },
+                        Json::object{
+                            {"type", "SpinBox"},
+                            {"name", zonePrefix + DeviceAgent::kZoneMaxObjectsSettingSuffix},
+                            {"caption", "Max objects"},
+                            {"description",
+                                "An event lasts while the zone holds at least this many objects; "
+                                "0 for none"},
+                            {"minValue", 0},
+                            {"maxValue", 1000},
+                            {"defaultValue", 0}
+                        },
+                        Json::object{
+                            {"type", "SpinBox"},
+                            {"name", zonePrefix + DeviceAgent::kZoneMaxDwellSettingSuffix},
+                            {"caption", "Max dwell time, s"},
+                            {"description",
+                                "An event lasts while an object stays in the zone after this many "
+                                "seconds; 0 for none"},
+                            {"minValue", 0},
+                            {"maxValue", 86400},
+                            {"defaultValue", 0}
+                        }
+                    }}
+                }}
+            }
+        }}
+    };
+    generationSettings.push_back(std::move(zoneGroup));
+
     generationSettings.push_back(Json::object{ {"type", "Separator"} });
 
     for (const auto& supportedType : deviceAgentManifest["supportedTypes"].array_items())
     {
         Json::object supportedTypeObject = supportedType.object_items();
         const std::string& objectTypeId = supportedTypeObject["objectTypeId"].string_value();
+        if (objectTypeId.empty())
+            continue; //< An event type.
+
         Json::object generationSetting = {
             {"type", "CheckBox"},
             {"name", DeviceAgent::kObjectTypeGenerationSettingPrefix + objectTypeId},
@@ -83,17 +315,20 @@ std::string Engine::manifestString() const
         generationSettings.push_back(std::move(generationSetting));
     }
 
-    Json::object settingsModel = {
+    return Json::object{
         {"type", "Settings"},
         {"items", generationSettings}
     };
+}
 
-    Json::object engineManifest = {
+std::string Engine::manifestString() const
+{
+    nx::kit::Json::object engineManifest = {
         {"streamTypeFilter", "compressedVideo"},
-        {"deviceAgentSettingsModel", settingsModel}
+        {"deviceAgentSettingsModel", m_deviceAgentSettingsModel}
     };
 
-    return Json(engineManifest).dump();
+    return nx::kit::Json(engineManifest).dump();
 }
 
 } // namespace object_detection
@@ -2,10 +2,18 @@
 
 #pragma once
 
+#include <memory>
+
+#include <nx/kit/json.h>
 #include <nx/sdk/analytics/helpers/engine.h>
 #include <nx/sdk/analytics/helpers/plugin.h>
 #include <nx/sdk/analytics/i_uncompressed_video_frame.h>
 
+#include "../chrome_trace_writer.h"
+#include "../geometry_set.h"
+#include "../metrics_exporter.h"
+#include "mqtt_object_receiver.h"
+
 namespace nx {
 namespace vms_server_plugins {
 namespace analytics {
@@ -18,13 +26,34 @@ public:
     Engine();
     virtual ~Engine() override;
 
+    /** Connection shared by all DeviceAgents; they register their inboxes there. */
+    MqttObjectReceiver* mqttReceiver() const { return m_mqttReceiver.get(); }
+
+    /** Figure settings of the DeviceAgent settings model. */
+    const GeometrySet::FigureTypes& figureTypes() const { return m_figureTypes; }
+
+    /** Null unless latency tracing into a file is enabled in the ini. */
+    ChromeTraceWriter* latencyTraceWriter() const { return m_latencyTraceWriter.get(); }
+
 protected:
     virtual std::string manifestString() const override;
 
+    virtual nx::sdk::Result<const nx::sdk::ISettingsResponse*> settingsReceived() override;
+
 protected:
     virtual void doObtainDeviceAgent(
         nx::sdk::Result<nx::sdk::analytics::IDeviceAgent*>* outResult,
         const nx::sdk::IDeviceInfo* deviceInfo) override;
+
+private:
+    static nx::kit::Json buildDeviceAgentSettingsModel();
+
+private:
+    const nx::kit::Json m_deviceAgentSettingsModel;
+    const GeometrySet::FigureTypes m_figureTypes;
+    std::unique_ptr<MqttObjectReceiver> m_mqttReceiver;
+    std::unique_ptr<MetricsExporter> m_metricsExporter;
+    std::unique_ptr<ChromeTraceWriter> m_latencyTraceWriter;
 };
 
 } // namespace object_detection
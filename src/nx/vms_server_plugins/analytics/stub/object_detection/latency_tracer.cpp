@@ -0,0 +1,64 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "latency_tracer.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+static const char* const kStageNames[] = {
+    "transport", "parsing", "queueing", "processing", "total"};
+
+LatencyTracer::LatencyTracer(const std::string& cameraId, ChromeTraceWriter* traceWriter):
+    m_traceWriter(traceWriter)
+{
+    const std::string cameraLabel = "camera=\"" + escapeLabelValue(cameraId) + "\"";
+    for (int stage = 0; stage < stageCount; ++stage)
+    {
+        m_latencyUs[stage] = MetricsRegistry::instance().histogram(
+            "stub_object_detection_stage_latency_us",
+            "Time a detection message spends in a stage on its way to the Server, in microseconds.",
+            cameraLabel + ",stage=\"" + kStageNames[stage] + "\"");
+    }
+
+    if (m_traceWriter)
+        m_traceTrackId = m_traceWriter->addTrack("Camera " + cameraId);
+}
+
+void LatencyTracer::record(const DetectionTrace& trace)
+{
+    if (trace.arrivedUs == 0)
+        return; //< Received before the tracing was enabled.
+
+    if (trace.publishedUs > 0 && trace.publishedUs <= trace.arrivedUs)
+    {
+        recordStage(transport, trace.publishedUs, trace.arrivedUs);
+        recordStage(total, trace.publishedUs, trace.pushedUs);
+    }
+    else
+    {
+        recordStage(total, trace.arrivedUs, trace.pushedUs);
+    }
+
+    recordStage(parsing, trace.arrivedUs, trace.parsedUs);
+    recordStage(queueing, trace.parsedUs, trace.matchedUs);
+    recordStage(processing, trace.matchedUs, trace.pushedUs);
+}
+
+void LatencyTracer::recordStage(Stage stage, int64_t startUs, int64_t endUs)
+{
+    const int64_t durationUs = endUs - startUs;
+    m_latencyUs[stage]->record(durationUs);
+
+    // The total is seen in the viewer as the span of the other stages.
+    if (m_traceWriter && stage != total)
+        m_traceWriter->addCompleteEvent(m_traceTrackId, kStageNames[stage], startUs, durationUs);
+}
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,68 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../chrome_trace_writer.h"
+#include "../metrics.h"
+#include "detection_batch.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/** Current time in the clock of DetectionTrace. */
+inline int64_t traceTimeUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Turns the stamps of the detection messages of a camera into per-stage latency histograms,
+ * registered as stub_object_detection_stage_latency_us{camera, stage}, and optionally into Chrome
+ * trace events. Exists only while latency tracing is enabled, so that otherwise the stamping
+ * costs a single branch per stage.
+ *
+ * The publisher clock is used for the "transport" stage only; it is skipped if the message has
+ * no publish time or the clocks are so far apart that the stage would be negative.
+ */
+class LatencyTracer
+{
+public:
+    /** @param traceWriter Optional; must outlive the tracer. */
+    LatencyTracer(const std::string& cameraId, ChromeTraceWriter* traceWriter);
+
+    /** Called once the trace has all the plugin-side stamps, i.e. when the packet is pushed. */
+    void record(const DetectionTrace& trace);
+
+private:
+    enum Stage
+    {
+        transport, //< Published to arrived.
+        parsing, //< Arrived to parsed.
+        queueing, //< Parsed to taken for a video frame.
+        processing, //< Taken for a frame to its packet pushed.
+        total, //< Published, or arrived if unknown, to pushed.
+        stageCount
+    };
+
+    void recordStage(Stage stage, int64_t startUs, int64_t endUs);
+
+private:
+    ChromeTraceWriter* const m_traceWriter;
+    int m_traceTrackId = 0;
+    std::shared_ptr<Histogram> m_latencyUs[stageCount];
+};
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
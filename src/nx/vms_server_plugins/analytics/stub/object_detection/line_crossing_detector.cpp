@@ -0,0 +1,172 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "line_crossing_detector.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+using Figure = GeometrySet::Figure;
+using FigureType = GeometrySet::FigureType;
+using Direction = GeometrySet::Direction;
+
+static bool isOutside(const GeometryRect& bounds, GeometryPoint from, GeometryPoint to)
+{
+    return std::max(from.x, to.x) < bounds.x
+        || std::min(from.x, to.x) > bounds.x + bounds.width
+        || std::max(from.y, to.y) < bounds.y
+        || std::min(from.y, to.y) > bounds.y + bounds.height;
+}
+
+LineCrossingDetector::LineCrossingDetector(
+    const GeometryStore* geometryStore,
+    std::string linePrefix,
+    int maxTrackCount,
+    int64_t trackTtlUs):
+    m_geometryReader(geometryStore),
+    m_linePrefix(std::move(linePrefix)),
+    m_maxTrackCount((size_t) std::max(maxTrackCount, 1)),
+    m_trackTtlUs(trackTtlUs)
+{
+    m_tracks.reserve(m_maxTrackCount);
+    m_nextTracks.reserve(m_maxTrackCount);
+    m_batchPositions.reserve(m_maxTrackCount);
+    m_crossings.reserve(m_maxTrackCount);
+}
+
+void LineCrossingDetector::updateLines()
+{
+    const GeometrySet& geometry = m_geometryReader.current();
+    if (&geometry == m_geometry && geometry.version() == m_geometryVersion)
+        return;
+
+    m_geometry = &geometry;
+    m_geometryVersion = geometry.version();
+    m_lines.clear();
+    for (const Figure& figure: geometry.figures())
+    {
+        if (figure.type == FigureType::line
+            && figure.name.compare(0, m_linePrefix.size(), m_linePrefix) == 0)
+        {
+            m_lines.push_back(&figure);
+        }
+    }
+}
+
+void LineCrossingDetector::collectPositions(const DetectionBatch& detections, int64_t timestampUs)
+{
+    m_batchPositions.clear();
+    for (size_t i = 0; i < detections.size() && m_batchPositions.size() < m_maxTrackCount; ++i)
+    {
+        const DetectedObject& object = detections[i];
+        TrackPosition position;
+        position.trackId = object.trackId;
+        position.point = {object.x + object.width / 2, object.y + object.height};
+        position.lastSeenUs = timestampUs;
+        position.objectIndex = i;
+        m_batchPositions.push_back(position);
+    }
+
+    std::sort(m_batchPositions.begin(), m_batchPositions.end(),
+        [](const TrackPosition& a, const TrackPosition& b) { return a.trackId < b.trackId; });
+
+    // Drop all the detections of an ambiguous trackId, not only the repeated ones.
+    auto out = m_batchPositions.begin();
+    for (auto it = m_batchPositions.begin(); it != m_batchPositions.end();)
+    {
+        auto next = it + 1;
+        while (next != m_batchPositions.end() && next->trackId == it->trackId)
+            ++next;
+        if (next - it == 1)
+            *out++ = *it;
+        it = next;
+    }
+    m_batchPositions.erase(out, m_batchPositions.end());
+}
+
+void LineCrossingDetector::findCrossings(const TrackPosition& from, const TrackPosition& to)
+{
+    for (const Figure* const line: m_lines)
+    {
+        if (isOutside(line->bounds, from.point, to.point))
+            continue;
+
+        const Direction direction = m_geometry->crossing(*line, from.point, to.point);
+        if (direction == Direction::absent
+            || (line->direction != Direction::absent && line->direction != direction))
+        {
+            continue;
+        }
+
+        Crossing crossing;
+        crossing.objectIndex = to.objectIndex;
+        crossing.line = line;
+        crossing.direction = direction;
+        m_crossings.push_back(crossing);
+    }
+}
+
+void LineCrossingDetector::update(const DetectionBatch& detections, int64_t timestampUs)
+{
+    m_crossings.clear();
+    updateLines();
+
+    // Positions from before a restart of the detector or a jump back in time are not steps.
+    if (m_lines.empty()
+        || detections.trackEpoch() != m_trackEpoch
+        || timestampUs < m_lastTimestampUs)
+    {
+        m_tracks.clear();
+    }
+    m_trackEpoch = detections.trackEpoch();
+    m_lastTimestampUs = timestampUs;
+    if (m_lines.empty())
+        return;
+
+    collectPositions(detections, timestampUs);
+
+    // Merge the batch into the tracks, both sorted by trackId. The tracks of the batch always
+    // fit; the ones missing from it are kept while they are recent and there is room left.
+    size_t missingTrackRoom = m_maxTrackCount - m_batchPositions.size();
+    m_nextTracks.clear();
+    auto track = m_tracks.begin();
+    for (const TrackPosition& position: m_batchPositions)
+    {
+        for (; track != m_tracks.end() && track->trackId < position.trackId; ++track)
+        {
+            if (missingTrackRoom > 0 && timestampUs - track->lastSeenUs <= m_trackTtlUs)
+            {
+                m_nextTracks.push_back(*track);
+                --missingTrackRoom;
+            }
+        }
+
+        if (track != m_tracks.end() && track->trackId == position.trackId)
+        {
+            findCrossings(*track, position);
+            ++track;
+        }
+        m_nextTracks.push_back(position);
+    }
+    for (; track != m_tracks.end() && missingTrackRoom > 0; ++track)
+    {
+        if (timestampUs - track->lastSeenUs <= m_trackTtlUs)
+        {
+            m_nextTracks.push_back(*track);
+            --missingTrackRoom;
+        }
+    }
+
+    m_tracks.swap(m_nextTracks);
+}
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,105 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../geometry_set.h"
+#include "detection_batch.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/**
+ * Detects the tracks crossing the lines drawn in the DeviceAgent settings.
+ *
+ * The last position of each track is kept, and every new position is tested against each line
+ * by GeometrySet::crossing() on the step from the previous one. The position of an object is the
+ * bottom center of its box, where people and vehicles touch the ground, so that a line drawn on
+ * the floor is crossed when the object steps over it. Steps are culled by the line bounds first.
+ *
+ * The positions are kept in a vector sorted by trackId and merged with the sorted detections of
+ * each batch. At most `maxTrackCount` tracks are kept; a track missing from the batches keeps its
+ * position for `trackTtlUs`, so that a crossing is not lost when the detector misses the object
+ * for a few frames. All buffers are allocated up front, so updates do not allocate, except for
+ * the crossings list growing beyond the track count.
+ *
+ * Detections sharing a trackId within a batch, e.g. when the publisher does not track objects,
+ * are ignored: their steps would be meaningless.
+ *
+ * Not thread-safe.
+ */
+class LineCrossingDetector
+{
+public:
+    struct Crossing
+    {
+        size_t objectIndex = 0; //< In the batch given to update().
+        const GeometrySet::Figure* line = nullptr;
+        GeometrySet::Direction direction = GeometrySet::Direction::absent; //< Side crossed to.
+    };
+
+    /**
+     * @param linePrefix Line figures whose setting name starts with it are used; the other
+     *     figures are ignored.
+     */
+    LineCrossingDetector(
+        const GeometryStore* geometryStore,
+        std::string linePrefix,
+        int maxTrackCount,
+        int64_t trackTtlUs);
+
+    /**
+     * Moves the tracks to their positions in the batch; the lines they have crossed since their
+     * previous positions are then listed by crossings(). A line with a direction set is reported
+     * only when crossed in that direction.
+     * @param timestampUs Timestamp of the batch; going back in time forgets all tracks.
+     */
+    void update(const DetectionBatch& detections, int64_t timestampUs);
+
+    /** Found by the last update(); valid until the next one. */
+    const std::vector<Crossing>& crossings() const { return m_crossings; }
+
+    bool hasLines() const { return !m_lines.empty(); }
+
+private:
+    struct TrackPosition
+    {
+        int trackId = 0;
+        GeometryPoint point;
+        int64_t lastSeenUs = 0;
+        size_t objectIndex = 0; //< Only for the positions of the current batch.
+    };
+
+    void updateLines();
+    void collectPositions(const DetectionBatch& detections, int64_t timestampUs);
+    void findCrossings(const TrackPosition& from, const TrackPosition& to);
+
+private:
+    GeometryStore::Reader m_geometryReader;
+    const std::string m_linePrefix;
+    const size_t m_maxTrackCount;
+    const int64_t m_trackTtlUs;
+
+    const GeometrySet* m_geometry = nullptr; //< Kept alive by m_geometryReader.
+    uint64_t m_geometryVersion = 0;
+    std::vector<const GeometrySet::Figure*> m_lines;
+
+    int64_t m_trackEpoch = 0;
+    int64_t m_lastTimestampUs = INT64_MIN;
+    std::vector<TrackPosition> m_tracks; //< Sorted by trackId.
+    std::vector<TrackPosition> m_nextTracks; //< Reused by update().
+    std::vector<TrackPosition> m_batchPositions; //< Reused by update().
+    std::vector<Crossing> m_crossings;
+};
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
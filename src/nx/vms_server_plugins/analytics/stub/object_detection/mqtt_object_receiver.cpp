@@ -6,7 +6,13 @@
 #include <chrono>
 #include <algorithm>
 
-#include <nx/kit/json.h>
+#include <nx/sdk/helpers/uuid_helper.h>
+
+#include "../logging.h"
+#include "../utils.h"
+#include "detection_binary_format.h"
+#include "latency_tracer.h"
+#include "stub_analytics_plugin_object_detection_ini.h"
 
 #undef NX_PRINT_PREFIX
 #define NX_PRINT_PREFIX "[MQTT Object Receiver] "
@@ -18,213 +24,378 @@ namespace analytics {
 namespace stub {
 namespace object_detection {
 
+using namespace nx::sdk;
+using namespace std::chrono;
+
+static constexpr milliseconds kInitialRetryDelay{1000};
+static constexpr milliseconds kMaxRetryDelay{60000};
+static constexpr seconds kConnectTimeout{5};
+static constexpr milliseconds kDisconnectTimeout{2000};
+
 void MqttObjectReceiver::Callback::connection_lost(const std::string& cause)
 {
-    NX_PRINT << "Connection lost: " << cause;
-    
-    // Clear objects and reset flag when connection is lost
+    STUB_LOG(LogLevel::warning) << "Connection lost: " << cause;
+
+    // A persistent session resumes where it stopped, so the pending batches stay valid; the ones
+    // which become stale meanwhile are dropped by the inboxes. Otherwise, clear objects and reset
+    // the flag when the connection is lost.
+    if (!m_receiver->m_isSessionPersistent)
+        m_receiver->resetInboxes();
+    m_receiver->reportConnectionState(/*isSubscribed*/ false, "Connection lost: " + cause);
+
+    // Never reconnect from here: paho's callback thread must not be blocked.
+    m_receiver->scheduleRetry();
+}
+
+void MqttObjectReceiver::Callback::message_arrived(mqtt::const_message_ptr msg)
+{
+    STUB_LOG_THROTTLED(LogLevel::trace, 10) << "Message arrived on topic: " << msg->get_topic()
+        << ", payload (" << msg->get_payload().length() << " bytes): " << msg->get_payload_str();
+
+    const std::shared_ptr<DetectionInbox> inbox = m_receiver->findInbox(msg->get_topic());
+    if (!inbox)
+        return; //< No DeviceAgent for this camera on this server.
+
+    if (m_receiver->isDuplicateMessage(*msg))
     {
-        std::lock_guard<std::mutex> lock(m_receiver->m_objectsMutex);
-        m_receiver->m_detectedObjects.clear();
-        m_receiver->m_hasReceivedData.store(false);
+        inbox->metrics()->duplicateMessages->add();
+        STUB_LOG_THROTTLED(LogLevel::debug, 1) << "Dropped a redelivered message on topic "
+            << msg->get_topic();
+        return;
+    }
+
+    const int64_t arrivedUs = m_receiver->m_isLatencyTracingEnabled ? traceTimeUs() : 0;
+
+    // Handed to the camera's inbox, consumed by takeDetectedObjects() on the video thread
+    if (m_receiver->parseDetectionMessage(msg->get_payload(), inbox->metrics()))
+    {
+        if (m_receiver->m_isLatencyTracingEnabled)
+        {
+            m_receiver->m_parsedObjects.trace().arrivedUs = arrivedUs;
+            m_receiver->m_parsedObjects.trace().parsedUs = traceTimeUs();
+        }
+        inbox->putDetectedObjects(&m_receiver->m_parsedObjects);
     }
-    
-    // Try to reconnect
-    m_receiver->reconnect();
 }
 
-void MqttObjectReceiver::Callback::message_arrived(mqtt::const_message_ptr msg)
+void MqttObjectReceiver::ConnectListener::on_failure(const mqtt::token& token)
 {
-    NX_PRINT << "Message arrived on topic: " << msg->get_topic();
-    NX_PRINT << "Payload (" << msg->get_payload().length() << " bytes): " << msg->get_payload_str();
-    
-    m_receiver->parseDetectionMessage(msg->get_payload_str());
+    STUB_LOG(LogLevel::warning) << "Connect failed, return code " << token.get_return_code();
+    m_receiver->reportConnectionState(/*isSubscribed*/ false,
+        "Cannot connect to " + m_receiver->m_broker + ":" + std::to_string(m_receiver->m_port));
+    m_receiver->scheduleRetry();
+}
+
+void MqttObjectReceiver::ConnectListener::on_success(const mqtt::token& /*token*/)
+{
+    // stop() may be disconnecting already. If it starts right after the check, the subscription
+    // fails, and no retry is scheduled.
+    {
+        std::lock_guard<std::mutex> lock(m_receiver->m_retryMutex);
+        if (m_receiver->m_terminated)
+            return;
+    }
+
+    m_receiver->subscribeAsync();
+}
+
+void MqttObjectReceiver::SubscribeListener::on_failure(const mqtt::token& token)
+{
+    STUB_LOG(LogLevel::warning) << "Subscribe failed, return code " << token.get_return_code();
+    m_receiver->reportConnectionState(/*isSubscribed*/ false,
+        "Cannot subscribe to " + m_receiver->m_topicFilter);
+    m_receiver->scheduleRetry();
+}
+
+void MqttObjectReceiver::SubscribeListener::on_success(const mqtt::token& /*token*/)
+{
+    STUB_LOG(LogLevel::info) << "Successfully subscribed";
+
+    {
+        std::lock_guard<std::mutex> lock(m_receiver->m_retryMutex);
+        m_receiver->m_retryDelay = kInitialRetryDelay;
+    }
+
+    m_receiver->reportConnectionState(/*isSubscribed*/ true,
+        "Subscribed to " + m_receiver->m_topicFilter + " on " + m_receiver->m_broker + ":"
+            + std::to_string(m_receiver->m_port));
 }
 
 MqttObjectReceiver::MqttObjectReceiver(
     const std::string& broker,
     int port,
-    const std::string& topic)
+    const std::string& topicPrefix)
     : m_broker(broker)
     , m_port(port)
-    , m_topic(topic)
+    , m_topicPrefix(topicPrefix)
+    , m_topicFilter(topicPrefix + "+")
+    , m_qos(std::min(std::max((int) ini().mqttQos, 0), 1))
+    , m_isSessionPersistent(ini().mqttPersistentSession)
+    , m_isLatencyTracingEnabled(ini().enableLatencyTracing)
+    , m_retryDelay(kInitialRetryDelay)
 {
-    NX_PRINT << "Created (broker: " << m_broker << ":" << m_port << ", topic: " << m_topic << ")";
-    
-    // Create MQTT client with unique ID based on topic (includes camera ID)
+    STUB_LOG(LogLevel::info) << "Created (broker: " << m_broker << ":" << m_port
+        << ", topic: " << m_topicFilter << ", QoS " << m_qos
+        << (m_isSessionPersistent ? ", persistent session" : "") << ")";
+
+    // One client per Engine, so the client ID only has to be unique among plugin instances.
     std::string serverAddress = "tcp://" + m_broker + ":" + std::to_string(m_port);
-    std::string clientId = "vms_ai_receiver_" + m_topic;
-    // Replace slashes in topic to make valid client ID
-    std::replace(clientId.begin(), clientId.end(), '/', '_');
-    
-    NX_PRINT << "MQTT Client ID: " << clientId;
-    
+    std::string clientId = ini().mqttClientId;
+    if (clientId.empty())
+    {
+        clientId = "vms_ai_receiver_" + UuidHelper::toStdString(UuidHelper::randomUuid());
+        clientId.erase(std::remove_if(clientId.begin(), clientId.end(),
+            [](char c) { return c == '{' || c == '}'; }), clientId.end());
+        m_isClientIdRandom = true;
+    }
+
+    STUB_LOG(LogLevel::debug) << "MQTT Client ID: " << clientId;
+
     m_client = std::make_shared<mqtt::async_client>(serverAddress, clientId);
     m_callback = std::make_shared<Callback>(this);
     m_client->set_callback(*m_callback);
-    
-    // Configure connection options
+
+    // Configure connection options; reconnection is done by retryThreadLoop() with backoff.
     m_connOpts.set_keep_alive_interval(20);
-    m_connOpts.set_clean_session(true);
-    m_connOpts.set_automatic_reconnect(true);
+    m_connOpts.set_connect_timeout(kConnectTimeout.count());
+    m_connOpts.set_clean_session(!m_isSessionPersistent);
+    m_connOpts.set_automatic_reconnect(false);
 }
 
 MqttObjectReceiver::~MqttObjectReceiver()
 {
     stop();
-    NX_PRINT << "Destroyed";
+    STUB_LOG(LogLevel::info) << "Destroyed";
+}
+
+void MqttObjectReceiver::setConnectionStateHandler(ConnectionStateHandler handler)
+{
+    m_connectionStateHandler = std::move(handler);
 }
 
 void MqttObjectReceiver::start()
 {
-    NX_PRINT << "Starting connection...";
-    
-    try
-    {
-        auto tok = m_client->connect(m_connOpts);
-        tok->wait();
-        
-        NX_PRINT << "Connected to broker, subscribing to " << m_topic;
-        
-        m_client->subscribe(m_topic, 0)->wait();
-        
-        NX_PRINT << "Successfully subscribed";
-    }
-    catch (const mqtt::exception& exc)
-    {
-        NX_PRINT << "Error: " << exc.what();
-    }
+    STUB_LOG(LogLevel::info) << "Starting connection...";
+
+    m_retryThread = std::thread([this]() { retryThreadLoop(); });
+    connectAsync();
 }
 
 void MqttObjectReceiver::stop()
 {
+    {
+        std::lock_guard<std::mutex> lock(m_retryMutex);
+        if (m_terminated)
+            return;
+        m_terminated = true;
+    }
+    m_retryCondition.notify_all();
+    if (m_retryThread.joinable())
+        m_retryThread.join();
+
     try
     {
         if (m_client && m_client->is_connected())
         {
-            NX_PRINT << "Disconnecting...";
-            m_client->disconnect()->wait();
+            // Nobody will resume a session of a random client ID, so make the broker stop
+            // queueing messages for it.
+            if (m_isSessionPersistent && m_isClientIdRandom)
+                m_client->unsubscribe(m_topicFilter)->wait_for(kDisconnectTimeout.count());
+
+            STUB_LOG(LogLevel::info) << "Disconnecting...";
+            m_client->disconnect()->wait_for(kDisconnectTimeout.count());
         }
     }
     catch (const mqtt::exception& exc)
     {
-        NX_PRINT << "Error during disconnect: " << exc.what();
+        STUB_LOG(LogLevel::warning) << "Error during disconnect: " << exc.what();
     }
 }
 
-void MqttObjectReceiver::reconnect()
+void MqttObjectReceiver::connectAsync()
 {
-    NX_PRINT << "Attempting to reconnect...";
-    
     try
     {
-        auto tok = m_client->connect(m_connOpts);
-        tok->wait();
-        
-        NX_PRINT << "Reconnected, resubscribing to " << m_topic;
-        m_client->subscribe(m_topic, 0)->wait();
+        m_client->connect(m_connOpts, /*userContext*/ nullptr, m_connectListener);
     }
     catch (const mqtt::exception& exc)
     {
-        NX_PRINT << "Reconnect failed: " << exc.what();
+        STUB_LOG(LogLevel::warning) << "Connect failed: " << exc.what();
+        reportConnectionState(/*isSubscribed*/ false, exc.what());
+        scheduleRetry();
     }
 }
 
-std::vector<DetectedObject> MqttObjectReceiver::getAndClearDetectedObjects()
+void MqttObjectReceiver::subscribeAsync()
 {
-    std::lock_guard<std::mutex> lock(m_objectsMutex);
-    
-    // Get objects and clear immediately (consume pattern)
-    std::vector<DetectedObject> result = std::move(m_detectedObjects);
-    m_detectedObjects.clear();
-    
-    return result;
+    STUB_LOG(LogLevel::info) << "Connected to broker, subscribing to " << m_topicFilter;
+
+    try
+    {
+        m_client->subscribe(m_topicFilter, m_qos, /*userContext*/ nullptr, m_subscribeListener);
+    }
+    catch (const mqtt::exception& exc)
+    {
+        STUB_LOG(LogLevel::warning) << "Subscribe failed: " << exc.what();
+        scheduleRetry();
+    }
 }
 
-bool MqttObjectReceiver::hasReceivedData() const
+void MqttObjectReceiver::scheduleRetry()
 {
-    return m_hasReceivedData.load();
+    {
+        std::lock_guard<std::mutex> lock(m_retryMutex);
+        if (m_terminated || m_isRetryScheduled)
+            return;
+
+        STUB_LOG(LogLevel::info) << "Retrying in " << m_retryDelay.count() << " ms";
+        m_retryDeadline = std::chrono::steady_clock::now() + m_retryDelay;
+        m_retryDelay = std::min(m_retryDelay * 2, kMaxRetryDelay);
+        m_isRetryScheduled = true;
+    }
+    m_retryCondition.notify_all();
 }
 
-void MqttObjectReceiver::parseDetectionMessage(const std::string& message)
+void MqttObjectReceiver::retryThreadLoop()
 {
-    try
+    std::unique_lock<std::mutex> lock(m_retryMutex);
+    while (!m_terminated)
     {
-        std::string parseError;
-        nx::kit::Json data = nx::kit::Json::parse(message, parseError);
-        
-        if (!parseError.empty() || !data.is_object())
+        if (!m_isRetryScheduled)
         {
-            NX_PRINT << "Failed to parse JSON: " << parseError;
-            return;
+            m_retryCondition.wait(lock);
+            continue;
         }
-        
-        auto obj = data.object_items();
-        
-        if (obj.count("detections") == 0 || !obj["detections"].is_array())
-        {
-            NX_PRINT << "No 'detections' array found in message";
+
+        // Woken up early either by stop() or spuriously; both are handled by the loop.
+        if (m_retryCondition.wait_until(lock, m_retryDeadline) != std::cv_status::timeout)
+            continue;
+
+        m_isRetryScheduled = false;
+        lock.unlock();
+
+        // The connection may have been lost after a successful connect but before subscribing.
+        if (m_client->is_connected())
+            subscribeAsync();
+        else
+            connectAsync();
+
+        lock.lock();
+    }
+}
+
+void MqttObjectReceiver::reportConnectionState(bool isSubscribed, const std::string& details)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_retryMutex);
+        if (m_terminated)
             return;
-        }
-        
-        std::vector<DetectedObject> newObjects;
-        
-        for (const auto& detection : obj["detections"].array_items())
-        {
-            if (!detection.is_object())
-                continue;
-            
-            auto detObj = detection.object_items();
-            
-            DetectedObject detected;
-            
-            if (detObj.count("label") > 0 && detObj["label"].is_string())
-                detected.label = detObj["label"].string_value();
-            
-            if (detObj.count("confidence") > 0 && detObj["confidence"].is_number())
-                detected.confidence = detObj["confidence"].number_value();
-            
-            if (detObj.count("trackId") > 0 && detObj["trackId"].is_number())
-                detected.trackId = detObj["trackId"].int_value();
-            
-            if (detObj.count("name") > 0 && detObj["name"].is_string())
-                detected.name = detObj["name"].string_value();
-            
-            if (detObj.count("bbox") > 0 && detObj["bbox"].is_array())
-            {
-                auto bbox = detObj["bbox"].array_items();
-                if (bbox.size() >= 4)
-                {
-                    detected.x = bbox[0].number_value();
-                    detected.y = bbox[1].number_value();
-                    detected.width = bbox[2].number_value();
-                    detected.height = bbox[3].number_value();
-                    
-                    newObjects.push_back(detected);
-                }
-            }
-        }
-        
-        // Store objects in queue (will be consumed by next getAndClearDetectedObjects call)
-        {
-            std::lock_guard<std::mutex> lock(m_objectsMutex);
-            m_detectedObjects = newObjects;
-            
-            // Mark that we've received at least one MQTT message
-            m_hasReceivedData.store(true);
-        }
-        
-        NX_PRINT << "Parsed " << newObjects.size() << " objects";
-        for (const auto& obj : newObjects)
+    }
+
+    if (m_reportedConnectionState.exchange(isSubscribed ? 1 : 0) == (isSubscribed ? 1 : 0))
+        return;
+
+    if (m_connectionStateHandler)
+        m_connectionStateHandler(isSubscribed, details);
+}
+
+void MqttObjectReceiver::registerInbox(
+    const std::string& cameraId, std::shared_ptr<DetectionInbox> inbox)
+{
+    STUB_LOG(LogLevel::info) << "Routing " << m_topicPrefix << cameraId << " to its DeviceAgent";
+
+    std::lock_guard<std::mutex> lock(m_inboxesMutex);
+    m_inboxByCameraId[cameraId] = std::move(inbox);
+}
+
+void MqttObjectReceiver::unregisterInbox(
+    const std::string& cameraId, const std::shared_ptr<DetectionInbox>& inbox)
+{
+    std::lock_guard<std::mutex> lock(m_inboxesMutex);
+    const auto it = m_inboxByCameraId.find(cameraId);
+    if (it != m_inboxByCameraId.end() && it->second == inbox)
+        m_inboxByCameraId.erase(it);
+}
+
+std::shared_ptr<DetectionInbox> MqttObjectReceiver::findInbox(const std::string& topic)
+{
+    if (topic.size() <= m_topicPrefix.size() || !startsWith(topic, m_topicPrefix))
+        return nullptr;
+
+    const std::string cameraId = topic.substr(m_topicPrefix.size());
+
+    std::lock_guard<std::mutex> lock(m_inboxesMutex);
+    const auto it = m_inboxByCameraId.find(cameraId);
+    if (it == m_inboxByCameraId.end())
+        return nullptr;
+
+    return it->second;
+}
+
+void MqttObjectReceiver::resetInboxes()
+{
+    std::lock_guard<std::mutex> lock(m_inboxesMutex);
+    for (const auto& entry: m_inboxByCameraId)
+        entry.second->reset();
+}
+
+bool MqttObjectReceiver::isDuplicateMessage(const mqtt::message& message)
+{
+    if (message.get_qos() == 0)
+        return false;
+
+    const std::hash<std::string> hash;
+    const size_t messageHash = hash(message.get_payload()) ^ (hash(message.get_topic()) * 31);
+
+    // Only a message with the DUP flag may have been received before; the others are just
+    // remembered.
+    if (message.is_duplicate())
+    {
+        const size_t count = std::min(m_recentMessageHashCount, kRecentMessageCount);
+        for (size_t i = 0; i < count; ++i)
         {
-            NX_PRINT << "  - " << obj.label << " @ [" << obj.x << "," << obj.y 
-                     << "," << obj.width << "," << obj.height << "] conf=" << obj.confidence;
+            if (m_recentMessageHashes[i] == messageHash)
+                return true;
         }
     }
-    catch (const std::exception& e)
+
+    m_recentMessageHashes[m_recentMessageHashCount % kRecentMessageCount] = messageHash;
+    ++m_recentMessageHashCount;
+    return false;
+}
+
+bool MqttObjectReceiver::parseDetectionMessage(
+    const std::string& payload, DetectionMetrics* metrics)
+{
+    const auto startTime = steady_clock::now();
+
+    std::string error;
+    const bool isBinary = isBinaryDetectionMessage(payload.data(), payload.size());
+    const bool isParsed = isBinary
+        ? decodeBinaryDetections(payload.data(), payload.size(), &m_parsedObjects, &error)
+        : m_parser.parse(payload.data(), payload.size(), &m_parsedObjects, &error);
+
+    metrics->parseDurationUs->record(
+        duration_cast<microseconds>(steady_clock::now() - startTime).count());
+
+    if (!isParsed)
     {
-        NX_PRINT << "Exception in parseDetectionMessage: " << e.what();
+        metrics->parseFailures->add();
+        STUB_LOG_THROTTLED(LogLevel::warning, 1) << error;
+        return false;
     }
+
+    STUB_LOG_THROTTLED(LogLevel::debug, 1) << "Parsed " << m_parsedObjects.size() << " objects";
+    if (STUB_LOG_IS_ENABLED(LogLevel::trace))
+    {
+        for (const auto& obj : m_parsedObjects)
+        {
+            STUB_LOG(LogLevel::trace) << "  - " << obj.label << " @ [" << obj.x << "," << obj.y
+                << "," << obj.width << "," << obj.height << "] conf=" << obj.confidence;
+        }
+    }
+
+    return true;
 }
 
 } // namespace object_detection
@@ -2,85 +2,174 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <string>
-#include <vector>
 #include <thread>
-#include <atomic>
+#include <vector>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <mqtt/async_client.h>
 
+#include "detection_inbox.h"
+#include "detection_parser.h"
+
 namespace nx {
 namespace vms_server_plugins {
 namespace analytics {
 namespace stub {
 namespace object_detection {
 
-struct DetectedObject
-{
-    std::string label;          // class name
-    float confidence;           // 0.0 - 1.0
-    float x;                    // normalized 0-1
-    float y;                    // normalized 0-1
-    float width;                // normalized 0-1
-    float height;               // normalized 0-1
-    int trackId;                // unique ID for tracking
-    std::string name;           // custom name field
-};
-
+/**
+ * Single MQTT connection shared by all DeviceAgents of an Engine. Subscribes to
+ * `<topicPrefix>+` and routes every message to the DetectionInbox registered for the camera id
+ * found in the last topic level.
+ *
+ * Connecting and subscribing never block the caller: they are asynchronous, and failures are
+ * retried from a dedicated thread with exponential backoff.
+ *
+ * With QoS 1 and a persistent session, the broker keeps the messages published while the
+ * connection is down and replays them on reconnect; the inflight state is kept in memory only.
+ * Messages redelivered after a lost acknowledgement are recognized among the latest
+ * kRecentMessageCount ones and dropped; replayed batches too old for the video are dropped by
+ * the inboxes.
+ *
+ * The client sets no limit of its own on the replay, as the MQTT in-flight window applies only to
+ * the messages it publishes. The messages kept for a disconnected session are bounded by the
+ * session queue limit of the broker, e.g. max_queued_messages of Mosquitto; once received, they
+ * take at most detectionBufferCapacity slots of each inbox, which drops the oldest ones.
+ */
 class MqttObjectReceiver
 {
 public:
+    /**
+     * Called from the MQTT threads when the subscription becomes live or is lost; repeated
+     * failures while disconnected are reported once.
+     */
+    using ConnectionStateHandler =
+        std::function<void(bool isSubscribed, const std::string& details)>;
+
     MqttObjectReceiver(
         const std::string& broker,
         int port,
-        const std::string& topic);
-    
+        const std::string& topicPrefix);
+
     ~MqttObjectReceiver();
 
+    /** Must be called before start(). */
+    void setConnectionStateHandler(ConnectionStateHandler handler);
+
+    /** Initiates the connection and returns immediately. */
     void start();
+
     void stop();
 
     /**
-     * Get and consume detected objects (thread-safe)
-     * Returns objects from queue and clears the queue immediately
-     * @return Current list of detected objects (will be empty after call)
+     * Start routing messages published to `<topicPrefix><cameraId>` to the given inbox. Does not
+     * touch the broker connection.
      */
-    std::vector<DetectedObject> getAndClearDetectedObjects();
-    
+    void registerInbox(const std::string& cameraId, std::shared_ptr<DetectionInbox> inbox);
+
     /**
-     * Check if we ever received any MQTT message
-     * @return true if at least one message was received
+     * Stop routing the messages of the camera to the given inbox. Does nothing if another inbox
+     * has been registered for the camera since, e.g. by a DeviceAgent created for the same camera
+     * before this one was destroyed.
      */
-    bool hasReceivedData() const;
+    void unregisterInbox(
+        const std::string& cameraId, const std::shared_ptr<DetectionInbox>& inbox);
 
 private:
+    static constexpr size_t kRecentMessageCount = 256;
+
     class Callback : public virtual mqtt::callback
     {
     public:
         explicit Callback(MqttObjectReceiver* receiver) : m_receiver(receiver) {}
-        
+
         void connection_lost(const std::string& cause) override;
         void message_arrived(mqtt::const_message_ptr msg) override;
-        
+
+    private:
+        MqttObjectReceiver* m_receiver;
+    };
+
+    class ConnectListener: public virtual mqtt::iaction_listener
+    {
+    public:
+        explicit ConnectListener(MqttObjectReceiver* receiver): m_receiver(receiver) {}
+
+        void on_failure(const mqtt::token& token) override;
+        void on_success(const mqtt::token& token) override;
+
+    private:
+        MqttObjectReceiver* m_receiver;
+    };
+
+    class SubscribeListener: public virtual mqtt::iaction_listener
+    {
+    public:
+        explicit SubscribeListener(MqttObjectReceiver* receiver): m_receiver(receiver) {}
+
+        void on_failure(const mqtt::token& token) override;
+        void on_success(const mqtt::token& token) override;
+
     private:
         MqttObjectReceiver* m_receiver;
     };
-    
-    void parseDetectionMessage(const std::string& message);
-    void reconnect();
+
+    std::shared_ptr<DetectionInbox> findInbox(const std::string& topic);
+    void resetInboxes();
+    bool parseDetectionMessage(const std::string& payload, DetectionMetrics* metrics);
+    bool isDuplicateMessage(const mqtt::message& message);
+
+    void connectAsync();
+    void subscribeAsync();
+    void scheduleRetry();
+    void retryThreadLoop();
+    void reportConnectionState(bool isSubscribed, const std::string& details);
 
 private:
     std::string m_broker;
     int m_port;
-    std::string m_topic;
-    
-    std::mutex m_objectsMutex;
-    std::vector<DetectedObject> m_detectedObjects;  // Queue of objects to be consumed
-    std::atomic<bool> m_hasReceivedData{false}; // Track if we've ever received MQTT data
-    
-    std::shared_ptr<mqtt::async_client> m_client;
+    std::string m_topicPrefix;
+    std::string m_topicFilter;
+    const int m_qos;
+    const bool m_isSessionPersistent;
+    bool m_isClientIdRandom = false;
+
+    std::mutex m_inboxesMutex;
+    std::unordered_map<std::string, std::shared_ptr<DetectionInbox>> m_inboxByCameraId;
+
+    // Used only from the paho callback thread; reused for every message.
+    DetectionParser m_parser;
+    DetectionBatch m_parsedObjects;
+    bool m_isLatencyTracingEnabled = false;
+    std::array<size_t, kRecentMessageCount> m_recentMessageHashes{};
+    size_t m_recentMessageHashCount = 0;
+
+    // Declared before m_client, so that they are destroyed after it: paho may call them until
+    // then.
     std::shared_ptr<Callback> m_callback;
+    ConnectListener m_connectListener{this};
+    SubscribeListener m_subscribeListener{this};
+
+    std::shared_ptr<mqtt::async_client> m_client;
     mqtt::connect_options m_connOpts;
+
+    ConnectionStateHandler m_connectionStateHandler;
+    std::atomic<int> m_reportedConnectionState{-1}; //< -1 before the first report, then 0 or 1.
+
+    std::thread m_retryThread;
+    std::mutex m_retryMutex;
+    std::condition_variable m_retryCondition;
+    bool m_terminated = false;
+    bool m_isRetryScheduled = false;
+    std::chrono::steady_clock::time_point m_retryDeadline;
+    std::chrono::milliseconds m_retryDelay;
 };
 
 } // namespace object_detection
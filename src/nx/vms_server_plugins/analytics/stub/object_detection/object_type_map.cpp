@@ -0,0 +1,132 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "object_type_map.h"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <utility>
+
+#include "../logging.h"
+#include "stub_analytics_plugin_object_detection_ini.h"
+
+#undef NX_PRINT_PREFIX
+#define NX_PRINT_PREFIX "[Object Type Map] "
+#include <nx/kit/debug.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+static const std::string kDropUnknownLabels = "drop";
+static const std::string kDefaultObjectTypeIdPrefix = "nx.base.";
+
+/** Labels come from the network; keep the cache bounded even if every message invents new ones. */
+static constexpr size_t kMaxCachedLabels = 1024;
+
+static std::string toLower(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(),
+        [](unsigned char c) { return (char) std::tolower(c); });
+    return value;
+}
+
+static std::string trimmed(const std::string& value)
+{
+    const auto isSpace = [](unsigned char c) { return std::isspace(c) != 0; };
+    const auto begin = std::find_if_not(value.begin(), value.end(), isSpace);
+    const auto end = std::find_if_not(value.rbegin(), value.rend(), isSpace).base();
+    return begin < end ? std::string(begin, end) : std::string();
+}
+
+ObjectTypeMap::ObjectTypeMap(
+    const std::string& mapping, const std::string& unknownLabelObjectTypeId)
+    :
+    m_unknownLabelObjectTypeId(trimmed(unknownLabelObjectTypeId)),
+    m_dropUnknownLabels(m_unknownLabelObjectTypeId == kDropUnknownLabels)
+{
+    std::istringstream stream(mapping);
+    std::string pair;
+    while (std::getline(stream, pair, ','))
+    {
+        if (trimmed(pair).empty())
+            continue;
+
+        const size_t separator = pair.find('=');
+        const std::string label =
+            separator == std::string::npos ? "" : toLower(trimmed(pair.substr(0, separator)));
+        const std::string objectTypeId =
+            separator == std::string::npos ? "" : trimmed(pair.substr(separator + 1));
+        if (label.empty() || objectTypeId.empty())
+        {
+            STUB_LOG(LogLevel::warning) << "Ignoring invalid object type mapping entry \""
+                << pair << "\"";
+            continue;
+        }
+
+        m_objectTypeIdByLowercaseLabel[label] = objectTypeId;
+    }
+}
+
+void ObjectTypeMap::setEnabledObjectTypeIds(std::set<std::string> objectTypeIds)
+{
+    m_enabledObjectTypeIds = std::move(objectTypeIds);
+    for (auto& entry: m_resolutionByLabel)
+    {
+        Resolution& resolution = entry.second;
+        resolution.isEnabled =
+            !resolution.objectTypeId.empty() && isEnabled(resolution.objectTypeId);
+    }
+}
+
+const std::string* ObjectTypeMap::enabledObjectTypeId(const std::string& label)
+{
+    auto it = m_resolutionByLabel.find(label);
+    if (it == m_resolutionByLabel.end())
+    {
+        if (m_resolutionByLabel.size() >= kMaxCachedLabels)
+            m_resolutionByLabel.clear();
+
+        Resolution resolution;
+        resolution.objectTypeId = resolveObjectTypeId(label);
+        resolution.isEnabled =
+            !resolution.objectTypeId.empty() && isEnabled(resolution.objectTypeId);
+        it = m_resolutionByLabel.emplace(label, std::move(resolution)).first;
+    }
+
+    return it->second.isEnabled ? &it->second.objectTypeId : nullptr;
+}
+
+std::string ObjectTypeMap::resolveObjectTypeId(const std::string& label) const
+{
+    const std::string lowercaseLabel = toLower(label);
+
+    const auto it = m_objectTypeIdByLowercaseLabel.find(lowercaseLabel);
+    if (it != m_objectTypeIdByLowercaseLabel.end())
+        return it->second;
+
+    if (m_dropUnknownLabels)
+        return std::string();
+
+    if (!m_unknownLabelObjectTypeId.empty())
+        return m_unknownLabelObjectTypeId;
+
+    std::string capitalizedLabel = lowercaseLabel;
+    if (!capitalizedLabel.empty())
+        capitalizedLabel[0] = (char) std::toupper((unsigned char) capitalizedLabel[0]);
+    return kDefaultObjectTypeIdPrefix + capitalizedLabel;
+}
+
+bool ObjectTypeMap::isEnabled(const std::string& objectTypeId) const
+{
+    return m_enabledObjectTypeIds.empty()
+        || m_enabledObjectTypeIds.find(objectTypeId) != m_enabledObjectTypeIds.end();
+}
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
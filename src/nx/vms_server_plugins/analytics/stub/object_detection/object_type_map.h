@@ -0,0 +1,62 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <set>
+#include <string>
+#include <unordered_map>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/**
+ * Resolves detection labels to object type ids, and tells whether the type is enabled in the
+ * DeviceAgent settings. Each distinct label is resolved once and cached together with the
+ * enabled decision, so the per-detection lookup is a single hash probe without allocations.
+ *
+ * Not thread-safe.
+ */
+class ObjectTypeMap
+{
+public:
+    /**
+     * @param mapping Comma-separated `label=objectTypeId` pairs; labels are case-insensitive,
+     *     e.g. `person=nx.base.Person,truck=nx.base.Truck`.
+     * @param unknownLabelObjectTypeId Object type for the labels missing from the mapping:
+     *     empty means `nx.base.` followed by the capitalized label, `drop` means ignoring such
+     *     detections.
+     */
+    ObjectTypeMap(const std::string& mapping, const std::string& unknownLabelObjectTypeId);
+
+    /** @param objectTypeIds Enabled object types; empty means all types are enabled. */
+    void setEnabledObjectTypeIds(std::set<std::string> objectTypeIds);
+
+    /** @return Null if detections with this label must not be sent. */
+    const std::string* enabledObjectTypeId(const std::string& label);
+
+private:
+    struct Resolution
+    {
+        std::string objectTypeId; //< Empty if the label is dropped.
+        bool isEnabled = false;
+    };
+
+    std::string resolveObjectTypeId(const std::string& label) const;
+    bool isEnabled(const std::string& objectTypeId) const;
+
+private:
+    std::unordered_map<std::string, std::string> m_objectTypeIdByLowercaseLabel;
+    std::string m_unknownLabelObjectTypeId;
+    bool m_dropUnknownLabels = false;
+    std::set<std::string> m_enabledObjectTypeIds;
+    std::unordered_map<std::string, Resolution> m_resolutionByLabel;
+};
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -30,11 +30,13 @@ std::string Plugin::manifestString() const
         "description": "An example Plugin for demonstrating the Base Library of Taxonomy and providing examples of object metadata generation.",
         "version": "1.0.0",
         "vendor": "Plugin vendor",
-        "isLicenseRequired": %s
+        "isLicenseRequired": %s,
+        "engineSettingsModel": {"type": "Settings", "items": [%s]}
     }
     )json";
 
-    return nx::kit::utils::format(manifest, ini().isLicenseRequired ? "true" : "false");
+    return nx::kit::utils::format(manifest, ini().isLicenseRequired ? "true" : "false",
+        logLevelSettingModel(ini().logLevel).c_str());
 }
 
 } // namespace object_detection
@@ -0,0 +1,193 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "roi_filter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+static constexpr int kSampleCountPerSide = 4; //< For the boxes too small for the mask.
+
+void RoiFilter::setZones(
+    const std::vector<Polygon>& includedZones,
+    const std::vector<Polygon>& excludedZones,
+    float minCoverage)
+{
+    m_includedZones.compile(includedZones);
+    m_excludedZones.compile(excludedZones);
+    m_minCoverage = std::min(std::max(minCoverage, 0.01F), 1.0F);
+}
+
+bool RoiFilter::isAccepted(float x, float y, float width, float height) const
+{
+    if (!m_excludedZones.isEmpty()
+        && m_excludedZones.coverage(x, y, width, height) >= m_minCoverage)
+    {
+        return false;
+    }
+
+    if (!m_includedZones.isEmpty()
+        && m_includedZones.coverage(x, y, width, height) < m_minCoverage)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+RoiFilter::ZoneMask::EdgeTable RoiFilter::ZoneMask::makeEdgeTable(const Polygon& polygon)
+{
+    EdgeTable edges;
+    edges.reserve(polygon.size());
+    for (size_t i = 0; i < polygon.size(); ++i)
+    {
+        Point a = polygon[i];
+        Point b = polygon[(i + 1) % polygon.size()];
+        if (a.y == b.y)
+            continue; //< Never crossed by a scanline.
+        if (a.y > b.y)
+            std::swap(a, b);
+
+        Edge edge;
+        edge.yMin = a.y;
+        edge.yMax = b.y;
+        edge.xAtYMin = a.x;
+        edge.dxPerDy = (b.x - a.x) / (b.y - a.y);
+        edges.push_back(edge);
+    }
+
+    std::sort(edges.begin(), edges.end(),
+        [](const Edge& a, const Edge& b) { return a.yMin < b.yMin; });
+    return edges;
+}
+
+void RoiFilter::ZoneMask::fillScanline(
+    const EdgeTable& edges, float y, std::vector<float>* crossings, uint8_t* row)
+{
+    crossings->clear();
+    for (const Edge& edge: edges)
+    {
+        if (edge.yMin > y)
+            break;
+        if (y < edge.yMax)
+            crossings->push_back(edge.xAtYMin + (y - edge.yMin) * edge.dxPerDy);
+    }
+    std::sort(crossings->begin(), crossings->end());
+
+    // Even-odd rule: the cells whose centers lie between a pair of crossings are inside.
+    for (size_t i = 0; i + 1 < crossings->size(); i += 2)
+    {
+        const int begin = std::max(0, (int) std::ceil((*crossings)[i] * kGridSize - 0.5F));
+        const int end = std::min(kGridSize,
+            (int) std::ceil((*crossings)[i + 1] * kGridSize - 0.5F));
+        for (int column = begin; column < end; ++column)
+            row[column] = 1;
+    }
+}
+
+void RoiFilter::ZoneMask::compile(const std::vector<Polygon>& polygons)
+{
+    m_polygonEdges.clear();
+    for (const Polygon& polygon: polygons)
+    {
+        if (polygon.size() >= 3)
+            m_polygonEdges.push_back(makeEdgeTable(polygon));
+    }
+
+    m_summedArea.clear();
+    if (m_polygonEdges.empty())
+        return;
+
+    // Each polygon is filled separately, so that overlapping zones make a union.
+    std::vector<uint8_t> mask((size_t) kGridSize * kGridSize, 0);
+    std::vector<float> crossings;
+    for (const EdgeTable& edges: m_polygonEdges)
+    {
+        for (int row = 0; row < kGridSize; ++row)
+        {
+            const float y = (row + 0.5F) / kGridSize;
+            fillScanline(edges, y, &crossings, &mask[(size_t) row * kGridSize]);
+        }
+    }
+
+    constexpr int kStride = kGridSize + 1;
+    m_summedArea.assign((size_t) kStride * kStride, 0);
+    for (int row = 0; row < kGridSize; ++row)
+    {
+        uint32_t rowSum = 0;
+        for (int column = 0; column < kGridSize; ++column)
+        {
+            rowSum += mask[(size_t) row * kGridSize + column];
+            m_summedArea[(size_t) (row + 1) * kStride + column + 1] =
+                m_summedArea[(size_t) row * kStride + column + 1] + rowSum;
+        }
+    }
+}
+
+bool RoiFilter::ZoneMask::contains(float x, float y) const
+{
+    for (const EdgeTable& edges: m_polygonEdges)
+    {
+        bool isInside = false;
+        for (const Edge& edge: edges)
+        {
+            if (edge.yMin > y)
+                break;
+            if (y < edge.yMax && edge.xAtYMin + (y - edge.yMin) * edge.dxPerDy > x)
+                isInside = !isInside;
+        }
+        if (isInside)
+            return true;
+    }
+    return false;
+}
+
+float RoiFilter::ZoneMask::sampledCoverage(float x, float y, float width, float height) const
+{
+    int insideCount = 0;
+    for (int i = 0; i < kSampleCountPerSide; ++i)
+    {
+        const float sampleY = y + height * (i + 0.5F) / kSampleCountPerSide;
+        for (int j = 0; j < kSampleCountPerSide; ++j)
+        {
+            const float sampleX = x + width * (j + 0.5F) / kSampleCountPerSide;
+            insideCount += contains(sampleX, sampleY) ? 1 : 0;
+        }
+    }
+    return (float) insideCount / (kSampleCountPerSide * kSampleCountPerSide);
+}
+
+float RoiFilter::ZoneMask::coverage(float x, float y, float width, float height) const
+{
+    // Only the part of the box within the frame counts.
+    const float left = std::min(std::max(x, 0.0F), 1.0F);
+    const float top = std::min(std::max(y, 0.0F), 1.0F);
+    const float right = std::min(std::max(x + width, 0.0F), 1.0F);
+    const float bottom = std::min(std::max(y + height, 0.0F), 1.0F);
+    if (right <= left || bottom <= top)
+        return 0.0F;
+
+    const int column0 = (int) std::lround(left * kGridSize);
+    const int column1 = (int) std::lround(right * kGridSize);
+    const int row0 = (int) std::lround(top * kGridSize);
+    const int row1 = (int) std::lround(bottom * kGridSize);
+    if (column1 - column0 < 2 || row1 - row0 < 2)
+        return sampledCoverage(left, top, right - left, bottom - top);
+
+    constexpr int kStride = kGridSize + 1;
+    const auto at = [this](int row, int column) { return m_summedArea[row * kStride + column]; };
+    const uint32_t coveredCellCount =
+        at(row1, column1) - at(row0, column1) - at(row1, column0) + at(row0, column0);
+    return (float) coveredCellCount / (float) ((column1 - column0) * (row1 - row0));
+}
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
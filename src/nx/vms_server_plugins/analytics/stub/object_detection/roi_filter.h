@@ -0,0 +1,95 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../geometry_set.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/**
+ * Decides whether a detection lies in the regions of interest drawn in the DeviceAgent settings,
+ * by the part of its box covered by the included and by the excluded zones.
+ *
+ * The zones are compiled once, when they change: every polygon is turned into an edge table
+ * sorted by y, the union of the polygons of each kind is rasterized from it into a
+ * kGridSize x kGridSize mask by scanline filling, and the mask is turned into a summed-area
+ * table. The coverage of a box is then four lookups, whatever the polygons. Boxes spanning less
+ * than two grid cells, for which the mask is too coarse, are sampled against the edge tables
+ * instead.
+ *
+ * Not thread-safe.
+ */
+class RoiFilter
+{
+public:
+    static constexpr int kGridSize = 256;
+
+    using Point = GeometryPoint;
+    using Polygon = std::vector<Point>;
+
+    /**
+     * @param minCoverage In 0..1. A box is rejected if it is covered by the excluded zones at
+     *     least this much, or if there are included zones and they cover less of it.
+     */
+    void setZones(
+        const std::vector<Polygon>& includedZones,
+        const std::vector<Polygon>& excludedZones,
+        float minCoverage);
+
+    /** Whether no zones are set, so that every box is accepted. */
+    bool isEmpty() const { return m_includedZones.isEmpty() && m_excludedZones.isEmpty(); }
+
+    bool isAccepted(float x, float y, float width, float height) const;
+
+private:
+    class ZoneMask
+    {
+    public:
+        void compile(const std::vector<Polygon>& polygons);
+        bool isEmpty() const { return m_polygonEdges.empty(); }
+
+        /** Part of the box inside the zones, in 0..1. */
+        float coverage(float x, float y, float width, float height) const;
+
+    private:
+        struct Edge
+        {
+            float yMin = 0.0F;
+            float yMax = 0.0F; //< Exclusive.
+            float xAtYMin = 0.0F;
+            float dxPerDy = 0.0F;
+        };
+
+        using EdgeTable = std::vector<Edge>; //< Sorted by yMin; horizontal edges are omitted.
+
+        static EdgeTable makeEdgeTable(const Polygon& polygon);
+        static void fillScanline(
+            const EdgeTable& edges, float y, std::vector<float>* crossings, uint8_t* row);
+        bool contains(float x, float y) const;
+        float sampledCoverage(float x, float y, float width, float height) const;
+
+    private:
+        std::vector<EdgeTable> m_polygonEdges;
+
+        /** (kGridSize + 1)^2; the number of masked cells above and to the left of a node. */
+        std::vector<uint32_t> m_summedArea;
+    };
+
+private:
+    ZoneMask m_includedZones;
+    ZoneMask m_excludedZones;
+    float m_minCoverage = 0.5F;
+};
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
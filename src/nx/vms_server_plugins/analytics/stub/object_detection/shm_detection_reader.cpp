@@ -0,0 +1,289 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "shm_detection_reader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "../logging.h"
+#include "detection_binary_format.h"
+#include "latency_tracer.h"
+#include "stub_analytics_plugin_object_detection_ini.h"
+
+#undef NX_PRINT_PREFIX
+#define NX_PRINT_PREFIX "[Shared Memory Detections] "
+#include <nx/kit/debug.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+using namespace std::chrono;
+
+static constexpr char kMagic[] = {'N', 'X', 'D', 'R'};
+static constexpr uint32_t kVersion = 1;
+static constexpr size_t kWriteIndexOffset = 64;
+static constexpr size_t kSlotsOffset = 128;
+static constexpr size_t kSlotHeaderSize = 16;
+static constexpr uint32_t kMaxSlotCount = 1 << 16;
+static constexpr uint32_t kMaxSlotSize = 1 << 20;
+
+static constexpr milliseconds kOpenRetryPeriod{1000};
+
+/** After this long without messages, check whether the detector has recreated the segment. */
+static constexpr milliseconds kIdleReopenCheckPeriod{2000};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+    "The shared memory ring needs address-free 64-bit atomics.");
+
+namespace {
+
+struct RingHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotSize;
+};
+
+} // namespace
+
+static const std::atomic<uint64_t>* atomicAt(const void* data, size_t offset)
+{
+    return reinterpret_cast<const std::atomic<uint64_t>*>((const char*) data + offset);
+}
+
+ShmDetectionReader::ShmDetectionReader(const std::string& cameraId):
+    m_segmentName(segmentName(cameraId)),
+    m_isLatencyTracingEnabled(ini().enableLatencyTracing)
+{
+}
+
+ShmDetectionReader::~ShmDetectionReader()
+{
+    close();
+}
+
+std::string ShmDetectionReader::segmentName(const std::string& cameraId)
+{
+    return "/nx_detections_" + cameraId;
+}
+
+void ShmDetectionReader::poll(DetectionInbox* inbox)
+{
+    const auto now = steady_clock::now();
+
+    if (m_data && now - m_lastMessageTime > kIdleReopenCheckPeriod)
+    {
+        m_lastMessageTime = now;
+        if (isSegmentReplaced())
+        {
+            STUB_LOG(LogLevel::info)
+                << "Segment " << m_segmentName << " was recreated by the detector";
+            close();
+        }
+    }
+
+    if (!m_data)
+    {
+        if (now - m_lastOpenAttemptTime < kOpenRetryPeriod)
+            return;
+        m_lastOpenAttemptTime = now;
+        if (!open())
+            return;
+        m_lastMessageTime = now;
+    }
+
+    const uint64_t writeIndex =
+        atomicAt(m_data, kWriteIndexOffset)->load(std::memory_order_acquire);
+    if (writeIndex < m_readIndex) //< The detector has reset the ring in place.
+        m_readIndex = writeIndex;
+    if (writeIndex - m_readIndex > m_slotCount)
+    {
+        m_skippedMessageCount += writeIndex - m_readIndex - m_slotCount;
+        m_readIndex = writeIndex - m_slotCount;
+    }
+
+    std::string error;
+    for (; m_readIndex < writeIndex; ++m_readIndex)
+    {
+        const size_t slotOffset = kSlotsOffset + (size_t) (m_readIndex % m_slotCount) * m_slotSize;
+        const std::atomic<uint64_t>* const sequence = atomicAt(m_data, slotOffset);
+        const uint64_t expectedSequence = 2 * m_readIndex + 2;
+
+        if (sequence->load(std::memory_order_acquire) != expectedSequence)
+        {
+            ++m_skippedMessageCount; //< Being overwritten by a newer message.
+            continue;
+        }
+
+        const char* const slot = (const char*) m_data + slotOffset;
+        uint32_t payloadSize = 0;
+        memcpy(&payloadSize, slot + 8, sizeof(payloadSize));
+        payloadSize = std::min(payloadSize, (uint32_t) (m_slotSize - kSlotHeaderSize));
+
+        const int64_t arrivedUs = m_isLatencyTracingEnabled ? traceTimeUs() : 0;
+        const auto decodingStartTime = steady_clock::now();
+        const bool isDecoded = decodeBinaryDetections(
+            slot + kSlotHeaderSize, payloadSize, &m_batch, &error);
+        inbox->metrics()->parseDurationUs->record(
+            duration_cast<microseconds>(steady_clock::now() - decodingStartTime).count());
+
+        // Validate that the writer has not touched the slot while it was being decoded.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence->load(std::memory_order_relaxed) != expectedSequence)
+        {
+            ++m_skippedMessageCount;
+            continue;
+        }
+
+        if (!isDecoded)
+        {
+            inbox->metrics()->parseFailures->add();
+            STUB_LOG_THROTTLED(LogLevel::warning, 1) << error;
+            continue;
+        }
+
+        if (m_isLatencyTracingEnabled)
+        {
+            // The slot is seen only when polled, so the ring time is accounted as transport.
+            m_batch.trace().arrivedUs = arrivedUs;
+            m_batch.trace().parsedUs = traceTimeUs();
+        }
+
+        inbox->putDetectedObjects(&m_batch);
+        m_lastMessageTime = now;
+    }
+}
+
+#if !defined(_WIN32)
+
+bool ShmDetectionReader::open()
+{
+    const int fd = shm_open(m_segmentName.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        if (!m_isOpenFailureReported)
+        {
+            STUB_LOG(LogLevel::info)
+                << "Waiting for the detector to create " << m_segmentName << ": "
+                << strerror(errno);
+            m_isOpenFailureReported = true;
+        }
+        return false;
+    }
+
+    struct stat status;
+    RingHeader header{};
+    void* data = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && (size_t) status.st_size >= kSlotsOffset)
+        data = mmap(nullptr, (size_t) status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+        return false; //< The detector may still be sizing the segment.
+
+    memcpy(&header, data, sizeof(header));
+    const bool isValid = memcmp(header.magic, kMagic, sizeof(kMagic)) == 0
+        && header.version == kVersion
+        && header.slotCount > 0 && header.slotCount <= kMaxSlotCount
+        && header.slotSize > kSlotHeaderSize && header.slotSize <= kMaxSlotSize
+        && header.slotSize % 8 == 0
+        && kSlotsOffset + (size_t) header.slotCount * header.slotSize <= (size_t) status.st_size;
+    if (!isValid)
+    {
+        munmap(data, (size_t) status.st_size);
+        if (!m_isOpenFailureReported)
+        {
+            STUB_LOG(LogLevel::warning)
+                << "Segment " << m_segmentName << " has an unsupported layout";
+            m_isOpenFailureReported = true;
+        }
+        return false;
+    }
+
+    m_data = data;
+    m_size = (size_t) status.st_size;
+    m_deviceId = (uint64_t) status.st_dev;
+    m_inode = (uint64_t) status.st_ino;
+    m_slotCount = header.slotCount;
+    m_slotSize = header.slotSize;
+
+    // Only the messages published from now on are relevant for the live video.
+    m_readIndex = atomicAt(m_data, kWriteIndexOffset)->load(std::memory_order_acquire);
+    m_isOpenFailureReported = false;
+
+    STUB_LOG(LogLevel::info) << "Reading " << m_segmentName << ": " << m_slotCount << " slots of "
+        << m_slotSize << " bytes";
+    return true;
+}
+
+void ShmDetectionReader::close()
+{
+    if (!m_data)
+        return;
+
+    munmap(m_data, m_size);
+    m_data = nullptr;
+    m_size = 0;
+
+    if (m_skippedMessageCount > 0)
+    {
+        STUB_LOG(LogLevel::warning) << "Skipped " << m_skippedMessageCount
+            << " messages overwritten before reading";
+        m_skippedMessageCount = 0;
+    }
+}
+
+bool ShmDetectionReader::isSegmentReplaced() const
+{
+    const int fd = shm_open(m_segmentName.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return false; //< Unlinked: keep the old mapping until a new segment appears.
+
+    struct stat status;
+    const bool isReplaced = fstat(fd, &status) == 0
+        && ((uint64_t) status.st_dev != m_deviceId || (uint64_t) status.st_ino != m_inode);
+    ::close(fd);
+    return isReplaced;
+}
+
+#else // !defined(_WIN32)
+
+bool ShmDetectionReader::open()
+{
+    if (!m_isOpenFailureReported)
+    {
+        STUB_LOG(LogLevel::error) << "Shared memory transport is not supported on this platform";
+        m_isOpenFailureReported = true;
+    }
+    return false;
+}
+
+void ShmDetectionReader::close()
+{
+}
+
+bool ShmDetectionReader::isSegmentReplaced() const
+{
+    return false;
+}
+
+#endif // !defined(_WIN32)
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,86 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "detection_batch.h"
+#include "detection_inbox.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/**
+ * Receives detections from a detector running on the same host through a POSIX shared memory
+ * ring, bypassing the MQTT broker. The detector creates the segment `/nx_detections_<cameraId>`
+ * and is its only writer; the DeviceAgent maps it read-only and polls it on the video thread.
+ *
+ * Segment layout, native byte order (the processes share the host):
+ * - Header, 64 bytes: magic "NXDR", uint32 version (1), uint32 slot count, uint32 slot size
+ *     (a multiple of 8, including the slot header); the rest is reserved.
+ * - uint64 write index at offset 64: the number of messages published so far.
+ * - Slots from offset 128. Each starts with a uint64 sequence number and a uint32 payload size,
+ *     followed by 4 reserved bytes and the payload: a message in the binary detection format
+ *     (see detection_binary_format.h).
+ *
+ * Message `i` goes to slot `i % slotCount`. The writer sets the slot sequence to `2 * i + 1`,
+ * writes the payload, sets the sequence to `2 * i + 2`, and then the write index to `i + 1`, so
+ * the ring is lock-free and the writer never waits for the reader. The reader decodes the payload
+ * in place and discards it if the sequence has changed meanwhile; messages overwritten before
+ * they were read are skipped.
+ *
+ * The reference producer is scripts/shm_detection_producer.py.
+ */
+class ShmDetectionReader
+{
+public:
+    explicit ShmDetectionReader(const std::string& cameraId);
+    ~ShmDetectionReader();
+
+    ShmDetectionReader(const ShmDetectionReader&) = delete;
+    ShmDetectionReader& operator=(const ShmDetectionReader&) = delete;
+
+    /**
+     * Puts the messages published since the previous call into the inbox. Maps the segment
+     * when the detector has created it, and maps it again when the detector has restarted.
+     */
+    void poll(DetectionInbox* inbox);
+
+    static std::string segmentName(const std::string& cameraId);
+
+private:
+    bool open();
+    void close();
+    bool isSegmentReplaced() const;
+
+private:
+    const std::string m_segmentName;
+    const bool m_isLatencyTracingEnabled;
+
+    void* m_data = nullptr;
+    size_t m_size = 0;
+    uint64_t m_deviceId = 0;
+    uint64_t m_inode = 0;
+    uint32_t m_slotCount = 0;
+    uint32_t m_slotSize = 0;
+
+    uint64_t m_readIndex = 0;
+    uint64_t m_skippedMessageCount = 0;
+    bool m_isOpenFailureReported = false;
+    std::chrono::steady_clock::time_point m_lastOpenAttemptTime;
+    std::chrono::steady_clock::time_point m_lastMessageTime;
+
+    DetectionBatch m_batch; //< Reused for every message.
+};
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
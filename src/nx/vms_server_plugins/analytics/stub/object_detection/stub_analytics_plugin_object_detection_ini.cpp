@@ -14,6 +14,12 @@ Ini& ini()
     return ini;
 }
 
+RuntimeLogLevel& runtimeLogLevel()
+{
+    static RuntimeLogLevel level(ini().logLevel);
+    return level;
+}
+
 } // namespace object_detection
 } // namespace stub
 } // namespace analytics
@@ -5,6 +5,8 @@
 #include <nx/kit/ini_config.h>
 #include <nx/sdk/analytics/helpers/pixel_format.h>
 
+#include "../logging.h"
+
 namespace nx {
 namespace vms_server_plugins {
 namespace analytics {
@@ -17,10 +19,83 @@ struct Ini: public nx::kit::IniConfig
 
     NX_INI_FLAG(0, enableOutput, "");
     NX_INI_FLAG(0, isLicenseRequired, "Whether the Plugin declares in its manifest that it requires a license.");
+
+    NX_INI_INT(3, logLevel,
+        "Messages up to this level are printed: 0 - none, 1 - errors, 2 - warnings, 3 - info,\n"
+        "4 - debug, 5 - trace. Levels above the STUB_LOG_MAX_LEVEL build option are compiled out.\n"
+        "This is the initial level, and the default of the Engine setting which switches it.");
+
+    NX_INI_INT(1, mqttQos,
+        "QoS of the subscription to the detection topics: 0 or 1. With 1, messages published\n"
+        "while the connection is down are replayed by the broker if mqttPersistentSession is set.");
+
+    NX_INI_FLAG(1, mqttPersistentSession,
+        "Whether the broker keeps the session, i.e. the subscription and the undelivered QoS 1\n"
+        "messages, while the connection is down. The number of messages kept is limited only by\n"
+        "the session queue limit of the broker; detectionBufferCapacity bounds them on arrival.");
+
+    NX_INI_STRING("", mqttClientId,
+        "MQTT client ID; must be unique among the broker clients. If empty, a random one is\n"
+        "generated on start, so a persistent session survives reconnects but not restarts.");
+
+    NX_INI_INT(16, detectionBufferCapacity,
+        "Max number of timestamped detection messages per camera waiting for their video frame.");
+
+    NX_INI_INT(1024, trackTableCapacity,
+        "Max number of tracks per camera whose UUIDs are cached; the least recently seen track is\n"
+        "evicted first. Track UUIDs are derived from the trackId, so eviction does not change\n"
+        "them.");
+
+    NX_INI_INT(10000, trackTtlMs,
+        "Tracks not seen for this many milliseconds are removed from the track table. A publisher\n"
+        "sending no trackEpoch is taken for restarted, with its trackIds reused for new objects,\n"
+        "after a gap this long between its messages.");
+
+    NX_INI_INT(2000, zoneReleaseDelayMs,
+        "Objects are counted in an occupancy zone until they have been outside it, or undetected,\n"
+        "for this many milliseconds, so that zone events do not flicker with the detections.");
+
+    NX_INI_INT(2000, bestShotTrackEndMs,
+        "A track is considered ended once it has not been detected for this many milliseconds;\n"
+        "its best shot is sent then, unless the best shot deadline from the settings came first.");
+
+    NX_INI_STRING("", objectTypeMapping,
+        "Comma-separated label=objectTypeId pairs, labels are case-insensitive, e.g.\n"
+        "\"person=nx.base.Person,truck=nx.base.Truck\".");
+
+    NX_INI_STRING("", unknownLabelObjectTypeId,
+        "Object type for the labels missing from objectTypeMapping. If empty, \"nx.base.\"\n"
+        "followed by the capitalized label is used; \"drop\" makes such detections ignored.");
+
+    NX_INI_STRING("", metricsExportTarget,
+        "Where the metrics of all cameras are published in the Prometheus text format: a file\n"
+        "path, rewritten every metricsExportPeriodMs, or \"unix:\" followed by the path of a Unix\n"
+        "socket answering HTTP requests. Empty means no export.");
+
+    NX_INI_INT(10000, metricsExportPeriodMs,
+        "Period of rewriting the metricsExportTarget file.");
+
+    NX_INI_INT(0, metricsSummaryPeriodS,
+        "If > 0, a summary of the metrics is pushed as a Plugin Diagnostic Event with this\n"
+        "period.");
+
+    NX_INI_FLAG(0, enableLatencyTracing,
+        "Stamp every detection message on its way from the publisher to the Server and collect\n"
+        "the per-stage latencies into the stub_object_detection_stage_latency_us metrics.");
+
+    NX_INI_STRING("", latencyTraceFile,
+        "If not empty and enableLatencyTracing is set, the stages of every message are also\n"
+        "written to this file as Chrome trace events, viewable in chrome://tracing.");
+
+    NX_INI_INT(1000000, latencyTraceMaxEventCount,
+        "Max number of events written to latencyTraceFile.");
 };
 
 Ini& ini();
 
+/** Starts from ini().logLevel; switched by the Engine settings. */
+RuntimeLogLevel& runtimeLogLevel();
+
 } // namespace object_detection
 } // namespace stub
 } // namespace analytics
@@ -0,0 +1,116 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "track_predictor.h"
+
+#include <algorithm>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/** Share of the measurement in the filtered position; the rest is the prediction. */
+static constexpr float kPositionGain = 0.85F;
+
+/** Share of the prediction error which is attributed to a change of the velocity. */
+static constexpr float kVelocityGain = 0.35F;
+
+static constexpr float kMicrosecondsPerSecond = 1000000.0F;
+
+/** Advances one coordinate of the filter to the measurement taken dtS seconds later. */
+static void updateCoordinate(float measured, float dtS, float* value, float* velocity)
+{
+    const float predicted = *value + *velocity * dtS;
+    const float error = measured - predicted;
+    *value = predicted + kPositionGain * error;
+    *velocity += kVelocityGain * error / dtS;
+}
+
+void TrackPredictor::update(const DetectionBatch& detections, int64_t timestampUs)
+{
+    if (detections.trackEpoch() != m_trackEpoch)
+    {
+        m_tracks.clear(); //< The detector has restarted; its trackId values mean other objects.
+        m_trackEpoch = detections.trackEpoch();
+    }
+
+    ++m_updateIndex;
+    for (const DetectedObject& detection: detections)
+    {
+        Track& track = m_tracks[detection.trackId];
+        const bool isNewTrack = track.updateIndex == 0;
+        const float dtS = (timestampUs - track.timestampUs) / kMicrosecondsPerSecond;
+
+        if (isNewTrack)
+        {
+            track.object = detection;
+            track.timestampUs = timestampUs;
+        }
+        else if (dtS <= 0.0F)
+        {
+            // A repeated or reordered result: no motion can be estimated from it.
+            track.object.confidence = detection.confidence;
+        }
+        else
+        {
+            updateCoordinate(detection.x, dtS, &track.object.x, &track.velocityX);
+            updateCoordinate(detection.y, dtS, &track.object.y, &track.velocityY);
+            updateCoordinate(detection.width, dtS, &track.object.width, &track.velocityWidth);
+            updateCoordinate(detection.height, dtS, &track.object.height, &track.velocityHeight);
+            track.object.label = detection.label;
+            track.object.name = detection.name;
+            track.object.confidence = detection.confidence;
+            track.timestampUs = timestampUs;
+        }
+
+        track.updateIndex = m_updateIndex;
+    }
+
+    for (auto it = m_tracks.begin(); it != m_tracks.end();)
+    {
+        if (it->second.updateIndex != m_updateIndex)
+            it = m_tracks.erase(it);
+        else
+            ++it;
+    }
+}
+
+void TrackPredictor::predict(
+    int64_t frameTimestampUs, int64_t horizonUs, DetectionBatch* outDetections)
+{
+    outDetections->clear();
+    outDetections->setTimestampUs(frameTimestampUs);
+    outDetections->setTrackEpoch(m_trackEpoch);
+
+    for (auto it = m_tracks.begin(); it != m_tracks.end();)
+    {
+        const Track& track = it->second;
+        const int64_t ageUs = frameTimestampUs - track.timestampUs;
+        if (ageUs > horizonUs)
+        {
+            it = m_tracks.erase(it);
+            continue;
+        }
+
+        const float dtS = ageUs / kMicrosecondsPerSecond;
+        DetectedObject& object = outDetections->append();
+        object = track.object;
+        object.width = std::clamp(track.object.width + track.velocityWidth * dtS, 0.0F, 1.0F);
+        object.height = std::clamp(track.object.height + track.velocityHeight * dtS, 0.0F, 1.0F);
+        object.x = std::clamp(track.object.x + track.velocityX * dtS, 0.0F, 1.0F - object.width);
+        object.y = std::clamp(track.object.y + track.velocityY * dtS, 0.0F, 1.0F - object.height);
+        ++it;
+    }
+}
+
+void TrackPredictor::clear()
+{
+    m_tracks.clear();
+}
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
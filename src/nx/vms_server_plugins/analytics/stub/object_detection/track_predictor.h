@@ -0,0 +1,69 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "detection_batch.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/**
+ * Keeps a constant-velocity motion model per track, so that boxes can be shown on every video
+ * frame while the detector runs at a lower frame rate, and so that the detector latency can be
+ * compensated.
+ *
+ * Each track is an alpha-beta filter (the steady-state form of a constant-velocity Kalman filter)
+ * over the box position and size. Predicting a box for a frame between two detector results
+ * extrapolates along the current velocity, which for a steadily moving object is the same as
+ * interpolating between the results.
+ *
+ * Not thread-safe.
+ */
+class TrackPredictor
+{
+public:
+    /**
+     * Updates the tracks with a detector result. Each result lists all visible objects, so the
+     * tracks missing from it are ended. Detections with the same trackId in one result are
+     * treated as one object, the last one wins.
+     * @param timestampUs Timestamp of the frame the detector has processed.
+     */
+    void update(const DetectionBatch& detections, int64_t timestampUs);
+
+    /**
+     * Fills the batch with the boxes predicted for the given frame. Tracks whose last result is
+     * older than the horizon are ended instead.
+     */
+    void predict(int64_t frameTimestampUs, int64_t horizonUs, DetectionBatch* outDetections);
+
+    void clear();
+
+private:
+    struct Track
+    {
+        DetectedObject object; //< Last detection, with the filtered box.
+        float velocityX = 0.0F; //< Per second, as the velocities below.
+        float velocityY = 0.0F;
+        float velocityWidth = 0.0F;
+        float velocityHeight = 0.0F;
+        int64_t timestampUs = 0;
+        uint64_t updateIndex = 0; //< Index of the last update() which has seen the track.
+    };
+
+private:
+    std::unordered_map<int, Track> m_tracks;
+    int64_t m_trackEpoch = 0;
+    uint64_t m_updateIndex = 0;
+};
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
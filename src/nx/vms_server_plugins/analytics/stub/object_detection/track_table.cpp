@@ -0,0 +1,177 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "track_table.h"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+using nx::sdk::Uuid;
+
+static constexpr uint64_t kFnvOffsetBasis = 0xCBF29CE484222325ULL;
+static constexpr uint64_t kFnvPrime = 0x100000001B3ULL;
+
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t size)
+{
+    const auto* bytes = (const uint8_t*) data;
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i]) * kFnvPrime;
+    return hash;
+}
+
+static uint64_t fnv1a(uint64_t hash, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+        hash = (hash ^ ((value >> (i * 8)) & 0xFF)) * kFnvPrime;
+    return hash;
+}
+
+/** SplitMix64 finalizer: spreads every input bit over the whole result. */
+static uint64_t mix(uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+Uuid TrackTable::deriveUuid(const std::string& cameraId, int trackId, int64_t trackEpoch)
+{
+    uint64_t hash = fnv1a(kFnvOffsetBasis, cameraId.data(), cameraId.size());
+    hash = fnv1a(hash, (uint64_t) (uint32_t) trackId);
+    hash = fnv1a(hash, (uint64_t) trackEpoch);
+
+    const uint64_t high = mix(hash);
+    const uint64_t low = mix(hash ^ high);
+
+    std::array<uint8_t, Uuid::kSize> bytes;
+    for (int i = 0; i < 8; ++i)
+    {
+        bytes[i] = (uint8_t) (high >> (56 - i * 8));
+        bytes[8 + i] = (uint8_t) (low >> (56 - i * 8));
+    }
+
+    // RFC 9562 version 8 (custom) UUID with the RFC variant, to never collide with the random
+    // (version 4) UUIDs generated elsewhere.
+    bytes[6] = (uint8_t) ((bytes[6] & 0x0F) | 0x80);
+    bytes[8] = (uint8_t) ((bytes[8] & 0x3F) | 0x80);
+
+    return Uuid(bytes);
+}
+
+size_t TrackTable::KeyHash::operator()(const Key& key) const
+{
+    return (size_t) mix(((uint64_t) (uint32_t) key.trackId) ^ ((uint64_t) key.trackEpoch << 32)
+        ^ (uint64_t) key.trackEpoch);
+}
+
+TrackTable::TrackTable(std::string cameraId, int capacity, int64_t ttlUs):
+    m_cameraId(std::move(cameraId)),
+    m_ttlUs(ttlUs),
+    m_entries((size_t) std::max(capacity, 1))
+{
+    m_freeIndices.reserve(m_entries.size());
+    for (int i = (int) m_entries.size() - 1; i >= 0; --i)
+        m_freeIndices.push_back(i);
+    m_indexByKey.reserve(m_entries.size());
+}
+
+int64_t TrackTable::trackEpoch(int64_t publishedEpoch, int64_t batchTimestampUs)
+{
+    const int64_t gapUs = batchTimestampUs - m_lastBatchTimestampUs;
+    const bool isAfterGap = m_lastBatchTimestampUs >= 0 && gapUs > m_ttlUs;
+    m_lastBatchTimestampUs = batchTimestampUs;
+
+    if (publishedEpoch != 0)
+        return publishedEpoch;
+
+    if (isAfterGap)
+        --m_unpublishedEpoch;
+    return m_unpublishedEpoch;
+}
+
+Uuid TrackTable::trackUuid(int trackId, int64_t trackEpoch, int64_t nowUs)
+{
+    const Key key{trackId, trackEpoch};
+
+    const auto it = m_indexByKey.find(key);
+    if (it != m_indexByKey.end())
+    {
+        Entry& entry = m_entries[it->second];
+        entry.lastSeenUs = nowUs;
+        if (it->second != m_head)
+        {
+            unlink(it->second);
+            pushFront(it->second);
+        }
+        return entry.uuid;
+    }
+
+    if (m_freeIndices.empty())
+        remove(m_tail);
+
+    const int index = m_freeIndices.back();
+    m_freeIndices.pop_back();
+
+    Entry& entry = m_entries[index];
+    entry.key = key;
+    entry.uuid = deriveUuid(m_cameraId, trackId, trackEpoch);
+    entry.lastSeenUs = nowUs;
+    pushFront(index);
+    m_indexByKey.emplace(key, index);
+
+    return entry.uuid;
+}
+
+void TrackTable::removeExpired(int64_t nowUs)
+{
+    while (m_tail != -1 && nowUs - m_entries[m_tail].lastSeenUs > m_ttlUs)
+        remove(m_tail);
+}
+
+void TrackTable::unlink(int index)
+{
+    Entry& entry = m_entries[index];
+    if (entry.prev != -1)
+        m_entries[entry.prev].next = entry.next;
+    else
+        m_head = entry.next;
+
+    if (entry.next != -1)
+        m_entries[entry.next].prev = entry.prev;
+    else
+        m_tail = entry.prev;
+
+    entry.prev = -1;
+    entry.next = -1;
+}
+
+void TrackTable::pushFront(int index)
+{
+    Entry& entry = m_entries[index];
+    entry.prev = -1;
+    entry.next = m_head;
+    if (m_head != -1)
+        m_entries[m_head].prev = index;
+    m_head = index;
+    if (m_tail == -1)
+        m_tail = index;
+}
+
+void TrackTable::remove(int index)
+{
+    unlink(index);
+    m_indexByKey.erase(m_entries[index].key);
+    m_freeIndices.push_back(index);
+}
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,105 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nx/sdk/uuid.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/**
+ * Maps the trackId values of the publisher to VMS track UUIDs.
+ *
+ * The UUID is derived from (camera id, trackId, track epoch), so a track keeps its UUID when its
+ * entry is evicted and recreated, and across plugin restarts. The table only caches the derived
+ * UUIDs: it holds at most `capacity` entries, evicts the least recently seen one when full, and
+ * forgets tracks idle for longer than the TTL. All operations are O(1), except removeExpired(),
+ * which is O(1) per removed entry.
+ *
+ * Publishers reuse trackIds after a restart; those which send a track epoch change it then, see
+ * trackEpoch() for the others.
+ *
+ * Not thread-safe.
+ */
+class TrackTable
+{
+public:
+    TrackTable(std::string cameraId, int capacity, int64_t ttlUs);
+
+    /**
+     * Epoch to identify the tracks of a detection batch by, along with their trackIds: the
+     * published one if it is not 0. A publisher sending no epoch is taken for restarted, with its
+     * trackIds reused, when there has been no batch for longer than the TTL; the epoch returned
+     * for it is then decreased, so that it never clashes with the published ones. The result
+     * depends on the batches only, so the UUIDs do not change when the entries are evicted.
+     * @param batchTimestampUs Timestamp of the detections of the batch.
+     */
+    int64_t trackEpoch(int64_t publishedEpoch, int64_t batchTimestampUs);
+
+    /** @param nowUs Timestamp of the frame the track is seen on. */
+    nx::sdk::Uuid trackUuid(int trackId, int64_t trackEpoch, int64_t nowUs);
+
+    /** Forget the tracks which have not been seen since `nowUs - ttlUs`. */
+    void removeExpired(int64_t nowUs);
+
+    size_t size() const { return m_indexByKey.size(); }
+
+    /** Same value as trackUuid() returns, without touching the table. */
+    static nx::sdk::Uuid deriveUuid(const std::string& cameraId, int trackId, int64_t trackEpoch);
+
+private:
+    struct Key
+    {
+        int trackId = 0;
+        int64_t trackEpoch = 0;
+
+        bool operator==(const Key& other) const
+        {
+            return trackId == other.trackId && trackEpoch == other.trackEpoch;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const;
+    };
+
+    /** Node of the intrusive list of used entries, ordered from the most recently seen. */
+    struct Entry
+    {
+        Key key;
+        nx::sdk::Uuid uuid;
+        int64_t lastSeenUs = 0;
+        int prev = -1;
+        int next = -1;
+    };
+
+    void unlink(int index);
+    void pushFront(int index);
+    void remove(int index);
+
+private:
+    const std::string m_cameraId;
+    const int64_t m_ttlUs;
+    std::vector<Entry> m_entries;
+    std::vector<int> m_freeIndices;
+    std::unordered_map<Key, int, KeyHash> m_indexByKey;
+    int m_head = -1; //< Most recently seen.
+    int m_tail = -1; //< Least recently seen.
+    int64_t m_lastBatchTimestampUs = -1;
+    int64_t m_unpublishedEpoch = 0; //< Decreased at every restart of a publisher with no epoch.
+};
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,269 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "zone_monitor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/** Smaller moves of a track, e.g. detector jitter, are accumulated before the zones are tested. */
+static constexpr float kMinMove = 0.002F;
+
+static bool hasBit(uint32_t mask, int index) { return (mask & (1U << index)) != 0; }
+
+ZoneMonitor::ZoneMonitor(int maxTrackCount, int64_t releaseDelayUs):
+    m_maxTrackCount((size_t) std::max(maxTrackCount, 1)),
+    m_releaseDelayUs(releaseDelayUs)
+{
+    m_tracks.reserve(m_maxTrackCount);
+    m_nextTracks.reserve(m_maxTrackCount);
+    m_batchPositions.reserve(m_maxTrackCount);
+}
+
+void ZoneMonitor::setZones(std::shared_ptr<const GeometrySet> geometry, std::vector<Zone> zones)
+{
+    finishAll(m_lastTimestampUs);
+
+    m_geometry = std::move(geometry);
+    m_zones.clear();
+    for (const Zone& zone: zones)
+    {
+        if ((int) m_zones.size() == kMaxZoneCount)
+            break;
+
+        ZoneState state;
+        state.zone = zone;
+        state.name = zone.figure->label.empty() ? zone.figure->name : zone.figure->label;
+        m_zones.push_back(std::move(state));
+    }
+}
+
+ZoneMonitor::Event& ZoneMonitor::addEvent(
+    EventKind kind, bool isActive, int64_t timestampUs, const ZoneState& zone)
+{
+    m_events.emplace_back();
+    Event& event = m_events.back();
+    event.kind = kind;
+    event.isActive = isActive;
+    event.timestampUs = timestampUs;
+    event.zoneId = zone.zone.figure->name;
+    event.zoneName = zone.name;
+    event.objectCount = zone.objectCount;
+    return event;
+}
+
+void ZoneMonitor::leaveZone(TrackState* track, int zoneIndex, int64_t timestampUs)
+{
+    ZoneState& zone = m_zones[zoneIndex];
+    track->memberMask &= ~(1U << zoneIndex);
+    --zone.objectCount;
+
+    if (hasBit(track->dwellEventMask, zoneIndex))
+    {
+        track->dwellEventMask &= ~(1U << zoneIndex);
+        Event& event = addEvent(EventKind::dwell, /*isActive*/ false, timestampUs, zone);
+        event.trackId = track->trackId;
+        event.trackEpoch = m_trackEpoch;
+        event.dwellUs = timestampUs - track->enteredUs[zoneIndex];
+    }
+}
+
+void ZoneMonitor::leaveAllZones(TrackState* track, int64_t timestampUs)
+{
+    for (int i = 0; i < (int) m_zones.size(); ++i)
+    {
+        if (hasBit(track->memberMask, i))
+            leaveZone(track, i, timestampUs);
+    }
+}
+
+void ZoneMonitor::finishAll(int64_t timestampUs)
+{
+    for (TrackState& track: m_tracks)
+        leaveAllZones(&track, timestampUs);
+    m_tracks.clear();
+
+    for (ZoneState& zone: m_zones)
+    {
+        zone.objectCount = 0;
+        if (zone.isOccupancyActive)
+        {
+            zone.isOccupancyActive = false;
+            addEvent(EventKind::occupancy, /*isActive*/ false, timestampUs, zone);
+        }
+    }
+}
+
+void ZoneMonitor::collectPositions(const DetectionBatch& detections)
+{
+    m_batchPositions.clear();
+    for (size_t i = 0; i < detections.size() && m_batchPositions.size() < m_maxTrackCount; ++i)
+    {
+        const DetectedObject& object = detections[i];
+        BatchPosition position;
+        position.trackId = object.trackId;
+        position.point = {object.x + object.width / 2, object.y + object.height};
+        m_batchPositions.push_back(position);
+    }
+
+    std::sort(m_batchPositions.begin(), m_batchPositions.end(),
+        [](const BatchPosition& a, const BatchPosition& b) { return a.trackId < b.trackId; });
+
+    // Detections sharing a trackId cannot be told apart; count them as a single object.
+    m_batchPositions.erase(
+        std::unique(m_batchPositions.begin(), m_batchPositions.end(),
+            [](const BatchPosition& a, const BatchPosition& b) { return a.trackId == b.trackId; }),
+        m_batchPositions.end());
+}
+
+void ZoneMonitor::moveTrack(TrackState* track, GeometryPoint point, int64_t timestampUs)
+{
+    if (!track->isTested
+        || std::abs(point.x - track->point.x) >= kMinMove
+        || std::abs(point.y - track->point.y) >= kMinMove)
+    {
+        track->point = point;
+        track->isTested = true;
+        track->insideMask = 0;
+        for (int i = 0; i < (int) m_zones.size(); ++i)
+        {
+            if (m_geometry->contains(*m_zones[i].zone.figure, point))
+                track->insideMask |= 1U << i;
+        }
+    }
+
+    for (int i = 0; i < (int) m_zones.size(); ++i)
+    {
+        if (!hasBit(track->insideMask, i))
+            continue;
+
+        track->lastInsideUs[i] = timestampUs;
+        if (!hasBit(track->memberMask, i))
+        {
+            track->memberMask |= 1U << i;
+            track->enteredUs[i] = timestampUs;
+            ++m_zones[i].objectCount;
+        }
+    }
+}
+
+void ZoneMonitor::tick(TrackState* track, int64_t timestampUs)
+{
+    for (int i = 0; i < (int) m_zones.size() && track->memberMask >> i != 0; ++i)
+    {
+        if (!hasBit(track->memberMask, i))
+            continue;
+
+        if (timestampUs - track->lastInsideUs[i] >= m_releaseDelayUs)
+        {
+            leaveZone(track, i, timestampUs);
+            continue;
+        }
+
+        const ZoneState& zone = m_zones[i];
+        if (zone.zone.maxDwellUs > 0
+            && !hasBit(track->dwellEventMask, i)
+            && timestampUs - track->enteredUs[i] >= zone.zone.maxDwellUs)
+        {
+            track->dwellEventMask |= 1U << i;
+            Event& event = addEvent(EventKind::dwell, /*isActive*/ true, timestampUs, zone);
+            event.trackId = track->trackId;
+            event.trackEpoch = m_trackEpoch;
+            event.dwellUs = timestampUs - track->enteredUs[i];
+        }
+    }
+}
+
+void ZoneMonitor::updateOccupancy(int64_t timestampUs)
+{
+    for (ZoneState& zone: m_zones)
+    {
+        if (zone.zone.maxObjectCount <= 0)
+            continue;
+
+        const bool isOccupied = zone.objectCount >= zone.zone.maxObjectCount;
+        if (isOccupied != zone.isOccupancyActive)
+        {
+            zone.isOccupancyActive = isOccupied;
+            addEvent(EventKind::occupancy, isOccupied, timestampUs, zone);
+        }
+    }
+}
+
+void ZoneMonitor::update(const DetectionBatch& detections, int64_t timestampUs)
+{
+    // Tracks from before a restart of the detector or a jump back in time are gone.
+    if (detections.trackEpoch() != m_trackEpoch || timestampUs < m_lastBatchTimestampUs)
+        finishAll(timestampUs);
+    m_trackEpoch = detections.trackEpoch();
+    m_lastBatchTimestampUs = timestampUs;
+    m_lastTimestampUs = std::max(m_lastTimestampUs, timestampUs);
+    if (m_zones.empty())
+        return;
+
+    collectPositions(detections);
+
+    // Merge the batch into the tracks, both sorted by trackId. The tracks of the batch always
+    // fit; the ones missing from it are kept while they are in some zone and there is room.
+    size_t missingTrackRoom = m_maxTrackCount - m_batchPositions.size();
+    const auto keepMissingTrack =
+        [&](TrackState* track)
+        {
+            tick(track, timestampUs);
+            if (track->memberMask == 0)
+                return;
+            if (missingTrackRoom == 0)
+            {
+                leaveAllZones(track, timestampUs);
+                return;
+            }
+            m_nextTracks.push_back(*track);
+            --missingTrackRoom;
+        };
+
+    m_nextTracks.clear();
+    auto track = m_tracks.begin();
+    for (const BatchPosition& position: m_batchPositions)
+    {
+        for (; track != m_tracks.end() && track->trackId < position.trackId; ++track)
+            keepMissingTrack(&*track);
+
+        TrackState movedTrack;
+        if (track != m_tracks.end() && track->trackId == position.trackId)
+            movedTrack = *track++;
+        else
+            movedTrack.trackId = position.trackId;
+
+        moveTrack(&movedTrack, position.point, timestampUs);
+        tick(&movedTrack, timestampUs);
+        m_nextTracks.push_back(movedTrack);
+    }
+    for (; track != m_tracks.end(); ++track)
+        keepMissingTrack(&*track);
+
+    m_tracks.swap(m_nextTracks);
+    updateOccupancy(timestampUs);
+}
+
+void ZoneMonitor::advance(int64_t timestampUs)
+{
+    if (m_zones.empty())
+        return;
+
+    m_lastTimestampUs = std::max(m_lastTimestampUs, timestampUs);
+    for (TrackState& track: m_tracks)
+        tick(&track, timestampUs);
+    updateOccupancy(timestampUs);
+}
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
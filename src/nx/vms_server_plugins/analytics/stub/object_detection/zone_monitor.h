@@ -0,0 +1,145 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../geometry_set.h"
+#include "detection_batch.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_detection {
+
+/**
+ * Counts the tracks in the zones drawn in the DeviceAgent settings and times how long each of
+ * them stays there, producing the start and finish of the prolonged events raised when a zone
+ * holds too many objects (occupancy) or an object stays in a zone for too long (dwell).
+ *
+ * A track is in a zone from the batch in which the bottom center of its box is first inside the
+ * zone until it has been outside the zone, or undetected, for `releaseDelayUs`. This hysteresis
+ * keeps the counts, and thus the events, from flickering with the detections near the zone
+ * borders or missed for a few frames.
+ *
+ * The work is incremental: the zones are hit-tested only for the tracks which have moved since
+ * their last test, and the counts are changed only by the tracks entering or leaving the zones.
+ * Tracks are kept in a vector sorted by trackId, at most `maxTrackCount` of them, and merged with
+ * each batch; updates do not allocate, except for the event list growing.
+ *
+ * Not thread-safe.
+ */
+class ZoneMonitor
+{
+public:
+    static constexpr int kMaxZoneCount = 8;
+
+    struct Zone
+    {
+        const GeometrySet::Figure* figure = nullptr; //< Polygon or box.
+        int maxObjectCount = 0; //< Occupancy event threshold; 0 for no occupancy events.
+        int64_t maxDwellUs = 0; //< Dwell event threshold; 0 for no dwell events.
+    };
+
+    enum class EventKind
+    {
+        occupancy,
+        dwell,
+    };
+
+    /** Start (isActive) or finish of a prolonged event. */
+    struct Event
+    {
+        EventKind kind = EventKind::occupancy;
+        bool isActive = false;
+        int64_t timestampUs = 0;
+        std::string zoneId; //< Setting name of the zone figure.
+        std::string zoneName; //< Label of the zone figure, or its setting name if it has none.
+        int objectCount = 0; //< Occupancy: objects in the zone.
+        int trackId = 0; //< Dwell only.
+        int64_t trackEpoch = 0; //< Dwell only.
+        int64_t dwellUs = 0; //< Dwell: time in the zone so far.
+    };
+
+    ZoneMonitor(int maxTrackCount, int64_t releaseDelayUs);
+
+    /**
+     * Replaces the zones, at most kMaxZoneCount of them, finishing the active events of the
+     * previous ones and forgetting all tracks.
+     * @param geometry Set the zone figures belong to; kept for as long as the zones are used.
+     */
+    void setZones(std::shared_ptr<const GeometrySet> geometry, std::vector<Zone> zones);
+
+    bool isEmpty() const { return m_zones.empty(); }
+
+    /** Moves the tracks to their positions in the batch. */
+    void update(const DetectionBatch& detections, int64_t timestampUs);
+
+    /** Lets the time pass without new detections, e.g. on a video frame between batches. */
+    void advance(int64_t timestampUs);
+
+    /** Produced since the last clearEvents(), in order. */
+    const std::vector<Event>& events() const { return m_events; }
+    void clearEvents() { m_events.clear(); }
+
+private:
+    struct ZoneState
+    {
+        Zone zone;
+        std::string name;
+        int objectCount = 0;
+        bool isOccupancyActive = false;
+    };
+
+    struct TrackState
+    {
+        int trackId = 0;
+        GeometryPoint point; //< Where the zones were last hit-tested.
+        bool isTested = false; //< Whether the zones have been hit-tested at all.
+        uint32_t insideMask = 0; //< Zones containing the point.
+        uint32_t memberMask = 0; //< Zones the track is in, counting the release delay.
+        uint32_t dwellEventMask = 0; //< Zones with an active dwell event of the track.
+        int64_t enteredUs[kMaxZoneCount] = {};
+        int64_t lastInsideUs[kMaxZoneCount] = {};
+    };
+
+    struct BatchPosition
+    {
+        int trackId = 0;
+        GeometryPoint point;
+    };
+
+    void collectPositions(const DetectionBatch& detections);
+    void moveTrack(TrackState* track, GeometryPoint point, int64_t timestampUs);
+    void tick(TrackState* track, int64_t timestampUs);
+    void leaveZone(TrackState* track, int zoneIndex, int64_t timestampUs);
+    void leaveAllZones(TrackState* track, int64_t timestampUs);
+    void updateOccupancy(int64_t timestampUs);
+    void finishAll(int64_t timestampUs);
+    Event& addEvent(EventKind kind, bool isActive, int64_t timestampUs, const ZoneState& zone);
+
+private:
+    const size_t m_maxTrackCount;
+    const int64_t m_releaseDelayUs;
+
+    std::shared_ptr<const GeometrySet> m_geometry;
+    std::vector<ZoneState> m_zones;
+
+    int64_t m_trackEpoch = 0;
+    int64_t m_lastBatchTimestampUs = INT64_MIN;
+    int64_t m_lastTimestampUs = INT64_MIN;
+    std::vector<TrackState> m_tracks; //< Sorted by trackId.
+    std::vector<TrackState> m_nextTracks; //< Reused by update().
+    std::vector<BatchPosition> m_batchPositions; //< Reused by update().
+    std::vector<Event> m_events;
+};
+
+} // namespace object_detection
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
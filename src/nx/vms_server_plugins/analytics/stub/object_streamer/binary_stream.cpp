@@ -0,0 +1,561 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "binary_stream.h"
+
+#include <array>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <nx/kit/debug.h>
+#include <nx/sdk/helpers/uuid_helper.h>
+
+#include "../utils.h"
+#include "constants.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_streamer {
+
+using namespace nx::sdk;
+
+static constexpr char kMagic[] = {'N', 'X', 'O', 'S'};
+static constexpr size_t kHeaderSize = 104;
+static constexpr size_t kFrameEntrySize = 8;
+static constexpr size_t kObjectRecordSize = 56;
+static constexpr size_t kAttributeSetEntrySize = 8;
+static constexpr size_t kAttributeEntrySize = 8;
+static constexpr size_t kStringEntrySize = 8;
+static constexpr uint32_t kNoString = 0xFFFFFFFF;
+static constexpr uint8_t kBestShotEntryTypeCode = 1;
+static constexpr uint8_t kTrackIdIsRefFlag = 0x01;
+
+static uint32_t readUint32(const uint8_t* p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16)
+        | ((uint32_t) p[3] << 24);
+}
+
+static uint64_t readUint64(const uint8_t* p)
+{
+    return (uint64_t) readUint32(p) | ((uint64_t) readUint32(p + 4) << 32);
+}
+
+static float readFloat(const uint8_t* p)
+{
+    const uint32_t bits = readUint32(p);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void appendUint32(std::string* out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        out->push_back((char) (value >> (8 * i)));
+}
+
+static void appendUint64(std::string* out, uint64_t value)
+{
+    appendUint32(out, (uint32_t) value);
+    appendUint32(out, (uint32_t) (value >> 32));
+}
+
+static void appendFloat(std::string* out, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    appendUint32(out, bits);
+}
+
+static void alignTo8(std::string* out)
+{
+    out->resize((out->size() + 7) / 8 * 8, '\0');
+}
+
+//-------------------------------------------------------------------------------------------------
+// BinaryStream
+
+BinaryStream::~BinaryStream()
+{
+    #if !defined(_WIN32)
+        if (m_mapping)
+            munmap(m_mapping, m_size);
+    #endif
+}
+
+std::unique_ptr<BinaryStream> BinaryStream::open(const std::string& filePath, std::string* outError)
+{
+    #if defined(_WIN32)
+        std::ifstream file(filePath, std::ios::binary);
+        if (!file)
+        {
+            *outError = "Cannot open " + filePath;
+            return nullptr;
+        }
+        return fromBytes(
+            std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()),
+            outError);
+    #else
+        const int fd = ::open(filePath.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            *outError = "Cannot open " + filePath + ": " + strerror(errno);
+            return nullptr;
+        }
+
+        struct stat status;
+        void* mapping = MAP_FAILED;
+        if (fstat(fd, &status) == 0 && (size_t) status.st_size >= kHeaderSize)
+            mapping = mmap(nullptr, (size_t) status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            *outError = "Cannot map " + filePath;
+            return nullptr;
+        }
+
+        std::unique_ptr<BinaryStream> stream(new BinaryStream());
+        stream->m_mapping = mapping;
+        stream->m_data = (const uint8_t*) mapping;
+        stream->m_size = (size_t) status.st_size;
+        if (!stream->parseHeader(outError))
+            return nullptr;
+
+        // Frames are read in order, and the same part of the file is read again in every cycle.
+        madvise(mapping, stream->m_size, MADV_SEQUENTIAL);
+        return stream;
+    #endif
+}
+
+std::unique_ptr<BinaryStream> BinaryStream::fromBytes(std::string bytes, std::string* outError)
+{
+    std::unique_ptr<BinaryStream> stream(new BinaryStream());
+    stream->m_bytes = std::move(bytes);
+    stream->m_data = (const uint8_t*) stream->m_bytes.data();
+    stream->m_size = stream->m_bytes.size();
+    if (!stream->parseHeader(outError))
+        return nullptr;
+    return stream;
+}
+
+bool BinaryStream::isBinaryStreamFile(const std::string& filePath)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    char magic[sizeof(kMagic)] = {};
+    return file.read(magic, sizeof(magic)) && memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool BinaryStream::parseHeader(std::string* outError)
+{
+    const uint8_t* const header = m_data;
+    if (m_size < kHeaderSize || memcmp(header, kMagic, sizeof(kMagic)) != 0)
+    {
+        *outError = "Not a binary Object stream";
+        return false;
+    }
+
+    const uint32_t version = readUint32(header + 4);
+    if (version != kVersion)
+    {
+        *outError = "Unsupported binary Object stream version " + std::to_string(version);
+        return false;
+    }
+
+    m_stringCount = readUint32(header + 16);
+    m_objectTypeCount = readUint32(header + 20);
+    m_stringsOffset = readUint64(header + 24);
+    m_attributeSetCount = readUint32(header + 32);
+    m_attributeCount = readUint32(header + 36);
+    m_attributeSetsOffset = readUint64(header + 40);
+    m_frameCount = readUint32(header + 48);
+    m_objectCount = readUint32(header + 52);
+    m_framesOffset = readUint64(header + 56);
+    m_objectsOffset = readUint64(header + 64);
+    m_trackSlotCount = readUint32(header + 72);
+    m_source.fileStatus.size = (int64_t) readUint64(header + 80);
+    m_source.fileStatus.modificationTimeNs = (int64_t) readUint64(header + 88);
+    m_source.contentHash = readUint64(header + 96);
+
+    // Only the section bounds are checked, so that opening takes constant time.
+    const auto fits =
+        [this](uint64_t offset, uint64_t size)
+        {
+            return offset <= m_size && size <= m_size - offset;
+        };
+    const bool isValid = readUint64(header + 8) == m_size
+        && m_objectTypeCount <= m_stringCount
+        && m_trackSlotCount <= (uint32_t) INT_MAX
+        && m_frameCount <= (uint32_t) INT_MAX
+        && fits(m_stringsOffset, (uint64_t) m_stringCount * kStringEntrySize)
+        && fits(m_attributeSetsOffset, (uint64_t) m_attributeSetCount * kAttributeSetEntrySize
+            + (uint64_t) m_attributeCount * kAttributeEntrySize)
+        && fits(m_framesOffset, (uint64_t) m_frameCount * kFrameEntrySize)
+        && fits(m_objectsOffset, (uint64_t) m_objectCount * kObjectRecordSize);
+    if (!isValid)
+    {
+        *outError = "Binary Object stream is truncated or corrupted";
+        return false;
+    }
+    return true;
+}
+
+std::string_view BinaryStream::string(uint32_t index) const
+{
+    if (index >= m_stringCount)
+        return {};
+
+    const uint8_t* const entry = m_data + m_stringsOffset + (size_t) index * kStringEntrySize;
+    const uint64_t blobOffset = m_stringsOffset + (uint64_t) m_stringCount * kStringEntrySize;
+    const uint64_t offset = blobOffset + readUint32(entry);
+    const uint32_t size = readUint32(entry + 4);
+    if (offset > m_size || size > m_size - offset)
+        return {};
+    return std::string_view((const char*) m_data + offset, size);
+}
+
+std::string_view BinaryStream::objectTypeId(uint32_t index) const
+{
+    return index < m_objectTypeCount ? string(index) : std::string_view();
+}
+
+std::set<std::string> BinaryStream::objectTypeIds() const
+{
+    std::set<std::string> result;
+    for (uint32_t i = 0; i < m_objectTypeCount; ++i)
+        result.emplace(string(i));
+    return result;
+}
+
+bool BinaryStream::findFrame(
+    int frameNumber, uint32_t* outFirstObject, uint32_t* outObjectCount) const
+{
+    if (frameNumber < 0 || (uint32_t) frameNumber >= m_frameCount)
+        return false;
+
+    const uint8_t* const frame = m_data + m_framesOffset + (size_t) frameNumber * kFrameEntrySize;
+    const uint32_t firstObject = readUint32(frame);
+    const uint32_t objectCount = readUint32(frame + 4);
+    if (firstObject > m_objectCount || objectCount > m_objectCount - firstObject)
+        return false;
+
+    *outFirstObject = firstObject;
+    *outObjectCount = objectCount;
+    return objectCount > 0;
+}
+
+bool BinaryStream::readObject(uint32_t index, StreamObject* outObject) const
+{
+    if (index >= m_objectCount)
+        return false;
+
+    const uint8_t* const record = m_data + m_objectsOffset + (size_t) index * kObjectRecordSize;
+    outObject->index = index;
+    outObject->typeIdIndex = readUint32(record);
+    outObject->typeId = string(outObject->typeIdIndex);
+    if (outObject->typeId.empty())
+        return false;
+
+    outObject->entryType = record[4] == kBestShotEntryTypeCode
+        ? Object::EntryType::bestShot
+        : Object::EntryType::regular;
+
+    if (record[5] & kTrackIdIsRefFlag)
+    {
+        outObject->trackId = Uuid();
+        outObject->trackSlot = (int) readUint32(record + 8);
+        outObject->trackIdRef = string(readUint32(record + 12));
+        if ((uint32_t) outObject->trackSlot >= m_trackSlotCount || outObject->trackIdRef.empty())
+            return false;
+    }
+    else
+    {
+        std::array<uint8_t, Uuid::kSize> trackId;
+        memcpy(trackId.data(), record + 8, trackId.size());
+        outObject->trackId = Uuid(trackId);
+        outObject->trackIdRef = {};
+        outObject->trackSlot = -1;
+    }
+
+    outObject->boundingBox.x = readFloat(record + 24);
+    outObject->boundingBox.y = readFloat(record + 28);
+    outObject->boundingBox.width = readFloat(record + 32);
+    outObject->boundingBox.height = readFloat(record + 36);
+    outObject->timestampUs = (int64_t) readUint64(record + 40);
+
+    outObject->attributeSetIndex = readUint32(record + 48);
+    if (outObject->attributeSetIndex >= m_attributeSetCount)
+        return false;
+    const uint8_t* const attributeSet = m_data + m_attributeSetsOffset
+        + (size_t) outObject->attributeSetIndex * kAttributeSetEntrySize;
+    outObject->firstAttribute = readUint32(attributeSet);
+    outObject->attributeCount = readUint32(attributeSet + 4);
+    if (outObject->firstAttribute > m_attributeCount
+        || outObject->attributeCount > m_attributeCount - outObject->firstAttribute)
+    {
+        return false;
+    }
+
+    const uint32_t imageSourceIndex = readUint32(record + 52);
+    outObject->imageSource =
+        imageSourceIndex == kNoString ? std::string_view() : string(imageSourceIndex);
+    return true;
+}
+
+std::pair<std::string_view, std::string_view> BinaryStream::attribute(uint32_t index) const
+{
+    if (index >= m_attributeCount)
+        return {};
+
+    const uint8_t* const entry = m_data + m_attributeSetsOffset
+        + (size_t) m_attributeSetCount * kAttributeSetEntrySize
+        + (size_t) index * kAttributeEntrySize;
+    return {string(readUint32(entry)), string(readUint32(entry + 4))};
+}
+
+//-------------------------------------------------------------------------------------------------
+// Conversion from JSON
+
+std::string encodeBinaryStream(const StreamInfo& streamInfo, const StreamSource& source)
+{
+    std::vector<std::string> strings;
+    std::map<std::string, uint32_t> stringIndices;
+    const auto intern =
+        [&](const std::string& value)
+        {
+            const auto result = stringIndices.emplace(value, (uint32_t) strings.size());
+            if (result.second)
+                strings.push_back(value);
+            return result.first->second;
+        };
+
+    // The object type ids go first, so that they can be listed without reading the objects.
+    for (const std::string& objectTypeId: streamInfo.objectTypeIds)
+        intern(objectTypeId);
+    const uint32_t objectTypeCount = (uint32_t) strings.size();
+
+    using AttributeSet = std::vector<std::pair<uint32_t, uint32_t>>;
+    std::map<AttributeSet, uint32_t> attributeSetIndices{{AttributeSet(), 0}};
+    std::string attributeSets;
+    std::string attributes;
+    appendUint32(&attributeSets, 0);
+    appendUint32(&attributeSets, 0);
+    uint32_t attributeCount = 0;
+
+    std::map<std::string, uint32_t> trackSlots;
+    std::string frames;
+    std::string objects;
+    uint32_t objectCount = 0;
+    int frameCount = 0;
+    for (const auto& [frameNumber, frameObjects]: streamInfo.objectsByFrameNumber)
+    {
+        if (frameNumber < 0 || frameObjects.empty())
+            continue;
+
+        for (; frameCount <= frameNumber; ++frameCount)
+        {
+            appendUint32(&frames, objectCount);
+            appendUint32(&frames, frameCount == frameNumber ? (uint32_t) frameObjects.size() : 0);
+        }
+
+        for (const Object& object: frameObjects)
+        {
+            AttributeSet attributeSet;
+            for (const auto& [name, value]: object.attributes)
+                attributeSet.emplace_back(intern(name), intern(value));
+            const auto setResult =
+                attributeSetIndices.emplace(attributeSet, (uint32_t) attributeSetIndices.size());
+            if (setResult.second)
+            {
+                appendUint32(&attributeSets, attributeCount);
+                appendUint32(&attributeSets, (uint32_t) attributeSet.size());
+                for (const auto& [name, value]: attributeSet)
+                {
+                    appendUint32(&attributes, name);
+                    appendUint32(&attributes, value);
+                }
+                attributeCount += (uint32_t) attributeSet.size();
+            }
+
+            appendUint32(&objects, intern(object.typeId));
+            objects.push_back(object.entryType == Object::EntryType::bestShot
+                ? (char) kBestShotEntryTypeCode
+                : '\0');
+            objects.push_back(object.trackIdRef.empty() ? '\0' : (char) kTrackIdIsRefFlag);
+            objects.append(2, '\0');
+            if (object.trackIdRef.empty())
+            {
+                objects.append((const char*) object.trackId.data(), Uuid::kSize);
+            }
+            else
+            {
+                const auto slot =
+                    trackSlots.emplace(object.trackIdRef, (uint32_t) trackSlots.size()).first;
+                appendUint32(&objects, slot->second);
+                appendUint32(&objects, intern(object.trackIdRef));
+                objects.append(Uuid::kSize - 8, '\0');
+            }
+            appendFloat(&objects, object.boundingBox.x);
+            appendFloat(&objects, object.boundingBox.y);
+            appendFloat(&objects, object.boundingBox.width);
+            appendFloat(&objects, object.boundingBox.height);
+            appendUint64(&objects, (uint64_t) object.timestampUs);
+            appendUint32(&objects, setResult.first->second);
+            appendUint32(&objects,
+                object.imageSource.empty() ? kNoString : intern(object.imageSource));
+            ++objectCount;
+        }
+    }
+
+    std::string stringEntries;
+    std::string stringBlob;
+    for (const std::string& value: strings)
+    {
+        appendUint32(&stringEntries, (uint32_t) stringBlob.size());
+        appendUint32(&stringEntries, (uint32_t) value.size());
+        stringBlob += value;
+    }
+
+    std::string result(kHeaderSize, '\0');
+    const uint64_t framesOffset = result.size();
+    result += frames;
+    alignTo8(&result);
+    const uint64_t objectsOffset = result.size();
+    result += objects;
+    alignTo8(&result);
+    const uint64_t attributeSetsOffset = result.size();
+    result += attributeSets;
+    result += attributes;
+    alignTo8(&result);
+    const uint64_t stringsOffset = result.size();
+    result += stringEntries;
+    result += stringBlob;
+    alignTo8(&result);
+
+    std::string header(kMagic, sizeof(kMagic));
+    appendUint32(&header, BinaryStream::kVersion);
+    appendUint64(&header, result.size());
+    appendUint32(&header, (uint32_t) strings.size());
+    appendUint32(&header, objectTypeCount);
+    appendUint64(&header, stringsOffset);
+    appendUint32(&header, (uint32_t) attributeSetIndices.size());
+    appendUint32(&header, attributeCount);
+    appendUint64(&header, attributeSetsOffset);
+    appendUint32(&header, (uint32_t) frameCount);
+    appendUint32(&header, objectCount);
+    appendUint64(&header, framesOffset);
+    appendUint64(&header, objectsOffset);
+    appendUint32(&header, (uint32_t) trackSlots.size());
+    appendUint32(&header, 0);
+    appendUint64(&header, (uint64_t) source.fileStatus.size);
+    appendUint64(&header, (uint64_t) source.fileStatus.modificationTimeNs);
+    appendUint64(&header, source.contentHash);
+    result.replace(0, header.size(), header);
+    return result;
+}
+
+/**
+ * Writes to a temporary file of a unique name in the same directory, and renames it, so that
+ * concurrent writers, e.g. several Engines or Server processes converting the same stream, never
+ * write into the same file, and readers see either the old or a complete new file.
+ */
+static bool writeFileAtomically(const std::string& filePath, const std::string& contents)
+{
+    const std::string temporaryFilePath = filePath + ".tmp."
+        + nx::sdk::UuidHelper::toStdString(nx::sdk::UuidHelper::randomUuid());
+    {
+        std::ofstream file(temporaryFilePath, std::ios::binary | std::ios::trunc);
+        if (!file || !file.write(contents.data(), (std::streamsize) contents.size()))
+        {
+            file.close();
+            std::remove(temporaryFilePath.c_str());
+            return false;
+        }
+    }
+
+    #if defined(_WIN32)
+        std::remove(filePath.c_str()); //< Windows does not replace an existing file on rename.
+    #endif
+    if (std::rename(temporaryFilePath.c_str(), filePath.c_str()) != 0)
+    {
+        std::remove(temporaryFilePath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool convertObjectStreamFile(
+    const std::string& jsonFilePath, const std::string& binaryFilePath, Issues* issues)
+{
+    // Taken before parsing, so that if the file is modified meanwhile, the result does not match
+    // the new version.
+    const StreamSource source{fileStatus(jsonFilePath), fileContentHash(jsonFilePath)};
+    const StreamInfo streamInfo = parseObjectStreamFile(jsonFilePath, issues);
+    if (!issues->errors.empty())
+        return false;
+
+    if (!writeFileAtomically(binaryFilePath, encodeBinaryStream(streamInfo, source)))
+    {
+        NX_PRINT << "Failed to write the binary Object stream: " << binaryFilePath;
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<BinaryStream> loadObjectStream(
+    const std::string& filePath, const StreamSource& source, Issues* issues)
+{
+    std::string error;
+    if (BinaryStream::isBinaryStreamFile(filePath))
+    {
+        std::unique_ptr<BinaryStream> stream = BinaryStream::open(filePath, &error);
+        if (!stream)
+        {
+            issues->errors.insert(Issue::binaryObjectStreamIsInvalid);
+            NX_PRINT << "Issue (error): " << issueToString(Issue::binaryObjectStreamIsInvalid)
+                << ". Context: " << error;
+        }
+        return stream;
+    }
+
+    // A modification time alone is not trusted: it can go backwards, e.g. when the file is
+    // restored from a backup or copied with the times preserved.
+    const std::string binaryFilePath = filePath + kBinaryStreamFileSuffix;
+    if (fileStatus(binaryFilePath).size >= 0)
+    {
+        std::unique_ptr<BinaryStream> stream = BinaryStream::open(binaryFilePath, &error);
+        if (stream && stream->source() == source)
+            return stream;
+        NX_PRINT << "Converting the Object stream again: "
+            << (stream ? "it has been converted from another version of the file" : error);
+    }
+
+    // Streams with errors are played as far as they could be parsed, but are not cached, so that
+    // the errors are reported every time they are loaded.
+    const StreamInfo streamInfo = parseObjectStreamFile(filePath, issues);
+    std::string bytes = encodeBinaryStream(streamInfo, source);
+    if (issues->errors.empty() && writeFileAtomically(binaryFilePath, bytes))
+    {
+        if (std::unique_ptr<BinaryStream> stream = BinaryStream::open(binaryFilePath, &error))
+            return stream;
+    }
+    return BinaryStream::fromBytes(std::move(bytes), &error);
+}
+
+} // namespace object_streamer
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
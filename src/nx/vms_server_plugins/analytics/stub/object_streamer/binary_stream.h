@@ -0,0 +1,190 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <nx/sdk/analytics/rect.h>
+#include <nx/sdk/uuid.h>
+
+#include "../utils.h"
+#include "stream_parser.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_streamer {
+
+/**
+ * Object stream entry decoded from a BinaryStream. The strings point into the stream, so
+ * decoding allocates nothing.
+ */
+struct StreamObject
+{
+    uint32_t index = 0; //< In the stream; identifies the entry across stream cycles.
+    std::string_view typeId;
+    uint32_t typeIdIndex = 0; //< In the dictionary; the same for the same typeId.
+    nx::sdk::Uuid trackId; //< Null if trackIdRef is set.
+    std::string_view trackIdRef;
+    int trackSlot = -1; //< Index of trackIdRef among the distinct ones of the stream, if set.
+    nx::sdk::analytics::Rect boundingBox;
+    int64_t timestampUs = -1;
+    Object::EntryType entryType = Object::EntryType::regular;
+    std::string_view imageSource;
+
+    /** Entries with the same attribute names and values share the set. */
+    uint32_t attributeSetIndex = 0;
+    uint32_t firstAttribute = 0;
+    uint32_t attributeCount = 0;
+};
+
+/**
+ * Identifies the JSON file which a binary stream has been converted from, so that a stream
+ * converted from another version of the file is never taken for its conversion.
+ */
+struct StreamSource
+{
+    FileStatus fileStatus; //< Size is -1 if the stream has not been converted from a file.
+    uint64_t contentHash = 0; //< fileContentHash() of the file.
+
+    bool operator==(const StreamSource& other) const
+    {
+        return fileStatus == other.fileStatus && contentHash == other.contentHash;
+    }
+};
+
+/**
+ * Object stream file in the binary format, which is memory-mapped and decoded lazily, one
+ * frame at a time: opening it takes constant time, and the memory it occupies is made of the
+ * pages of the file which have been read, which the system can drop at any time.
+ *
+ * All integers are little-endian; sections are 8-byte aligned:
+ * - Header, 104 bytes: magic "NXOS", uint32 version (3), uint64 file size; uint32 string count,
+ *     uint32 object type count, uint64 strings offset; uint32 attribute set count, uint32
+ *     attribute count, uint64 attribute sets offset; uint32 frame count, uint32 object count,
+ *     uint64 frames offset, uint64 objects offset; uint32 track slot count, 4 reserved bytes;
+ *     the StreamSource: int64 size and int64 modification time in nanoseconds of the JSON
+ *     file, -1 if none, uint64 content hash of it.
+ * - Frame index, 8 bytes per frame number from 0 to the last one having objects, so that a
+ *     frame is found by its number: uint32 first object index, uint32 object count.
+ * - Objects, 56 bytes each, in the order of the frames: uint32 typeId string index; uint8 entry
+ *     type (0 - regular, 1 - best shot); uint8 flags (bit 0: the trackId is a `$`/`$$` reference,
+ *     and the trackId field holds uint32 track slot and uint32 reference string index instead);
+ *     2 reserved bytes; 16-byte trackId UUID; float x, y, width, height; int64 timestampUs, -1 if
+ *     none; uint32 attribute set index; uint32 imageSource string index, 0xFFFFFFFF if none.
+ * - Attribute sets, 8 bytes each: uint32 first attribute index, uint32 attribute count; set 0
+ *     is empty. The attributes follow the sets, 8 bytes each: uint32 name and value string
+ *     indices.
+ * - Dictionary: per string, uint32 offset and uint32 byte size of its UTF-8 bytes, which follow
+ *     the entries. The first strings are the object type ids of the stream, sorted.
+ *
+ * Every string, e.g. a type id or an attribute name, is stored once, and so is every distinct
+ * attribute set, and every track reference is numbered, so that it can be resolved once per slot
+ * rather than per entry. Entries with negative frame numbers are never played, and are dropped.
+ * The file is produced from the JSON stream format by convertObjectStreamFile().
+ */
+class BinaryStream
+{
+public:
+    static constexpr uint32_t kVersion = 3;
+
+    ~BinaryStream();
+
+    BinaryStream(const BinaryStream&) = delete;
+    BinaryStream& operator=(const BinaryStream&) = delete;
+
+    /**
+     * Maps the file and checks its header; the rest is checked when decoded.
+     * @return Null on failure, with the description in outError.
+     */
+    static std::unique_ptr<BinaryStream> open(const std::string& filePath, std::string* outError);
+
+    /** Same as open(), for a stream held in memory. */
+    static std::unique_ptr<BinaryStream> fromBytes(std::string bytes, std::string* outError);
+
+    /** Tells the binary format from JSON by the magic. */
+    static bool isBinaryStreamFile(const std::string& filePath);
+
+    const StreamSource& source() const { return m_source; }
+
+    /** -1 if the stream has no objects. */
+    int maxFrameNumber() const { return (int) m_frameCount - 1; }
+
+    /** Number of distinct track references, which StreamObject::trackSlot is less than. */
+    int trackSlotCount() const { return (int) m_trackSlotCount; }
+
+    /** Object type ids are the first entries of the dictionary, so they are indexed the same. */
+    uint32_t objectTypeCount() const { return m_objectTypeCount; }
+    std::string_view objectTypeId(uint32_t index) const;
+    std::set<std::string> objectTypeIds() const;
+
+    /** @return False if the frame has no objects. */
+    bool findFrame(int frameNumber, uint32_t* outFirstObject, uint32_t* outObjectCount) const;
+
+    /** @return False if the entry is corrupted; outObject holds garbage then. */
+    bool readObject(uint32_t index, StreamObject* outObject) const;
+
+    /** @return Name and value of the attribute; empty if it is corrupted. */
+    std::pair<std::string_view, std::string_view> attribute(uint32_t index) const;
+
+private:
+    BinaryStream() = default;
+
+    bool parseHeader(std::string* outError);
+    std::string_view string(uint32_t index) const;
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    void* m_mapping = nullptr; //< Null if the stream is held in m_bytes.
+    std::string m_bytes;
+
+    uint32_t m_stringCount = 0;
+    uint32_t m_objectTypeCount = 0;
+    uint64_t m_stringsOffset = 0;
+    uint32_t m_attributeSetCount = 0;
+    uint32_t m_attributeCount = 0;
+    uint64_t m_attributeSetsOffset = 0;
+    uint32_t m_frameCount = 0;
+    uint32_t m_objectCount = 0;
+    uint64_t m_framesOffset = 0;
+    uint64_t m_objectsOffset = 0;
+    uint32_t m_trackSlotCount = 0;
+    StreamSource m_source;
+};
+
+/** Encodes a stream parsed from the JSON format, recording the file it was parsed from. */
+std::string encodeBinaryStream(
+    const StreamInfo& streamInfo, const StreamSource& source = StreamSource());
+
+/**
+ * Converts a JSON stream file to the binary format, e.g. in advance, so that the file written
+ * next to the JSON one is loaded by loadObjectStream() without converting it again.
+ * @return False if the file cannot be parsed or the result cannot be written.
+ */
+bool convertObjectStreamFile(
+    const std::string& jsonFilePath, const std::string& binaryFilePath, Issues* issues);
+
+/**
+ * Opens a stream file of either format. A JSON one is converted to the binary format once, into
+ * a file next to it with kBinaryStreamFileSuffix appended to its name, which is reused while its
+ * StreamSource is exactly that of the JSON file; if it cannot be written, the converted stream
+ * is kept in memory.
+ * @param source Status and content hash of the file, as just read by the caller.
+ * @return Null if the stream cannot be loaded, with the issues reported.
+ */
+std::unique_ptr<BinaryStream> loadObjectStream(
+    const std::string& filePath, const StreamSource& source, Issues* issues);
+
+} // namespace object_streamer
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -29,6 +29,7 @@ const std::string kBestShotEntryType = "bestShot";
 
 const std::string kDefaultManifestFile = "object_streamer/manifest.json";
 const std::string kDefaultStreamFile = "object_streamer/stream.json";
+const std::string kBinaryStreamFileSuffix = ".bin";
 
 const std::string kManifestFileSetting = "manifestFile";
 const std::string kStreamFileSetting = "streamFile";
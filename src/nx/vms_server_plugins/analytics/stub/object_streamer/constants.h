@@ -31,6 +31,7 @@ extern const std::string kBestShotEntryType;
 
 extern const std::string kDefaultManifestFile;
 extern const std::string kDefaultStreamFile;
+extern const std::string kBinaryStreamFileSuffix;
 
 extern const std::string kManifestFileSetting;
 extern const std::string kStreamFileSetting;
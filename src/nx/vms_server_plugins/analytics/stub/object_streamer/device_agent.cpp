@@ -2,6 +2,7 @@
 
 #include "device_agent.h"
 
+#include <algorithm>
 #include <fstream>
 #include <streambuf>
 
@@ -14,6 +15,7 @@
 #include <nx/kit/json.h>
 #include <nx/kit/debug.h>
 
+#include "../asset_cache.h"
 #include "../utils.h"
 #include "utils.h"
 #include "constants.h"
@@ -31,8 +33,17 @@ using Uuid = nx::sdk::Uuid;
 
 using nx::kit::Json;
 
-DeviceAgent::DeviceAgent(const nx::sdk::IDeviceInfo* deviceInfo, std::string pluginHomeDir):
+static uint64_t metadataPoolKey(const StreamObject& object)
+{
+    return ((uint64_t) object.typeIdIndex << 32) | object.attributeSetIndex;
+}
+
+DeviceAgent::DeviceAgent(
+    Engine* engine,
+    const nx::sdk::IDeviceInfo* deviceInfo,
+    std::string pluginHomeDir):
     ConsumingDeviceAgent(deviceInfo, ini().enableOutput),
+    m_engine(engine),
     m_pluginHomeDir(std::move(pluginHomeDir))
 {
 }
@@ -57,10 +68,10 @@ bool DeviceAgent::pushCompressedVideoFrame(const ICompressedVideoPacket* videoPa
         const int64_t previousFrameTimestampUs = m_lastFrameTimestampUs;
         const int64_t previousFrameDurationUs = std::max(videoPacket->timestampUs() - previousFrameTimestampUs, (int64_t) 0);
 
-        for (auto& metadataPacket: generateMetadata(previousFrameNumber, previousFrameTimestampUs, previousFrameDurationUs))
-        {
+        generateMetadata(previousFrameNumber, previousFrameTimestampUs, previousFrameDurationUs,
+            &m_metadataPackets);
+        for (auto& metadataPacket: m_metadataPackets)
             pushMetadataPacket(metadataPacket.releasePtr());
-        }
 
         // On wraparound, remove per-stream-cycle track ids.
         if (m_frameNumber == 0)
@@ -72,6 +83,7 @@ bool DeviceAgent::pushCompressedVideoFrame(const ICompressedVideoPacket* videoPa
                 else
                     ++it;
             }
+            std::fill(m_trackIdBySlot.begin(), m_trackIdBySlot.end(), Uuid());
         }
     }
 
@@ -85,27 +97,48 @@ bool DeviceAgent::pushCompressedVideoFrame(const ICompressedVideoPacket* videoPa
     return true;
 }
 
-std::vector<Ptr<IMetadataPacket>> DeviceAgent::generateMetadata(
-    int frameNumber, int64_t frameTimestampUs, int64_t durationUs)
+void DeviceAgent::generateMetadata(
+    int frameNumber,
+    int64_t frameTimestampUs,
+    int64_t durationUs,
+    std::vector<Ptr<IMetadataPacket>>* outMetadataPackets)
 {
-    std::vector<Ptr<IMetadataPacket>> result;
+    outMetadataPackets->clear();
+
+    uint32_t firstObject = 0;
+    uint32_t objectCount = 0;
+    if (!m_stream || !m_stream->findFrame(frameNumber, &firstObject, &objectCount))
+        return;
 
-    if (m_streamInfo.objectsByFrameNumber.find(frameNumber) == m_streamInfo.objectsByFrameNumber.cend())
-        return result;
+    // Packets released by the Server drop their objects, so that those can be recycled as well.
+    m_packetPool.forEachFree([](ObjectMetadataPacket* packet) { packet->clear(); });
 
-    std::map<int64_t, Ptr<ObjectMetadataPacket>> objectMetadataPacketByTimestamp;
+    // Ordered by timestamp; a frame rarely has more than one distinct timestamp.
+    auto& objectMetadataPacketByTimestamp = m_objectMetadataPacketByTimestamp;
+    objectMetadataPacketByTimestamp.clear();
     std::vector<Ptr<ObjectTrackBestShotPacket>> objectTrackBestShotPackets;
-    for (Object& object: m_streamInfo.objectsByFrameNumber[frameNumber])
+    bool isAllocated = false;
+    StreamObject object;
+    for (uint32_t index = firstObject; index < firstObject + objectCount; ++index)
     {
-        if (m_disabledObjectTypeIds.find(object.typeId) != m_disabledObjectTypeIds.cend())
+        if (!m_stream->readObject(index, &object))
+        {
+            NX_PRINT << "Corrupted entry #" << index << " in the binary Object stream";
             continue;
+        }
+
+        if (object.typeIdIndex < m_isObjectTypeEnabled.size()
+            && !m_isObjectTypeEnabled[object.typeIdIndex])
+        {
+            continue;
+        }
 
         const int64_t timestampUs = object.timestampUs >= 0
             ? object.timestampUs
             : frameTimestampUs;
 
-        if (!object.trackIdRef.empty())
-            object.trackId = obtainObjectTrackIdFromRef(object.trackIdRef);
+        if (object.trackSlot >= 0)
+            object.trackId = obtainObjectTrackId(object);
 
         if (object.entryType == Object::EntryType::bestShot)
         {
@@ -113,20 +146,26 @@ std::vector<Ptr<IMetadataPacket>> DeviceAgent::generateMetadata(
             bestShotPacket->setTimestampUs(timestampUs);
             bestShotPacket->setTrackId(object.trackId);
             bestShotPacket->setBoundingBox(object.boundingBox);
-            for (const auto& item: object.attributes)
-                bestShotPacket->addAttribute(makePtr<Attribute>(item.first, item.second));
+            for (uint32_t i = 0; i < object.attributeCount; ++i)
+            {
+                const auto [name, value] = m_stream->attribute(object.firstAttribute + i);
+                bestShotPacket->addAttribute(
+                    makePtr<Attribute>(std::string(name), std::string(value)));
+            }
 
-            if (isHttpOrHttpsUrl(object.imageSource))
+            const std::string imageSource(object.imageSource);
+            if (isHttpOrHttpsUrl(imageSource))
             {
-                bestShotPacket->setImageUrl(object.imageSource);
+                bestShotPacket->setImageUrl(imageSource);
             }
-            else if (!object.imageSource.empty())
+            else if (!imageSource.empty())
             {
-                std::string imageFormat = imageFormatFromPath(object.imageSource);
+                std::string imageFormat = imageFormatFromPath(imageSource);
                 if (!imageFormat.empty())
                 {
                     bestShotPacket->setImageDataFormat(std::move(imageFormat));
-                    bestShotPacket->setImageData(loadFile(object.imageSource));
+                    if (const auto image = AssetCache::instance().load(imageSource))
+                        bestShotPacket->setImageData(image->toVector());
                 }
             }
 
@@ -134,44 +173,86 @@ std::vector<Ptr<IMetadataPacket>> DeviceAgent::generateMetadata(
         }
         else
         {
-            Ptr<ObjectMetadataPacket>& objectMetadataPacket =
-                objectMetadataPacketByTimestamp[timestampUs];
+            auto packetIt = std::lower_bound(
+                objectMetadataPacketByTimestamp.begin(),
+                objectMetadataPacketByTimestamp.end(),
+                timestampUs,
+                [](const auto& entry, int64_t value) { return entry.first < value; });
 
-            if (!objectMetadataPacket)
+            if (packetIt == objectMetadataPacketByTimestamp.end() || packetIt->first != timestampUs)
             {
-                objectMetadataPacket = makePtr<ObjectMetadataPacket>();
+                bool isNew = false;
+                auto objectMetadataPacket = m_packetPool.acquire(
+                    []() { return makePtr<ObjectMetadataPacket>(); }, &isNew);
+                isAllocated |= isNew;
                 objectMetadataPacket->setTimestampUs(timestampUs);
                 objectMetadataPacket->setDurationUs(durationUs);
+                packetIt = objectMetadataPacketByTimestamp.emplace(
+                    packetIt, timestampUs, std::move(objectMetadataPacket));
             }
 
-            auto objectMetadata = makePtr<ObjectMetadata>();
-            objectMetadata->setTypeId(object.typeId);
+            // Entries of the same type with the same attributes differ only in the track and the
+            // box, so a metadata object created for one of them is reused for any other.
+            bool isNew = false;
+            const auto objectMetadata = m_objectMetadataPoolByKind[metadataPoolKey(object)].acquire(
+                []() { return makePtr<ObjectMetadata>(); }, &isNew);
+            if (isNew)
+            {
+                isAllocated = true;
+                objectMetadata->setTypeId(std::string(object.typeId));
+                for (uint32_t i = 0; i < object.attributeCount; ++i)
+                {
+                    const auto [name, value] = m_stream->attribute(object.firstAttribute + i);
+                    objectMetadata->addAttribute(
+                        makePtr<Attribute>(std::string(name), std::string(value)));
+                }
+            }
             objectMetadata->setTrackId(object.trackId);
             objectMetadata->setBoundingBox(object.boundingBox);
 
-            for (const auto& item: object.attributes)
-                objectMetadata->addAttribute(makePtr<Attribute>(item.first, item.second));
-
-            objectMetadataPacket->addItem(objectMetadata.get());
+            packetIt->second->addItem(objectMetadata.get());
         }
     }
 
     for (const auto& entry: objectMetadataPacketByTimestamp)
-        result.push_back(entry.second);
+        outMetadataPackets->push_back(entry.second);
 
     for (const auto& bestShotPacket: objectTrackBestShotPackets)
-        result.push_back(bestShotPacket);
+        outMetadataPackets->push_back(bestShotPacket);
 
-    return result;
+    if (isAllocated)
+        reportMetadataAllocations();
 }
 
-Uuid DeviceAgent::obtainObjectTrackIdFromRef(const std::string& objectTrackIdRef)
+void DeviceAgent::reportMetadataAllocations()
+{
+    int64_t allocationCount = m_packetPool.allocationCount();
+    for (const auto& [key, pool]: m_objectMetadataPoolByKind)
+        allocationCount += pool.allocationCount();
+
+    // Silent in the steady state, when all metadata is recycled.
+    if (allocationCount == m_reportedMetadataAllocationCount)
+        return;
+
+    NX_OUTPUT << "Metadata objects and packets allocated so far: " << allocationCount;
+    m_reportedMetadataAllocationCount = allocationCount;
+}
+
+Uuid DeviceAgent::obtainObjectTrackId(const StreamObject& object)
+{
+    Uuid& trackId = m_trackIdBySlot[object.trackSlot];
+    if (trackId.isNull())
+        trackId = obtainObjectTrackIdFromRef(object.trackIdRef);
+    return trackId;
+}
+
+Uuid DeviceAgent::obtainObjectTrackIdFromRef(std::string_view objectTrackIdRef)
 {
     if (const auto it = m_trackIdByRef.find(objectTrackIdRef); it != m_trackIdByRef.cend())
         return it->second;
 
     const auto emplacementResult = m_trackIdByRef.emplace(
-        objectTrackIdRef, UuidHelper::randomUuid());
+        std::string(objectTrackIdRef), UuidHelper::randomUuid());
 
     return emplacementResult.first->second;
 }
@@ -207,9 +288,13 @@ Result<const ISettingsResponse*> DeviceAgent::settingsReceived()
     pushManifest(readFileToString(manifestFilePath));
 
     Issues issues;
-    m_streamInfo = parseObjectStreamFile(streamFilePath, &issues);
-    if (!m_streamInfo.objectsByFrameNumber.empty())
-        m_maxFrameNumber = m_streamInfo.objectsByFrameNumber.rbegin()->first;
+    m_stream = m_engine->streamCache()->load(streamFilePath, &issues);
+    m_objectTypeIds = m_stream ? m_stream->objectTypeIds() : std::set<std::string>();
+    m_trackIdBySlot.assign(m_stream ? m_stream->trackSlotCount() : 0, Uuid());
+    m_objectMetadataPoolByKind.clear(); //< Keyed by the dictionary of the previous stream.
+    m_reportedMetadataAllocationCount = 0;
+    if (m_stream && m_stream->maxFrameNumber() >= 0)
+        m_maxFrameNumber = m_stream->maxFrameNumber();
 
     m_frameNumber = 0;
 
@@ -225,6 +310,13 @@ Result<const ISettingsResponse*> DeviceAgent::settingsReceived()
             m_disabledObjectTypeIds.insert(settingName.substr(kObjectTypeFilterPrefix.length()));
     }
 
+    m_isObjectTypeEnabled.assign(m_stream ? m_stream->objectTypeCount() : 0, true);
+    for (uint32_t i = 0; i < m_isObjectTypeEnabled.size(); ++i)
+    {
+        m_isObjectTypeEnabled[i] = m_disabledObjectTypeIds.find(m_stream->objectTypeId(i))
+            == m_disabledObjectTypeIds.cend();
+    }
+
     return makeSettingsResponse(manifestFilePath, streamFilePath).releasePtr();
 }
 
@@ -252,7 +344,7 @@ Ptr<ISettingsResponse> DeviceAgent::makeSettingsResponse(
     const std::string& streamFilePath) const
 {
     Issues issues;
-    const StreamInfo streamInfo = parseObjectStreamFile(
+    const std::shared_ptr<const BinaryStream> defaultStream = m_engine->streamCache()->load(
         defaultStreamFilePath(m_pluginHomeDir),
         &issues);
 
@@ -262,10 +354,10 @@ Ptr<ISettingsResponse> DeviceAgent::makeSettingsResponse(
         defaultManifestFilePath(m_pluginHomeDir),
         defaultStreamFilePath(m_pluginHomeDir),
         m_pluginHomeDir,
-        streamInfo.objectTypeIds);
+        defaultStream ? defaultStream->objectTypeIds() : std::set<std::string>());
 
     std::map<std::string, std::string> values;
-    for (const std::string& objectTypeId: m_streamInfo.objectTypeIds)
+    for (const std::string& objectTypeId: m_objectTypeIds)
     {
         values[makeObjectTypeFilterSettingName(objectTypeId)] =
             m_disabledObjectTypeIds.find(objectTypeId) == m_disabledObjectTypeIds.cend()
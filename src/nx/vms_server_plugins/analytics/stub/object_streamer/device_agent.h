@@ -2,12 +2,23 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
 #include <set>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <nx/kit/json.h>
 #include <nx/sdk/analytics/helpers/consuming_device_agent.h>
+#include <nx/sdk/analytics/helpers/object_metadata.h>
+#include <nx/sdk/analytics/helpers/object_metadata_packet.h>
 #include <nx/sdk/analytics/i_object_metadata_packet.h>
 
+#include "../recycling_pool.h"
+#include "binary_stream.h"
+#include "engine.h"
 #include "stream_parser.h"
 
 namespace nx {
@@ -19,7 +30,7 @@ namespace object_streamer {
 class DeviceAgent: public nx::sdk::analytics::ConsumingDeviceAgent
 {
 public:
-    DeviceAgent(const nx::sdk::IDeviceInfo* deviceInfo, std::string pluginHomeDir);
+    DeviceAgent(Engine* engine, const nx::sdk::IDeviceInfo* deviceInfo, std::string pluginHomeDir);
     virtual ~DeviceAgent() override;
 
 protected:
@@ -35,12 +46,16 @@ protected:
     virtual nx::sdk::Result<const nx::sdk::ISettingsResponse*> settingsReceived() override;
 
 private:
-    std::vector<nx::sdk::Ptr<nx::sdk::analytics::IMetadataPacket>> generateMetadata(
+    void generateMetadata(
         int frameNumber,
         int64_t frameTimestampUs,
-        int64_t durationUs);
+        int64_t durationUs,
+        std::vector<nx::sdk::Ptr<nx::sdk::analytics::IMetadataPacket>>* outMetadataPackets);
 
-    nx::sdk::Uuid obtainObjectTrackIdFromRef(const std::string& objectTrackIdRef);
+    void reportMetadataAllocations();
+
+    nx::sdk::Uuid obtainObjectTrackId(const StreamObject& object);
+    nx::sdk::Uuid obtainObjectTrackIdFromRef(std::string_view objectTrackIdRef);
 
     sdk::Ptr<sdk::ISettingsResponse> makeSettingsResponse(
         const std::string& manifestFilePath,
@@ -49,15 +64,40 @@ private:
     void reportIssues(const Issues& issues) const;
 
 private:
-    StreamInfo m_streamInfo;
-    std::set<std::string> m_disabledObjectTypeIds;
+    Engine* const m_engine;
+    std::shared_ptr<const BinaryStream> m_stream; //< Shared with other DeviceAgents.
+    std::set<std::string> m_objectTypeIds;
+    std::set<std::string, std::less<>> m_disabledObjectTypeIds;
     int m_frameNumber = 0;
     int m_maxFrameNumber = 0;
-    std::map<std::string, nx::sdk::Uuid> m_trackIdByRef;
+    std::map<std::string, nx::sdk::Uuid, std::less<>> m_trackIdByRef;
+
+    /** Resolved track ids by StreamObject::trackSlot; null until resolved via m_trackIdByRef. */
+    std::vector<nx::sdk::Uuid> m_trackIdBySlot;
+
+    /** By StreamObject::typeIdIndex; compiled from m_disabledObjectTypeIds. */
+    std::vector<bool> m_isObjectTypeEnabled;
 
     int64_t m_lastFrameTimestampUs = -1;
     std::string m_pluginHomeDir;
     bool m_isInitialSettings = true;
+
+    // Reused for every frame.
+    std::vector<nx::sdk::Ptr<nx::sdk::analytics::IMetadataPacket>> m_metadataPackets;
+    std::vector<std::pair<int64_t, nx::sdk::Ptr<nx::sdk::analytics::ObjectMetadataPacket>>>
+        m_objectMetadataPacketByTimestamp;
+
+    RecyclingPool<nx::sdk::analytics::ObjectMetadataPacket> m_packetPool;
+
+    /**
+     * Holds the metadata objects of the regular stream entries for reuse, keyed by the type and
+     * the attribute set of the entries (see metadataPoolKey()), so that their number depends on
+     * the number of distinct entries in a frame rather than on the length of the stream.
+     */
+    std::unordered_map<uint64_t, RecyclingPool<nx::sdk::analytics::ObjectMetadata>>
+        m_objectMetadataPoolByKind;
+
+    int64_t m_reportedMetadataAllocationCount = 0;
 };
 
 } // namespace object_streamer
@@ -32,7 +32,7 @@ Engine::~Engine()
 
 void Engine::doObtainDeviceAgent(Result<IDeviceAgent*>* outResult, const IDeviceInfo* deviceInfo)
 {
-    *outResult = new DeviceAgent(deviceInfo, m_plugin->utilityProvider()->homeDir());
+    *outResult = new DeviceAgent(this, deviceInfo, m_plugin->utilityProvider()->homeDir());
 }
 
 std::string Engine::manifestString() const
@@ -40,7 +40,7 @@ std::string Engine::manifestString() const
     const std::string pluginHomeDir = m_plugin->utilityProvider()->homeDir();
 
     Issues issues;
-    const StreamInfo streamInfo = parseObjectStreamFile(
+    const std::shared_ptr<const BinaryStream> stream = m_streamCache->load(
         defaultStreamFilePath(pluginHomeDir),
         &issues);
 
@@ -50,7 +50,7 @@ std::string Engine::manifestString() const
         defaultManifestFilePath(pluginHomeDir),
         defaultStreamFilePath(pluginHomeDir),
         pluginHomeDir,
-        streamInfo.objectTypeIds);
+        stream ? stream->objectTypeIds() : std::set<std::string>());
 
     return /*suppress newline*/ 1 + (const char*)
 R"json(
@@ -2,9 +2,12 @@
 
 #pragma once
 
+#include <memory>
+
 #include <nx/sdk/analytics/helpers/engine.h>
 
 #include "plugin.h"
+#include "stream_cache.h"
 #include "stream_parser.h"
 
 namespace nx {
@@ -19,6 +22,8 @@ public:
     Engine(Plugin* plugin);
     virtual ~Engine() override;
 
+    StreamCache* streamCache() const { return m_streamCache.get(); }
+
 protected:
     virtual std::string manifestString() const override;
 
@@ -32,6 +37,7 @@ private:
 
 private:
     Plugin* m_plugin = nullptr;
+    std::unique_ptr<StreamCache> m_streamCache = std::make_unique<StreamCache>();
 };
 
 } // namespace object_streamer
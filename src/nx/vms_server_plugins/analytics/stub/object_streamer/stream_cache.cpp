@@ -0,0 +1,86 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#include "stream_cache.h"
+
+#include <nx/kit/debug.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_streamer {
+
+std::shared_ptr<const BinaryStream> StreamCache::findStream(
+    const std::string& filePath,
+    const FileStatus& fileStatus,
+    const uint64_t* contentHash,
+    Issues* issues)
+{
+    const auto it = m_entries.find(filePath);
+    if (it == m_entries.end())
+        return nullptr;
+
+    Entry& entry = it->second;
+    if (!(entry.fileStatus == fileStatus) && !(contentHash && entry.contentHash == *contentHash))
+        return nullptr;
+
+    std::shared_ptr<const BinaryStream> stream = entry.stream.lock();
+    if (!stream)
+        return nullptr;
+
+    entry.fileStatus = fileStatus;
+    issues->errors.insert(entry.issues.errors.begin(), entry.issues.errors.end());
+    issues->warnings.insert(entry.issues.warnings.begin(), entry.issues.warnings.end());
+    return stream;
+}
+
+void StreamCache::removeReleasedEntries()
+{
+    for (auto it = m_entries.begin(); it != m_entries.end();)
+    {
+        if (it->second.stream.expired())
+            it = m_entries.erase(it);
+        else
+            ++it;
+    }
+}
+
+std::shared_ptr<const BinaryStream> StreamCache::load(const std::string& filePath, Issues* issues)
+{
+    const FileStatus status = fileStatus(filePath);
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        if (auto stream = findStream(filePath, status, /*contentHash*/ nullptr, issues))
+            return stream;
+    }
+
+    // Not loaded, or the file has changed: compare the content, reading the file without
+    // blocking the loads of the other files.
+    const uint64_t hash = fileContentHash(filePath);
+
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    if (auto stream = findStream(filePath, status, &hash, issues))
+        return stream;
+
+    removeReleasedEntries();
+    if (m_entries.count(filePath) > 0)
+        NX_PRINT << "Object stream file has changed, loading it again: " << filePath;
+
+    Entry entry;
+    entry.fileStatus = status;
+    entry.contentHash = hash;
+    std::shared_ptr<const BinaryStream> stream =
+        loadObjectStream(filePath, StreamSource{status, hash}, &entry.issues);
+    entry.stream = stream;
+
+    issues->errors.insert(entry.issues.errors.begin(), entry.issues.errors.end());
+    issues->warnings.insert(entry.issues.warnings.begin(), entry.issues.warnings.end());
+    m_entries[filePath] = std::move(entry);
+    return stream;
+}
+
+} // namespace object_streamer
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
@@ -0,0 +1,73 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "../utils.h"
+#include "binary_stream.h"
+#include "stream_parser.h"
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+namespace object_streamer {
+
+/**
+ * Streams loaded by loadObjectStream(), shared by all DeviceAgents of the Engine, so that a file
+ * played by many of them is loaded and mapped once.
+ *
+ * An entry is checked by the size and the modification time of the file on every load, which
+ * costs a single stat() call. If they have changed, the content hash of the file is compared as
+ * well, so that a file which has only been touched or rewritten with the same content is not
+ * loaded again. The streams are immutable, so the DeviceAgents keep playing a replaced one until
+ * they load the new one themselves. The cache does not own the streams: an entry is dropped once
+ * the last DeviceAgent playing its stream has released it.
+ *
+ * Thread-safe. Files are hashed outside the lock, but the streams are loaded under it, so that
+ * concurrent loads of the same file result in a single conversion.
+ */
+class StreamCache
+{
+public:
+    /**
+     * @param issues Receives the issues found when the stream was loaded, even if it was loaded
+     *     for an earlier call.
+     * @return Null if the stream cannot be loaded.
+     */
+    std::shared_ptr<const BinaryStream> load(const std::string& filePath, Issues* issues);
+
+private:
+    struct Entry
+    {
+        FileStatus fileStatus;
+        uint64_t contentHash = 0;
+        Issues issues;
+        std::weak_ptr<const BinaryStream> stream;
+    };
+
+    /** Must be called with m_mutex locked. @return Null if there is no valid entry. */
+    std::shared_ptr<const BinaryStream> findStream(
+        const std::string& filePath,
+        const FileStatus& fileStatus,
+        const uint64_t* contentHash,
+        Issues* issues);
+
+    /** Must be called with m_mutex locked. */
+    void removeReleasedEntries();
+
+private:
+    std::mutex m_mutex;
+    std::map<std::string, Entry> m_entries;
+};
+
+} // namespace object_streamer
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
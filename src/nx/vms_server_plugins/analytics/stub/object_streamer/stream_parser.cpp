@@ -317,6 +317,8 @@ std::string issueToString(Issue issue)
             return "Entry type of some Items in the Object stream is invalid";
         case Issue::imageSourceIsNotAString:
             return "Image source of some Items in the Object stream is not a string";
+        case Issue::binaryObjectStreamIsInvalid:
+            return "Binary Object stream is invalid";
         default:
             NX_KIT_ASSERT(false, "Unexpected issue");
             return {};
@@ -59,6 +59,7 @@ enum class Issue
     objectEntryTypeIsNotAString,
     objectEntryTypeIsUnknown,
     imageSourceIsNotAString,
+    binaryObjectStreamIsInvalid,
 };
 
 struct Issues
@@ -0,0 +1,92 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <nx/sdk/ptr.h>
+
+namespace nx {
+namespace vms_server_plugins {
+namespace analytics {
+namespace stub {
+
+/**
+ * Pool of ref-countable SDK objects, e.g. metadata and metadata packets, which are reused once
+ * the Server has released them: an object is free again when the pool holds its only reference.
+ * Thus frames processed in the steady state allocate no new objects.
+ *
+ * The objects are handed out as is; the caller sets all their fields. Not thread-safe, but the
+ * objects themselves may be released from any thread.
+ */
+template<typename T>
+class RecyclingPool
+{
+public:
+    /** @param maxSize Objects allocated beyond this are not kept for reuse. */
+    explicit RecyclingPool(int maxSize = 1024): m_maxSize((size_t) maxSize) {}
+
+    /**
+     * @param create Called to allocate a new object when no pooled one is free.
+     * @param outIsNew Optional; set to whether the object has been just created.
+     */
+    template<typename Create>
+    nx::sdk::Ptr<T> acquire(Create create, bool* outIsNew = nullptr)
+    {
+        // Objects are mostly released in the order they were handed out, so start from the
+        // one after the last acquired.
+        for (size_t i = 0; i < m_objects.size(); ++i)
+        {
+            const size_t index = (m_nextIndex + i) % m_objects.size();
+            if (isFree(m_objects[index].get()))
+            {
+                m_nextIndex = index + 1;
+                if (outIsNew)
+                    *outIsNew = false;
+                return m_objects[index];
+            }
+        }
+
+        ++m_allocationCount;
+        if (outIsNew)
+            *outIsNew = true;
+
+        nx::sdk::Ptr<T> object = create();
+        if (m_objects.size() < m_maxSize)
+            m_objects.push_back(object);
+        return object;
+    }
+
+    /** Calls `function(T*)` for each pooled object which has been released, e.g. to clear it. */
+    template<typename Function>
+    void forEachFree(Function function)
+    {
+        for (const auto& object: m_objects)
+        {
+            if (isFree(object.get()))
+                function(object.get());
+        }
+    }
+
+    /** Number of objects allocated by acquire() so far. */
+    int64_t allocationCount() const { return m_allocationCount; }
+
+private:
+    static bool isFree(const T* object)
+    {
+        object->addRef();
+        return object->releaseRef() == 1;
+    }
+
+private:
+    const size_t m_maxSize;
+    std::vector<nx::sdk::Ptr<T>> m_objects;
+    size_t m_nextIndex = 0;
+    int64_t m_allocationCount = 0;
+};
+
+} // namespace stub
+} // namespace analytics
+} // namespace vms_server_plugins
+} // namespace nx
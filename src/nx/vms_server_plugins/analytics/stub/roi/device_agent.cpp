@@ -7,8 +7,8 @@
 #include <nx/kit/json.h>
 #include <nx/sdk/helpers/settings_response.h>
 
+#include "../logging.h"
 #include "stub_analytics_plugin_roi_ini.h"
-#include "mqtt_publisher.h"
 
 #undef NX_PRINT_PREFIX
 #define NX_PRINT_PREFIX (this->logUtils.printPrefix)
@@ -23,24 +23,27 @@ namespace roi {
 using namespace nx::sdk;
 using namespace nx::sdk::analytics;
 
+static std::string cameraIdWithoutBraces(std::string cameraId)
+{
+    if (!cameraId.empty() && cameraId.front() == '{')
+        cameraId = cameraId.substr(1, cameraId.length() - 2);
+
+    return cameraId;
+}
+
 DeviceAgent::DeviceAgent(Engine* engine, const nx::sdk::IDeviceInfo* deviceInfo):
     ConsumingDeviceAgent(deviceInfo, NX_DEBUG_ENABLE_OUTPUT, engine->plugin()->instanceId()),
     m_engine(engine),
-    m_mqttPublisher(new MqttPublisher())
+    m_cameraId(cameraIdWithoutBraces(deviceInfo->id())),
+    m_geometryStore(engine->figureTypes())
 {
-    NX_PRINT << "ROI DeviceAgent created with MQTT support";
-    // Start MQTT publisher
-    m_mqttPublisher->start();
+    STUB_LOG(LogLevel::info) << "ROI DeviceAgent created with MQTT support";
 }
 
 DeviceAgent::~DeviceAgent()
 {
-    NX_PRINT << "ROI DeviceAgent destroyed";
-    if (m_mqttPublisher)
-    {
-        m_mqttPublisher->stop();
-        m_mqttPublisher.reset();
-    }
+    m_engine->mqttPublisher()->forgetCamera(m_cameraId);
+    STUB_LOG(LogLevel::info) << "ROI DeviceAgent destroyed";
 }
 
 std::string DeviceAgent::manifestString() const
@@ -57,94 +60,81 @@ void DeviceAgent::doSetNeededMetadataTypes(
 {
 }
 
+static nx::kit::Json::array toJson(const GeometryPoint* points, int pointCount)
+{
+    nx::kit::Json::array result;
+    for (int i = 0; i < pointCount; ++i)
+        result.push_back(nx::kit::Json::array{points[i].x, points[i].y});
+    return result;
+}
+
+static const char* toString(GeometrySet::Direction direction)
+{
+    switch (direction)
+    {
+        case GeometrySet::Direction::left: return "left";
+        case GeometrySet::Direction::right: return "right";
+        default: return "absent";
+    }
+}
+
 Result<const ISettingsResponse*> DeviceAgent::settingsReceived()
 {
-    NX_PRINT << "========================================";
-    NX_PRINT << "settingsReceived() called - User changed settings!";
-    
-    // Đọc tất cả settings hiện tại từ VMS
-    std::map<std::string, std::string> allSettings = currentSettings();
-    
-    NX_PRINT << "Total settings received: " << allSettings.size();
-    
-    // Publish
-    if (m_mqttPublisher)
+    STUB_LOG(LogLevel::debug) << "settingsReceived() called - User changed settings!";
+
+    // Other settings do not concern the detector; publish only when the figures change.
+    if (!m_geometryStore.update(currentSettings()))
     {
-        nx::kit::Json::array drawnPolygons;
-        
-        std::vector<std::string> targetPolygons = {"excludedArea.figure"};
-        
-        for (const std::string& polygonName : targetPolygons)
-        {
-            auto it = allSettings.find(polygonName);
-            if (it != allSettings.end() && !it->second.empty())
-            {
-                std::string parseError;
-                nx::kit::Json parsedValue = nx::kit::Json::parse(it->second, parseError);
-                
-                if (parseError.empty() && parsedValue.is_object())
-                {
-                    auto obj = parsedValue.object_items();
-                    
-                    // Kiểm tra figure và points
-                    if (obj.count("figure") > 0 && !obj["figure"].is_null())
-                    {
-                        auto figure = obj["figure"];
-                        if (figure.is_object())
-                        {
-                            auto figureObj = figure.object_items();
-                            if (figureObj.count("points") > 0 && 
-                                figureObj["points"].is_array() &&
-                                !figureObj["points"].array_items().empty())
-                            {
-                                // Polygon
-                                nx::kit::Json::object polygonInfo;
-                                polygonInfo["name"] = polygonName;
-                                polygonInfo["points"] = figureObj["points"];
-                                polygonInfo["color"] = figureObj.count("color") > 0 
-                                    ? figureObj["color"] : nx::kit::Json("#ffffff");
-                                polygonInfo["label"] = obj.count("label") > 0 
-                                    ? obj["label"] : nx::kit::Json("");
-                                polygonInfo["showOnCamera"] = obj.count("showOnCamera") > 0 
-                                    ? obj["showOnCamera"] : nx::kit::Json(false);
-                                
-                                drawnPolygons.push_back(polygonInfo);
-                                
-                                NX_PRINT << "  Found drawn polygon: " << polygonName 
-                                         << " with " << figureObj["points"].array_items().size() 
-                                         << " points";
-                            }
-                        }
-                    }
-                }
-            }
-        }
-        
-        if (!drawnPolygons.empty())
-        {
-            nx::kit::Json::object mqttPayload;
-            mqttPayload["event"] = "polygons_updated";
-            mqttPayload["timestamp"] = std::to_string(
-                std::chrono::system_clock::now().time_since_epoch().count());
-            mqttPayload["polygons"] = drawnPolygons;
-            
-            std::string mqttMessage = nx::kit::Json(mqttPayload).dump();
-            
-            NX_PRINT << "Publishing " << drawnPolygons.size() << " polygon(s) to MQTT";
-            m_mqttPublisher->publishPolygon(mqttMessage);
-        }
-        else
-        {
-            NX_PRINT << "No drawn polygons (testPolygon/excludedArea) - skipping MQTT";
-        }
+        STUB_LOG(LogLevel::debug) << "Figures are unchanged - skipping MQTT";
+        return nullptr;
     }
-    else
+
+    const std::shared_ptr<const GeometrySet> geometry = m_geometryStore.current();
+
+    nx::kit::Json::array polygons;
+    nx::kit::Json::array boxes;
+    nx::kit::Json::array lines;
+    for (const GeometrySet::Figure& figure: geometry->figures())
     {
-        NX_PRINT << "WARNING: MQTT Publisher not initialized!";
+        nx::kit::Json::object figureInfo;
+        figureInfo["name"] = figure.name;
+        figureInfo["points"] = toJson(geometry->points(figure), figure.pointCount);
+        figureInfo["color"] = figure.color.empty() ? "#ffffff" : figure.color;
+        figureInfo["label"] = figure.label;
+        figureInfo["showOnCamera"] = figure.showOnCamera;
+
+        switch (figure.type)
+        {
+            case GeometrySet::FigureType::polygon:
+                polygons.push_back(std::move(figureInfo));
+                break;
+            case GeometrySet::FigureType::box:
+                boxes.push_back(std::move(figureInfo));
+                break;
+            case GeometrySet::FigureType::line:
+                figureInfo["direction"] = toString(figure.direction);
+                lines.push_back(std::move(figureInfo));
+                break;
+        }
+
+        STUB_LOG(LogLevel::debug) << "  Found drawn figure: " << figure.name << " with "
+            << figure.pointCount << " points";
     }
-    
-    NX_PRINT << "========================================";
-    
+
+    nx::kit::Json::object mqttPayload;
+    mqttPayload["event"] = "polygons_updated";
+    mqttPayload["cameraId"] = m_cameraId;
+    mqttPayload["timestamp"] = std::to_string(
+        std::chrono::system_clock::now().time_since_epoch().count());
+    mqttPayload["version"] = (double) geometry->version();
+    mqttPayload["polygons"] = std::move(polygons);
+    mqttPayload["boxes"] = std::move(boxes);
+    mqttPayload["lines"] = std::move(lines);
+
+    STUB_LOG(LogLevel::info) << "Publishing " << geometry->figures().size()
+        << " figure(s) to MQTT";
+    m_engine->mqttPublisher()->publishPolygons(m_cameraId, nx::kit::Json(mqttPayload).dump());
+
     return nullptr;
 }
 
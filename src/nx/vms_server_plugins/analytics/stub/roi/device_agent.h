@@ -3,11 +3,11 @@
 #pragma once
 
 #include <nx/sdk/analytics/helpers/consuming_device_agent.h>
-#include <memory>
+#include <string>
 
+#include "../geometry_set.h"
 #include "engine.h"
 #include "stub_analytics_plugin_roi_ini.h"
-#include "mqtt_publisher.h"
 
 namespace nx {
 namespace vms_server_plugins {
@@ -39,7 +39,8 @@ protected:
 
 private:
     Engine* const m_engine;
-    std::unique_ptr<MqttPublisher> m_mqttPublisher;
+    const std::string m_cameraId;
+    GeometryStore m_geometryStore;
 };
 
 } // namespace roi
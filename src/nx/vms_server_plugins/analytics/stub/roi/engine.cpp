@@ -2,6 +2,9 @@
 
 #include "engine.h"
 
+#include <nx/kit/json.h>
+#include <nx/kit/utils.h>
+
 #include "device_agent.h"
 #include "device_agent_settings_model.h"
 #include "stub_analytics_plugin_roi_ini.h"
@@ -19,14 +22,34 @@ namespace roi {
 using namespace nx::sdk;
 using namespace nx::sdk::analytics;
 
+static const std::string kMqttBroker = "192.168.1.215";
+static constexpr int kMqttPort = 1883;
+static const std::string kPolygonTopic = "vms/roi/polygon";
+
+static GeometrySet::FigureTypes deviceAgentFigureTypes()
+{
+    std::string error;
+    return GeometrySet::figureTypesFromSettingsModel(
+        nx::kit::Json::parse(kDeviceAgentSettingsModel, error));
+}
+
 Engine::Engine(Plugin* plugin):
     nx::sdk::analytics::Engine(NX_DEBUG_ENABLE_OUTPUT, plugin->instanceId()),
-    m_plugin(plugin)
+    m_plugin(plugin),
+    m_figureTypes(deviceAgentFigureTypes()),
+    m_mqttPublisher(std::make_unique<MqttPublisher>(
+        kMqttBroker,
+        kMqttPort,
+        kPolygonTopic,
+        std::chrono::milliseconds(ini().polygonCoalescingDelayMs)))
 {
+    // Connect once for all cameras; publishing does not wait for the broker.
+    m_mqttPublisher->start();
 }
 
 Engine::~Engine()
 {
+    m_mqttPublisher->stop();
 }
 
 void Engine::doObtainDeviceAgent(Result<IDeviceAgent*>* outResult, const IDeviceInfo* deviceInfo)
@@ -34,6 +57,15 @@ void Engine::doObtainDeviceAgent(Result<IDeviceAgent*>* outResult, const IDevice
     *outResult = new DeviceAgent(this, deviceInfo);
 }
 
+Result<const ISettingsResponse*> Engine::settingsReceived()
+{
+    int logLevel = 0;
+    if (nx::kit::utils::fromString(settingValue(kLogLevelSetting), &logLevel))
+        runtimeLogLevel().set(logLevel);
+
+    return nullptr;
+}
+
 static std::string buildCapabilities()
 {
     std::string capabilities;
@@ -2,9 +2,14 @@
 
 #pragma once
 
+#include <memory>
+
 #include <nx/sdk/analytics/helpers/engine.h>
 #include <nx/sdk/analytics/helpers/plugin.h>
 
+#include "../geometry_set.h"
+#include "mqtt_publisher.h"
+
 namespace nx {
 namespace vms_server_plugins {
 namespace analytics {
@@ -19,9 +24,17 @@ public:
 
     nx::sdk::analytics::Plugin* const plugin() const { return m_plugin; }
 
+    /** Connection shared by all DeviceAgents to publish their polygons. */
+    MqttPublisher* mqttPublisher() const { return m_mqttPublisher.get(); }
+
+    /** Figure settings of the DeviceAgent settings model. */
+    const GeometrySet::FigureTypes& figureTypes() const { return m_figureTypes; }
+
 protected:
     virtual std::string manifestString() const override;
 
+    virtual nx::sdk::Result<const nx::sdk::ISettingsResponse*> settingsReceived() override;
+
 protected:
     virtual void doObtainDeviceAgent(
         nx::sdk::Result<nx::sdk::analytics::IDeviceAgent*>* outResult,
@@ -29,6 +42,8 @@ protected:
 
 private:
     nx::sdk::analytics::Plugin* const m_plugin;
+    const GeometrySet::FigureTypes m_figureTypes;
+    std::unique_ptr<MqttPublisher> m_mqttPublisher;
 };
 
 } // namespace roi
@@ -2,12 +2,12 @@
 
 #include "mqtt_publisher.h"
 
-#include <iostream>
-#include <cstring>
-#include <sys/socket.h>
-#include <arpa/inet.h>
-#include <unistd.h>
-#include <chrono>
+#include <algorithm>
+
+#include <nx/sdk/helpers/uuid_helper.h>
+
+#include "../logging.h"
+#include "stub_analytics_plugin_roi_ini.h"
 
 #undef NX_PRINT_PREFIX
 #define NX_PRINT_PREFIX "[MQTT Publisher] "
@@ -19,253 +19,266 @@ namespace analytics {
 namespace stub {
 namespace roi {
 
+using namespace nx::sdk;
+using namespace std::chrono;
+
+static constexpr milliseconds kInitialRetryDelay{1000};
+static constexpr milliseconds kMaxRetryDelay{60000};
+static constexpr seconds kConnectTimeout{5};
+static constexpr seconds kKeepAliveInterval{20};
+static constexpr milliseconds kDisconnectTimeout{2000};
+static constexpr int kQos = 1; //< Polygons change rarely; those lost are resent on reconnect.
+
+void MqttPublisher::Callback::connection_lost(const std::string& cause)
+{
+    STUB_LOG(LogLevel::warning) << "Connection lost: " << cause;
+    m_publisher->handleDisconnection();
+}
+
+void MqttPublisher::ConnectListener::on_failure(const mqtt::token& token)
+{
+    STUB_LOG(LogLevel::warning) << "Connect failed, return code " << token.get_return_code();
+    m_publisher->handleDisconnection();
+}
+
+void MqttPublisher::ConnectListener::on_success(const mqtt::token& /*token*/)
+{
+    STUB_LOG(LogLevel::info) << "Connected to " << m_publisher->m_broker << ":"
+        << m_publisher->m_port;
+
+    {
+        std::lock_guard<std::mutex> lock(m_publisher->m_mutex);
+        if (m_publisher->m_terminated) //< stop() has sent the queue already.
+            return;
+
+        m_publisher->m_isConnected = true;
+        m_publisher->m_isConnecting = false;
+        m_publisher->m_retryDelay = kInitialRetryDelay;
+
+        // Whatever was in flight when the connection dropped is gone with the clean session, so
+        // resend the latest polygons of every camera, unless newer ones are queued already.
+        MessageByCameraId& queue = m_publisher->m_queuedMessageByCameraId;
+        if (queue.empty() && !m_publisher->m_lastMessageByCameraId.empty())
+            m_publisher->m_firstQueuedTime = steady_clock::now();
+        for (const auto& entry: m_publisher->m_lastMessageByCameraId)
+            queue.emplace(entry.first, entry.second);
+    }
+    m_publisher->m_condition.notify_all();
+}
+
 MqttPublisher::MqttPublisher(
     const std::string& broker,
     int port,
-    const std::string& topic)
+    const std::string& topic,
+    milliseconds coalescingDelay)
     : m_broker(broker)
     , m_port(port)
     , m_topic(topic)
+    , m_coalescingDelay(coalescingDelay)
+    , m_retryDelay(kInitialRetryDelay)
 {
-    NX_PRINT << "MQTT Publisher created (broker: " << m_broker 
-             << ":" << m_port << ", topic: " << m_topic << ")";
+    STUB_LOG(LogLevel::info) << "Created (broker: " << m_broker << ":" << m_port
+        << ", topic: " << m_topic << ")";
+
+    // One client per Engine, so the client ID only has to be unique among plugin instances.
+    const std::string serverAddress = "tcp://" + m_broker + ":" + std::to_string(m_port);
+    std::string clientId = "vms_roi_plugin_" + UuidHelper::toStdString(UuidHelper::randomUuid());
+    clientId.erase(std::remove_if(clientId.begin(), clientId.end(),
+        [](char c) { return c == '{' || c == '}'; }), clientId.end());
+
+    m_client = std::make_shared<mqtt::async_client>(serverAddress, clientId);
+    m_callback = std::make_shared<Callback>(this);
+    m_client->set_callback(*m_callback);
+
+    // Reconnection is done by threadLoop() with backoff.
+    m_connOpts.set_keep_alive_interval(kKeepAliveInterval.count());
+    m_connOpts.set_connect_timeout(kConnectTimeout.count());
+    m_connOpts.set_clean_session(true);
+    m_connOpts.set_automatic_reconnect(false);
 }
 
 MqttPublisher::~MqttPublisher()
 {
     stop();
-    NX_PRINT << "MQTT Publisher destroyed";
+    STUB_LOG(LogLevel::info) << "Destroyed";
 }
 
 void MqttPublisher::start()
 {
-    if (m_running.load())
     {
-        NX_PRINT << "Already running";
-        return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_thread.joinable() || m_terminated)
+            return;
+        m_isConnecting = true;
     }
 
-    m_running.store(true);
-    m_thread = std::thread(&MqttPublisher::workerThread, this);
-    NX_PRINT << "MQTT Publisher started";
+    m_thread = std::thread([this]() { threadLoop(); });
+    connectAsync();
 }
 
 void MqttPublisher::stop()
 {
-    if (!m_running.load())
-        return;
-
-    m_running.store(false);
-    m_queueCondition.notify_all();
-
+    MessageByCameraId messageByCameraId;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_terminated)
+            return;
+        m_terminated = true;
+        messageByCameraId.swap(m_queuedMessageByCameraId);
+    }
+    m_condition.notify_all();
     if (m_thread.joinable())
         m_thread.join();
 
-    NX_PRINT << "MQTT Publisher stopped";
-}
-
-void MqttPublisher::publishPolygon(const std::string& polygonJson)
-{
-    if (!m_running.load())
+    try
     {
-        NX_PRINT << "Publisher not running, starting automatically...";
-        start();
-    }
+        if (m_client && m_client->is_connected())
+        {
+            // The latest edits may still be within the coalescing delay.
+            sendMessages(messageByCameraId);
 
+            STUB_LOG(LogLevel::info) << "Disconnecting...";
+            m_client->disconnect(kDisconnectTimeout.count())->wait_for(
+                kDisconnectTimeout.count());
+        }
+    }
+    catch (const mqtt::exception& exc)
     {
-        std::lock_guard<std::mutex> lock(m_queueMutex);
-        m_messageQueue.push(polygonJson);
+        STUB_LOG(LogLevel::warning) << "Error during disconnect: " << exc.what();
     }
-    m_queueCondition.notify_one();
-
-    NX_PRINT << "Queued polygon data for publishing";
 }
 
-void MqttPublisher::workerThread()
+void MqttPublisher::publishPolygons(const std::string& cameraId, const std::string& message)
 {
-    NX_PRINT << "Worker thread started";
-
-    while (m_running.load())
     {
-        std::string message;
-        
-        {
-            std::unique_lock<std::mutex> lock(m_queueMutex);
-            m_queueCondition.wait(lock, [this] {
-                return !m_messageQueue.empty() || !m_running.load();
-            });
-
-            if (!m_running.load())
-                break;
-
-            if (!m_messageQueue.empty())
-            {
-                message = m_messageQueue.front();
-                m_messageQueue.pop();
-            }
-        }
-
-        if (!message.empty())
-        {
-            publishMessage(message);
-        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queuedMessageByCameraId.empty())
+            m_firstQueuedTime = steady_clock::now();
+        m_queuedMessageByCameraId[cameraId] = message;
+        m_lastMessageByCameraId[cameraId] = message;
     }
+    m_condition.notify_all();
 
-    NX_PRINT << "Worker thread stopped";
+    STUB_LOG(LogLevel::debug) << "Queued polygons of camera " << cameraId;
 }
 
-bool MqttPublisher::connectToBroker()
+void MqttPublisher::forgetCamera(const std::string& cameraId)
 {
-    // TODO: Implement actual MQTT connection
-    // Hiện tại dùng simple socket để demo
-    return true;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lastMessageByCameraId.erase(cameraId);
 }
 
-void MqttPublisher::publishMessage(const std::string& message)
+void MqttPublisher::connectAsync()
 {
     try
     {
-        // Simple TCP socket publish (raw MQTT packet)
-        int sock = socket(AF_INET, SOCK_STREAM, 0);
-        if (sock < 0)
-        {
-            NX_PRINT << "Failed to create socket";
-            return;
-        }
+        m_client->connect(m_connOpts, /*userContext*/ nullptr, m_connectListener);
+    }
+    catch (const mqtt::exception& exc)
+    {
+        STUB_LOG(LogLevel::warning) << "Connect failed: " << exc.what();
+        handleDisconnection();
+    }
+}
 
-        struct sockaddr_in server;
-        server.sin_family = AF_INET;
-        server.sin_port = htons(m_port);
-        
-        if (inet_pton(AF_INET, m_broker.c_str(), &server.sin_addr) <= 0)
-        {
-            NX_PRINT << "Invalid broker address: " << m_broker;
-            close(sock);
+void MqttPublisher::handleDisconnection()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_terminated)
             return;
-        }
 
-        // Set timeout
-        struct timeval timeout;
-        timeout.tv_sec = 2;
-        timeout.tv_usec = 0;
-        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-        setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        STUB_LOG(LogLevel::info) << "Reconnecting in " << m_retryDelay.count() << " ms";
+        m_isConnected = false;
+        m_isConnecting = false;
+        m_retryDeadline = steady_clock::now() + m_retryDelay;
+        m_retryDelay = std::min(m_retryDelay * 2, kMaxRetryDelay);
+    }
+    m_condition.notify_all();
+}
 
-        if (connect(sock, (struct sockaddr*)&server, sizeof(server)) < 0)
+void MqttPublisher::threadLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_terminated)
+    {
+        if (!m_isConnected)
         {
-            NX_PRINT << "Failed to connect to MQTT broker at " << m_broker << ":" << m_port;
-            close(sock);
-            return;
+            if (m_isConnecting)
+            {
+                m_condition.wait(lock);
+            }
+            else if (steady_clock::now() < m_retryDeadline)
+            {
+                m_condition.wait_until(lock, m_retryDeadline);
+            }
+            else
+            {
+                // Never reconnect from paho's callbacks: its threads must not be blocked.
+                m_isConnecting = true;
+                lock.unlock();
+                connectAsync();
+                lock.lock();
+            }
+            continue;
         }
 
-        // Step 1: Send MQTT CONNECT packet
-        std::string connectPacket;
-        connectPacket += (char)0x10; // CONNECT packet type
-        
-        std::string clientId = "vms_roi_plugin";
-        std::string protocolName = "MQTT";
-        
-        // Calculate remaining length for CONNECT
-        int connectPayloadLen = 2 + protocolName.length() + 1 + 1 + 2 + 2 + clientId.length();
-        connectPacket += (char)connectPayloadLen;
-        
-        // Protocol name length + name
-        connectPacket += (char)0x00;
-        connectPacket += (char)0x04;
-        connectPacket += protocolName;
-        
-        // Protocol level (MQTT 3.1.1 = 4)
-        connectPacket += (char)0x04;
-        
-        // Connect flags (clean session)
-        connectPacket += (char)0x02;
-        
-        // Keep alive (60 seconds)
-        connectPacket += (char)0x00;
-        connectPacket += (char)0x3C;
-        
-        // Client ID length + ID
-        connectPacket += (char)((clientId.length() >> 8) & 0xFF);
-        connectPacket += (char)(clientId.length() & 0xFF);
-        connectPacket += clientId;
-        
-        // Send CONNECT
-        send(sock, connectPacket.c_str(), connectPacket.length(), 0);
-        
-        // Wait for CONNACK
-        char connackBuffer[4];
-        ssize_t received = recv(sock, connackBuffer, 4, 0);
-        
-        if (received < 4 || connackBuffer[0] != 0x20)
+        if (m_queuedMessageByCameraId.empty())
         {
-            NX_PRINT << "Failed to receive CONNACK from broker";
-            close(sock);
-            return;
+            m_condition.wait(lock);
+            continue;
         }
-        
-        NX_PRINT << "MQTT CONNACK received - connected to broker";
-
-        // Step 2: Build and send MQTT PUBLISH packet (MQTT 3.1.1)
-        std::string publishPacket;
-        
-        // Fixed header: PUBLISH (QoS 0)
-        publishPacket += (char)0x30;
-        
-        // Remaining length calculation
-        int topicLen = m_topic.length();
-        int payloadLen = message.length();
-        int remainingLength = 2 + topicLen + payloadLen;
-        
-        // Encode remaining length (simple single-byte for small messages)
-        if (remainingLength < 128)
+
+        const auto sendTime = m_firstQueuedTime + m_coalescingDelay;
+        if (steady_clock::now() < sendTime)
         {
-            publishPacket += (char)remainingLength;
+            m_condition.wait_until(lock, sendTime);
+            continue;
         }
-        else
+
+        MessageByCameraId messageByCameraId;
+        messageByCameraId.swap(m_queuedMessageByCameraId);
+        lock.unlock();
+
+        const bool isSent = sendMessages(messageByCameraId);
+
+        lock.lock();
+        if (!isSent && m_isConnected)
         {
-            // Multi-byte encoding
-            int x = remainingLength;
-            do
-            {
-                char encodedByte = x % 128;
-                x = x / 128;
-                if (x > 0)
-                    encodedByte |= 128;
-                publishPacket += encodedByte;
-            } while (x > 0);
+            // Not yet told by paho that the connection is lost; retry with backoff anyway.
+            lock.unlock();
+            handleDisconnection();
+            lock.lock();
         }
-        
-        // Variable header: Topic
-        publishPacket += (char)(topicLen >> 8);
-        publishPacket += (char)(topicLen & 0xFF);
-        publishPacket += m_topic;
-        
-        // Payload
-        publishPacket += message;
-
-        // Send PUBLISH packet
-        ssize_t sent = send(sock, publishPacket.c_str(), publishPacket.length(), 0);
-        
-        if (sent > 0)
+    }
+}
+
+bool MqttPublisher::sendMessages(const MessageByCameraId& messageByCameraId)
+{
+    for (auto it = messageByCameraId.begin(); it != messageByCameraId.end(); ++it)
+    {
+        try
         {
-            NX_PRINT << "Published " << sent << " bytes to topic: " << m_topic;
-            NX_PRINT << "Payload: " << message;
+            // Not waiting for the acknowledgement: the messages are pipelined.
+            m_client->publish(mqtt::make_message(
+                m_topic, it->second.data(), it->second.size(), kQos, /*retained*/ false));
+            STUB_LOG(LogLevel::debug) << "Published polygons of camera " << it->first;
+            STUB_LOG(LogLevel::trace) << "Payload: " << it->second;
         }
-        else
+        catch (const mqtt::exception& exc)
         {
-            NX_PRINT << "Failed to send MQTT PUBLISH packet";
+            STUB_LOG_THROTTLED(LogLevel::warning, 1) << "Cannot publish: " << exc.what();
+
+            // Queue the unsent messages again, unless they have been replaced meanwhile.
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_queuedMessageByCameraId.empty())
+                m_firstQueuedTime = steady_clock::now();
+            for (; it != messageByCameraId.end(); ++it)
+                m_queuedMessageByCameraId.emplace(it->first, it->second);
+            return false;
         }
-        
-        // Send DISCONNECT packet
-        char disconnectPacket[2] = {(char)0xE0, 0x00};
-        send(sock, disconnectPacket, 2, 0);
-        
-        close(sock);
-    }
-    catch (const std::exception& e)
-    {
-        NX_PRINT << "Exception in publishMessage: " << e.what();
     }
+    return true;
 }
 
 } // namespace roi
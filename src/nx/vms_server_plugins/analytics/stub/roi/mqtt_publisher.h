@@ -2,12 +2,14 @@
 
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
-#include <atomic>
-#include <mutex>
-#include <condition_variable>
-#include <queue>
+#include <mqtt/async_client.h>
 
 namespace nx {
 namespace vms_server_plugins {
@@ -15,40 +17,102 @@ namespace analytics {
 namespace stub {
 namespace roi {
 
+/**
+ * Single long-lived MQTT connection shared by all DeviceAgents of an Engine, publishing their
+ * polygons to one topic.
+ *
+ * Publishing never blocks the caller: messages are queued per camera, and a newer message of a
+ * camera replaces its queued one. The queue is sent once it has been collecting edits for the
+ * coalescing delay, so dragging polygon vertices produces a single message per camera. Sending
+ * does not wait for the previous messages to be acknowledged, and keep-alive is done by paho.
+ * When the connection is down, the queue waits for a reconnect, retried with exponential backoff.
+ * The session is clean, so the messages in flight when the connection drops are lost; thus after
+ * every reconnect the latest message of each camera is sent again.
+ */
 class MqttPublisher
 {
 public:
     MqttPublisher(
-        const std::string& broker = "192.168.1.215",
-        int port = 1883,
-        const std::string& topic = "vms/roi/polygon");
-    
+        const std::string& broker,
+        int port,
+        const std::string& topic,
+        std::chrono::milliseconds coalescingDelay);
+
     ~MqttPublisher();
 
-    /**
-     * Publish polygon data (non-blocking)
-     * @param polygonJson: JSON string chứa polygon data
-     */
-    void publishPolygon(const std::string& polygonJson);
+    /** Initiates the connection and returns immediately. */
     void start();
+
+    /** Sends the queued messages if connected, then disconnects. */
     void stop();
 
+    /** Queue the polygons of the camera, replacing its queued message if any (thread-safe). */
+    void publishPolygons(const std::string& cameraId, const std::string& message);
+
+    /**
+     * Stop sending the polygons of the camera again on reconnect; its queued message, if any, is
+     * still sent (thread-safe).
+     */
+    void forgetCamera(const std::string& cameraId);
+
 private:
-    void workerThread();
-    bool connectToBroker();
-    void publishMessage(const std::string& message);
+    class Callback: public virtual mqtt::callback
+    {
+    public:
+        explicit Callback(MqttPublisher* publisher): m_publisher(publisher) {}
+
+        void connection_lost(const std::string& cause) override;
+
+    private:
+        MqttPublisher* m_publisher;
+    };
+
+    class ConnectListener: public virtual mqtt::iaction_listener
+    {
+    public:
+        explicit ConnectListener(MqttPublisher* publisher): m_publisher(publisher) {}
+
+        void on_failure(const mqtt::token& token) override;
+        void on_success(const mqtt::token& token) override;
+
+    private:
+        MqttPublisher* m_publisher;
+    };
+
+    using MessageByCameraId = std::map<std::string, std::string>;
+
+    void threadLoop();
+    void connectAsync();
+    void handleDisconnection();
+
+    /** @return False if the connection is down; the unsent messages are queued again. */
+    bool sendMessages(const MessageByCameraId& messageByCameraId);
 
 private:
-    std::string m_broker;
-    int m_port;
-    std::string m_topic;
-    
-    std::atomic<bool> m_running{false};
+    const std::string m_broker;
+    const int m_port;
+    const std::string m_topic;
+    const std::chrono::milliseconds m_coalescingDelay;
+
+    // Declared before m_client, so that they are destroyed after it: paho may call them until
+    // then.
+    std::shared_ptr<Callback> m_callback;
+    ConnectListener m_connectListener{this};
+
+    std::shared_ptr<mqtt::async_client> m_client;
+    mqtt::connect_options m_connOpts;
+
     std::thread m_thread;
-    
-    std::mutex m_queueMutex;
-    std::condition_variable m_queueCondition;
-    std::queue<std::string> m_messageQueue;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_terminated = false;
+    bool m_isConnected = false;
+    bool m_isConnecting = false;
+    std::chrono::steady_clock::time_point m_retryDeadline;
+    std::chrono::milliseconds m_retryDelay;
+    MessageByCameraId m_queuedMessageByCameraId;
+    MessageByCameraId m_lastMessageByCameraId; //< Queued again on reconnect.
+    std::chrono::steady_clock::time_point m_firstQueuedTime; //< Valid if the queue is not empty.
 };
 
 } // namespace roi
@@ -30,7 +30,12 @@ std::string Plugin::manifestString() const
     "name": "Stub, ROI",
     "description": "A plugin for testing and debugging Regions-Of-Interest (ROI).",
     "version": "1.0.0",
-    "vendor": "Plugin vendor"
+    "vendor": "Plugin vendor",
+    "engineSettingsModel":
+    {
+        "type": "Settings",
+        "items": [)json" + logLevelSettingModel(ini().logLevel) + R"json(]
+    }
 }
 )json";
 }
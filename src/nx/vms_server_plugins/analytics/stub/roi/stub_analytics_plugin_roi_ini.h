@@ -5,6 +5,8 @@
 #include <nx/kit/ini_config.h>
 #include <nx/sdk/analytics/helpers/pixel_format.h>
 
+#include "../logging.h"
+
 namespace nx {
 namespace vms_server_plugins {
 namespace analytics {
@@ -17,11 +19,23 @@ struct Ini: public nx::kit::IniConfig
 
     NX_INI_FLAG(0, enableOutput, "");
 
+    NX_INI_INT(3, logLevel,
+        "Messages up to this level are printed: 0 - none, 1 - errors, 2 - warnings, 3 - info,\n"
+        "4 - debug, 5 - trace. Levels above the STUB_LOG_MAX_LEVEL build option are compiled out.\n"
+        "This is the initial level, and the default of the Engine setting which switches it.");
+
     NX_INI_FLAG(0, deviceDependent, "Respective capability in the manifest.");
+
+    NX_INI_INT(200, polygonCoalescingDelayMs,
+        "Polygons edited within this many milliseconds after the first unsent edit are published\n"
+        "as one message per camera, with the latest polygons.");
 };
 
 Ini& ini();
 
+/** Starts from ini().logLevel; switched by the Engine settings. */
+RuntimeLogLevel& runtimeLogLevel();
+
 } // namespace roi
 } // namespace stub
 } // namespace analytics
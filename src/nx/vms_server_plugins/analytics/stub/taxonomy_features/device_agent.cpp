@@ -47,49 +47,58 @@ static Rect generateBoundingBox(int frameIndex, int trackIndex, int trackCount)
 
 Ptr<IMetadataPacket> DeviceAgent::generateObjectMetadataPacket(int64_t frameTimestampUs)
 {
-    auto metadataPacket = makePtr<ObjectMetadataPacket>();
+    // Packets released by the Server drop their objects, so that those can be recycled as well.
+    m_packetPool.forEachFree([](ObjectMetadataPacket* packet) { packet->clear(); });
+    auto metadataPacket = m_packetPool.acquire([]() { return makePtr<ObjectMetadataPacket>(); });
     metadataPacket->setTimestampUs(frameTimestampUs);
 
-    std::vector<Ptr<ObjectMetadata>> objects;
+    std::vector<Ptr<ObjectMetadata>>& objects = m_objects;
+    objects.clear();
 
     if (m_settings.generateInstanceOfBaseObjectType)
-        objects.push_back(generateInstanceOfBaseObjectType());
+        objects.push_back(recycledObject(&generateInstanceOfBaseObjectType));
     if (m_settings.generateInstanceOfDerivedObjectType)
-        objects.push_back(generateInstanceOfDerivedObjectType());
+        objects.push_back(recycledObject(&generateInstanceOfDerivedObjectType));
     if (m_settings.generateInstanceOfDerivedObjectTypeWithOmittedAttributes)
-        objects.push_back(generateInstanceOfDerivedObjectTypeWithOmittedAttributes());
+        objects.push_back(
+            recycledObject(&generateInstanceOfDerivedObjectTypeWithOmittedAttributes));
     if (m_settings.generateInstanceOfHiddenDerivedObjectType)
-        objects.push_back(generateInstanceOfHiddenDerivedObjectType());
+        objects.push_back(recycledObject(&generateInstanceOfHiddenDerivedObjectType));
     if (m_settings. generateInstanceOfHiddenDerivedObjectTypeWithOwnAttributes)
-        objects.push_back(generateInstanceOfHiddenDerivedObjectTypeWithOwnAttributes());
+        objects.push_back(
+            recycledObject(&generateInstanceOfHiddenDerivedObjectTypeWithOwnAttributes));
     if (m_settings.generateInstanceOfDerivedObjectTypeWithUnsupportedBase)
-        objects.push_back(generateInstanceOfDerivedObjectTypeWithUnsupportedBase());
+        objects.push_back(recycledObject(&generateInstanceOfDerivedObjectTypeWithUnsupportedBase));
     if (m_settings.generateInstanceOfObjectTypeWithNumericAttibutes)
-        objects.push_back(generateInstanceOfObjectTypeWithNumericAttibutes());
+        objects.push_back(recycledObject(&generateInstanceOfObjectTypeWithNumericAttibutes));
     if (m_settings. generateInstanceOfObjectTypeWithBooleanAttibutes)
-        objects.push_back(generateInstanceOfObjectTypeWithBooleanAttibutes());
+        objects.push_back(recycledObject(&generateInstanceOfObjectTypeWithBooleanAttibutes));
     if (m_settings.generateInstanceOfObjectTypeWithIcon)
-        objects.push_back(generateInstanceOfObjectTypeWithIcon());
+        objects.push_back(recycledObject(&generateInstanceOfObjectTypeWithIcon));
     if (m_settings. generateInstanceOfObjectTypeInheritedFromBaseTypeLibraryType)
-        objects.push_back(generateInstanceOfObjectTypeInheritedFromBaseTypeLibraryType());
+        objects.push_back(
+            recycledObject(&generateInstanceOfObjectTypeInheritedFromBaseTypeLibraryType));
     if (m_settings.generateInstanceOfObjectTypeUsingBaseTypeLibraryEnumType)
-        objects.push_back(generateInstanceOfObjectTypeUsingBaseTypeLibraryEnumType());
+        objects.push_back(
+            recycledObject(&generateInstanceOfObjectTypeUsingBaseTypeLibraryEnumType));
     if (m_settings.generateInstanceOfObjectTypeUsingBaseTypeLibraryColorType)
-        objects.push_back(generateInstanceOfObjectTypeUsingBaseTypeLibraryColorType());
+        objects.push_back(
+            recycledObject(&generateInstanceOfObjectTypeUsingBaseTypeLibraryColorType));
     if (m_settings.generateInstanceOfObjectTypeUsingBaseTypeLibraryObjectType)
-        objects.push_back(generateInstanceOfObjectTypeUsingBaseTypeLibraryObjectType());
+        objects.push_back(
+            recycledObject(&generateInstanceOfObjectTypeUsingBaseTypeLibraryObjectType));
     if (m_settings.generateInstanceOfOfBaseTypeLibraryObjectType)
-        objects.push_back(generateInstanceOfOfBaseTypeLibraryObjectType());
+        objects.push_back(recycledObject(&generateInstanceOfOfBaseTypeLibraryObjectType));
     if (m_settings.generateInstanceOfObjectTypeDeclaredInEngineManifest)
-        objects.push_back(generateInstanceOfObjectTypeDeclaredInEngineManifest());
+        objects.push_back(recycledObject(&generateInstanceOfObjectTypeDeclaredInEngineManifest));
     if (m_settings.generateInstanceOfLiveOnlyObjectType)
-        objects.push_back(generateInstanceOfLiveOnlyObjectType());
+        objects.push_back(recycledObject(&generateInstanceOfLiveOnlyObjectType));
     if (m_settings.generateInstanceOfNonIndexableObjectType)
-        objects.push_back(generateInstanceOfNonIndexableObjectType());
+        objects.push_back(recycledObject(&generateInstanceOfNonIndexableObjectType));
     if (m_settings.generateInstanceOfExtendedObjectType)
-        objects.push_back(generateInstanceOfExtendedObjectType());
+        objects.push_back(recycledObject(&generateInstanceOfExtendedObjectType));
     if (m_settings.generateInstanceOfObjectTypeWithAttributeList)
-        objects.push_back(generateInstanceOfObjectTypeWithAttributeList());
+        objects.push_back(recycledObject(&generateInstanceOfObjectTypeWithAttributeList));
 
     for (int i = 0; i < (int) objects.size(); ++i)
     {
@@ -99,9 +108,27 @@ Ptr<IMetadataPacket> DeviceAgent::generateObjectMetadataPacket(int64_t frameTime
         metadataPacket->addItem(objects[i].get());
     }
 
+    int64_t allocationCount = m_packetPool.allocationCount();
+    for (const auto& [generator, pool]: m_objectPools)
+        allocationCount += pool.allocationCount();
+    if (allocationCount != m_reportedAllocationCount)
+    {
+        NX_OUTPUT << "Metadata objects and packets allocated so far: " << allocationCount;
+        m_reportedAllocationCount = allocationCount;
+    }
+
     return metadataPacket;
 }
 
+/**
+ * The objects of each type carry constant attributes, so a generated object is reused once the
+ * Server has released it; only its bounding box and track id change from frame to frame.
+ */
+Ptr<ObjectMetadata> DeviceAgent::recycledObject(ObjectGenerator generate)
+{
+    return m_objectPools[generate].acquire(generate);
+}
+
 DeviceAgent::DeviceAgent(Engine* engine, const nx::sdk::IDeviceInfo* deviceInfo):
     ConsumingDeviceAgent(deviceInfo, ini().enableOutput, engine->plugin()->instanceId()),
     m_engine(engine)
@@ -2,9 +2,15 @@
 
 #pragma once
 
+#include <map>
+#include <vector>
+
 #include <nx/sdk/analytics/helpers/consuming_device_agent.h>
+#include <nx/sdk/analytics/helpers/object_metadata.h>
+#include <nx/sdk/analytics/helpers/object_metadata_packet.h>
 #include <nx/sdk/helpers/uuid_helper.h>
 
+#include "../recycling_pool.h"
 #include "engine.h"
 
 namespace nx {
@@ -37,6 +43,9 @@ private:
     nx::sdk::Ptr<nx::sdk::analytics::IMetadataPacket> generateObjectMetadataPacket(
         int64_t frameTimestampUs);
 
+    using ObjectGenerator = nx::sdk::Ptr<nx::sdk::analytics::ObjectMetadata> (*)();
+    nx::sdk::Ptr<nx::sdk::analytics::ObjectMetadata> recycledObject(ObjectGenerator generate);
+
 private:
     struct Settings
     {
@@ -66,6 +75,11 @@ private:
     int m_frameIndex = 0;
     std::vector<nx::sdk::Uuid> m_trackIds;
     Settings m_settings;
+
+    RecyclingPool<nx::sdk::analytics::ObjectMetadataPacket> m_packetPool;
+    std::map<ObjectGenerator, RecyclingPool<nx::sdk::analytics::ObjectMetadata>> m_objectPools;
+    std::vector<nx::sdk::Ptr<nx::sdk::analytics::ObjectMetadata>> m_objects; //< Reused per frame.
+    int64_t m_reportedAllocationCount = 0;
 };
 
 } // namespace taxonomy_features
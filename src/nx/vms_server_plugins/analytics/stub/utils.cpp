@@ -6,6 +6,8 @@
 #include <vector>
 #include <fstream>
 
+#include <sys/stat.h>
+
 namespace nx {
 namespace vms_server_plugins {
 namespace analytics {
@@ -26,11 +28,48 @@ bool startsWith(const std::string& str, const std::string& prefix)
 
 std::vector<char> loadFile(const std::string& path)
 {
-    std::ifstream file(path, std::ios::binary);
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
     if (!file.is_open())
         return {};
 
-    return std::vector<char>(std::istreambuf_iterator<char>(file), {});
+    // Read in a single call rather than with a stream iterator, which goes byte by byte.
+    std::vector<char> result((size_t) std::max((std::streamoff) file.tellg(), (std::streamoff) 0));
+    file.seekg(0);
+    if (!file.read(result.data(), (std::streamsize) result.size()))
+        return {};
+    return result;
+}
+
+FileStatus fileStatus(const std::string& path)
+{
+    FileStatus result;
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0)
+        return result;
+
+    result.size = (int64_t) status.st_size;
+    #if defined(__linux__)
+        result.modificationTimeNs =
+            (int64_t) status.st_mtim.tv_sec * 1'000'000'000 + status.st_mtim.tv_nsec;
+    #else
+        result.modificationTimeNs = (int64_t) status.st_mtime * 1'000'000'000;
+    #endif
+    return result;
+}
+
+uint64_t fileContentHash(const std::string& path)
+{
+    // Read in chunks, so that the file is never held in memory as a whole.
+    uint64_t hash = 14695981039346656037ULL;
+    std::ifstream file(path, std::ios::binary);
+    char buffer[64 * 1024];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+    {
+        const std::streamsize size = file.gcount();
+        for (std::streamsize i = 0; i < size; ++i)
+            hash = (hash ^ (uint8_t) buffer[i]) * 1099511628211ULL;
+    }
+    return hash;
 }
 
 std::string imageFormatFromPath(const std::string& path)
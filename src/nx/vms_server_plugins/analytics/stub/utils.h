@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
@@ -32,6 +33,23 @@ T clamp(const T& value, const T& lowerBound, const T& upperBound)
 
 std::vector<char> loadFile(const std::string& path);
 
+struct FileStatus
+{
+    int64_t size = -1;
+    int64_t modificationTimeNs = -1; //< In whole seconds where the system has no finer times.
+
+    bool operator==(const FileStatus& other) const
+    {
+        return size == other.size && modificationTimeNs == other.modificationTimeNs;
+    }
+};
+
+/** Both fields are -1 if the file cannot be accessed. */
+FileStatus fileStatus(const std::string& path);
+
+/** FNV-1a of the file contents; that of an empty file if it cannot be read. */
+uint64_t fileContentHash(const std::string& path);
+
 std::string imageFormatFromPath(const std::string& path);
 
 bool isHttpOrHttpsUrl(const std::string& path);
@@ -0,0 +1,129 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+/**
+ * Decodes the test vector of scripts/detection_codec.py with decodeBinaryDetections() and checks
+ * that it yields the detections the vector was encoded from, so that the C++ decoder and the
+ * reference encoder cannot drift apart unnoticed.
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include <nx/vms_server_plugins/analytics/stub/object_detection/detection_binary_format.h>
+
+using namespace nx::vms_server_plugins::analytics::stub::object_detection;
+
+/** TEST_VECTOR_HEX from scripts/detection_codec.py, 69 bytes. */
+static const std::string kTestVectorHex =
+    "4e584442010103000200000000401e18240a060006706572736f6e05416c69636503636172"
+    "9a193333cd4c666666e60001070000000080008000400040008002ff08000000";
+
+static constexpr int64_t kTestVectorTimestampUs = 1700000000000000;
+
+/** Values are quantized to 1/65535; allow for the rounding on encoding and the float error. */
+static constexpr double kTolerance = 1.0 / 65535;
+
+struct ExpectedObject
+{
+    std::string label;
+    double confidence;
+    double x;
+    double y;
+    double width;
+    double height;
+    int trackId;
+    std::string name;
+};
+
+/** TEST_VECTOR_DETECTIONS from scripts/detection_codec.py. */
+static const ExpectedObject kExpectedObjects[] = {
+    {"person", 0.9, 0.1, 0.2, 0.3, 0.4, 7, "Alice"},
+    {"car", 0.5, 0.5, 0.5, 0.25, 0.25, 8, ""},
+};
+
+static int g_failureCount = 0;
+
+static void check(bool condition, const std::string& what)
+{
+    if (condition)
+        return;
+
+    std::cout << "FAILED: " << what << std::endl;
+    ++g_failureCount;
+}
+
+static void checkNear(double actual, double expected, const std::string& what)
+{
+    check(std::fabs(actual - expected) <= kTolerance,
+        what + " is " + std::to_string(actual) + ", expected " + std::to_string(expected));
+}
+
+static std::string fromHex(const std::string& hex)
+{
+    std::string result;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2)
+        result += (char) std::stoi(hex.substr(i, 2), nullptr, 16);
+    return result;
+}
+
+static void checkObject(const DetectedObject& actual, const ExpectedObject& expected)
+{
+    const std::string prefix = "object " + std::to_string(expected.trackId) + " ";
+
+    check(actual.label == expected.label, prefix + "label is \"" + actual.label + "\"");
+    check(actual.name == expected.name, prefix + "name is \"" + actual.name + "\"");
+    check(actual.trackId == expected.trackId,
+        prefix + "trackId is " + std::to_string(actual.trackId));
+    checkNear(actual.confidence, expected.confidence, prefix + "confidence");
+    checkNear(actual.x, expected.x, prefix + "x");
+    checkNear(actual.y, expected.y, prefix + "y");
+    checkNear(actual.width, expected.width, prefix + "width");
+    checkNear(actual.height, expected.height, prefix + "height");
+}
+
+int main()
+{
+    const std::string message = fromHex(kTestVectorHex);
+    check(message.size() == 69, "test vector is " + std::to_string(message.size()) + " bytes");
+    check(isBinaryDetectionMessage(message.data(), message.size()),
+        "test vector is not recognized as binary");
+
+    DetectionBatch batch;
+    std::string error;
+    if (!decodeBinaryDetections(message.data(), message.size(), &batch, &error))
+    {
+        std::cout << "FAILED: " << error << std::endl;
+        return 1;
+    }
+
+    check(batch.timestampUs() == kTestVectorTimestampUs,
+        "timestampUs is " + std::to_string(batch.timestampUs()));
+    check(batch.trackEpoch() == 0, "trackEpoch is " + std::to_string(batch.trackEpoch()));
+    check(batch.trace().publishedUs == 0,
+        "publishedUs is " + std::to_string(batch.trace().publishedUs));
+
+    const size_t expectedCount = sizeof(kExpectedObjects) / sizeof(kExpectedObjects[0]);
+    check(batch.size() == expectedCount, "object count is " + std::to_string(batch.size()));
+    for (size_t i = 0; i < batch.size() && i < expectedCount; ++i)
+        checkObject(batch[i], kExpectedObjects[i]);
+
+    // Every truncation must be rejected rather than read past the end.
+    for (size_t size = 0; size < message.size(); ++size)
+    {
+        check(!decodeBinaryDetections(message.data(), size, &batch, &error),
+            "test vector truncated to " + std::to_string(size) + " bytes is accepted");
+    }
+
+    if (g_failureCount > 0)
+    {
+        std::cout << g_failureCount << " checks failed." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Test vector OK (" << message.size() << " bytes)." << std::endl;
+    return 0;
+}
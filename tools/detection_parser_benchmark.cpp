@@ -0,0 +1,196 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+/**
+ * Checks that DetectionParser agrees with parseDetectionsFromJsonTree() on a fixed corpus of
+ * detection messages, and times both parsers on each of them.
+ *
+ * Usage: detection_parser_benchmark [iterations]
+ *
+ * Exits with 1 if the parsers disagree on any message.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <nx/vms_server_plugins/analytics/stub/object_detection/detection_parser.h>
+
+using namespace nx::vms_server_plugins::analytics::stub::object_detection;
+
+static constexpr int kDefaultIterations = 10000;
+
+struct CorpusMessage
+{
+    std::string name;
+    std::string message;
+};
+
+static std::string makeLargeMessage(int detectionCount)
+{
+    std::string result = R"json({"timestampUs": 1700000000000000, "trackEpoch": 3, )json"
+        R"json("publishTimeUs": 1700000000012345, "detections": [)json";
+    for (int i = 0; i < detectionCount; ++i)
+    {
+        if (i > 0)
+            result += ", ";
+        result += R"json({"label": "person", "confidence": 0.)json" + std::to_string(50 + i % 50)
+            + R"json(, "bbox": [0.125, 0.25, 0.0625, 0.5], "trackId": )json" + std::to_string(i)
+            + R"json(, "name": "Person )json" + std::to_string(i) + R"json("})json";
+    }
+    result += "]}";
+    return result;
+}
+
+static std::vector<CorpusMessage> makeCorpus()
+{
+    return {
+        {"typical",
+            R"json({"timestampUs": 1700000000000000, "detections": [)json"
+            R"json({"label": "person", "confidence": 0.9, "bbox": [0.1, 0.2, 0.3, 0.4], )json"
+            R"json("trackId": 7, "name": "Alice"}, )json"
+            R"json({"label": "car", "confidence": 0.5, "bbox": [0.5, 0.5, 0.25, 0.25], )json"
+            R"json("trackId": 8}]})json"},
+        {"traced",
+            R"json({"timestampUs": 1700000000000000, "trackEpoch": 2, )json"
+            R"json("publishTimeUs": 1700000000001000, "detections": []})json"},
+        {"no timestamp", R"json({"detections": [{"label": "dog", "bbox": [0, 0, 1, 1]}]})json"},
+        {"escapes",
+            R"json({"detections": [{"label": "p\"er\\son\/é😀\n", )json"
+            R"json("name": "A\t", "bbox": [0.1, 0.2, 0.3, 0.4]}]})json"},
+        {"number forms",
+            R"json({"timestampUs": 1.7e15, "detections": [{"confidence": -0.0, )json"
+            R"json("bbox": [1E-3, 2e+0, 0.5e1, 100], "trackId": 2147483647}]})json"},
+        {"unknown fields",
+            R"json({"camera": {"id": [1, {"a": null}], "ok": true}, "detections": [)json"
+            R"json({"extra": [[], {}], "label": "bike", "bbox": [0.1, 0.1, 0.1, 0.1], )json"
+            R"json("score": false}], "tail": "x"})json"},
+        {"wrong types",
+            R"json({"timestampUs": "now", "trackEpoch": null, "detections": [)json"
+            R"json({"label": 5, "confidence": "high", "trackId": "7", "name": [], )json"
+            R"json("bbox": [0.1, 0.2, 0.3, 0.4]}]})json"},
+        {"bad detections",
+            R"json({"detections": [1, "x", null, {"label": "a", "bbox": [0.1, 0.2, 0.3]}, )json"
+            R"json({"label": "b"}, {"label": "c", "bbox": {"x": 1}}, )json"
+            R"json({"label": "d", "bbox": [0.1, "y", 0.3, 0.4, 0.5]}]})json"},
+        {"duplicate keys",
+            R"json({"detections": [{"label": "a", "label": "b", "bbox": [0, 0, 1, 1]}], )json"
+            R"json("detections": []})json"},
+        {"whitespace", " \t\r\n{ \"detections\" :\n[ ]\n} \n"},
+        {"no detections", R"json({"objects": []})json"},
+        {"detections not array", R"json({"detections": {}})json"},
+        {"root not object", R"json([{"detections": []}])json"},
+        {"empty", ""},
+        {"truncated", R"json({"detections": [{"label": "person", "bbox": [0.1, 0.2)json"},
+        {"trailing garbage", R"json({"detections": []} x)json"},
+        {"trailing comma", R"json({"detections": [1, 2,]})json"},
+        {"bad escape", R"json({"detections": [{"label": "\x"}]})json"},
+        {"bad number", R"json({"detections": [{"confidence": 01}]})json"},
+        {"bad literal", R"json({"detections": [tru]})json"},
+        {"too deep", std::string(300, '[') + std::string(300, ']')},
+        {"large", makeLargeMessage(200)},
+    };
+}
+
+static bool isSameObject(const DetectedObject& a, const DetectedObject& b)
+{
+    return a.label == b.label && a.confidence == b.confidence
+        && a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height
+        && a.trackId == b.trackId && a.name == b.name;
+}
+
+static bool isSameBatch(const DetectionBatch& a, const DetectionBatch& b)
+{
+    if (a.size() != b.size()
+        || a.timestampUs() != b.timestampUs()
+        || a.trackEpoch() != b.trackEpoch()
+        || a.trace().publishedUs != b.trace().publishedUs)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (!isSameObject(a[i], b[i]))
+            return false;
+    }
+    return true;
+}
+
+/** @return Whether both parsers give the same result. */
+static bool checkAndMeasure(const CorpusMessage& corpusMessage, int iterations)
+{
+    using namespace std::chrono;
+
+    const std::string& message = corpusMessage.message;
+
+    DetectionParser parser;
+    DetectionBatch streamingBatch;
+    DetectionBatch jsonTreeBatch;
+    std::string streamingError;
+    std::string jsonTreeError;
+    bool streamingResult = false;
+    bool jsonTreeResult = false;
+
+    const auto streamingStart = steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        streamingResult = parser.parse(
+            message.data(), message.size(), &streamingBatch, &streamingError);
+    }
+    const auto streamingDuration = steady_clock::now() - streamingStart;
+
+    const auto jsonTreeStart = steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        jsonTreeResult = parseDetectionsFromJsonTree(message, &jsonTreeBatch, &jsonTreeError);
+    const auto jsonTreeDuration = steady_clock::now() - jsonTreeStart;
+
+    const bool isSameResult = streamingResult == jsonTreeResult
+        && (!streamingResult || isSameBatch(streamingBatch, jsonTreeBatch));
+
+    const auto streamingNs = duration_cast<nanoseconds>(streamingDuration).count() / iterations;
+    const auto jsonTreeNs = duration_cast<nanoseconds>(jsonTreeDuration).count() / iterations;
+
+    std::cout << corpusMessage.name << ", " << message.size() << " bytes, "
+        << (jsonTreeResult ? "accepted" : "rejected") << ": "
+        << "streaming parser " << streamingNs << " ns, "
+        << "nx::kit::Json " << jsonTreeNs << " ns, "
+        << "speedup x" << (streamingNs > 0 ? (double) jsonTreeNs / streamingNs : 0.0)
+        << std::endl;
+
+    if (!isSameResult)
+    {
+        std::cout << "    RESULTS DIFFER; streaming parser: "
+            << (streamingResult ? "accepted" : streamingError) << "; nx::kit::Json: "
+            << (jsonTreeResult ? "accepted" : jsonTreeError) << std::endl;
+    }
+
+    return isSameResult;
+}
+
+int main(int argc, const char* argv[])
+{
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : kDefaultIterations;
+    if (iterations <= 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [iterations]" << std::endl;
+        return 2;
+    }
+
+    int mismatchCount = 0;
+    for (const auto& corpusMessage : makeCorpus())
+    {
+        if (!checkAndMeasure(corpusMessage, iterations))
+            ++mismatchCount;
+    }
+
+    if (mismatchCount > 0)
+    {
+        std::cout << mismatchCount << " messages are parsed differently." << std::endl;
+        return 1;
+    }
+
+    std::cout << "The parsers agree on all messages." << std::endl;
+    return 0;
+}
@@ -0,0 +1,52 @@
+// Copyright 2018-present Network Optix, Inc. Licensed under MPL 2.0: www.mozilla.org/MPL/2.0/
+
+/**
+ * Converts an Object stream file from JSON to the binary format with convertObjectStreamFile(),
+ * e.g. to convert a long stream in advance rather than on its first load by the plugin. By
+ * default, the result is written next to the JSON file, where the plugin finds it.
+ *
+ * Usage: object_stream_converter <stream.json> [<output file>]
+ *
+ * Exits with 1 if the stream has errors or the result cannot be written.
+ */
+
+#include <iostream>
+#include <set>
+#include <string>
+
+#include <nx/vms_server_plugins/analytics/stub/object_streamer/binary_stream.h>
+#include <nx/vms_server_plugins/analytics/stub/object_streamer/constants.h>
+
+using namespace nx::vms_server_plugins::analytics::stub::object_streamer;
+
+static void printIssues(const std::set<Issue>& issues, const std::string& severity)
+{
+    for (const Issue issue: issues)
+        std::cout << severity << ": " << issueToString(issue) << std::endl;
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <stream.json> [<output file>]" << std::endl;
+        return 2;
+    }
+
+    const std::string jsonFilePath = argv[1];
+    const std::string binaryFilePath =
+        argc > 2 ? argv[2] : jsonFilePath + kBinaryStreamFileSuffix;
+
+    Issues issues;
+    const bool isConverted = convertObjectStreamFile(jsonFilePath, binaryFilePath, &issues);
+    printIssues(issues.errors, "Error");
+    printIssues(issues.warnings, "Warning");
+    if (!isConverted)
+    {
+        std::cout << "The stream has not been converted." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Written " << binaryFilePath << "." << std::endl;
+    return 0;
+}